@@ -1,6 +1,6 @@
 #pragma once
 
-#define NETWORK_PROTOCOL_VERSION (2u)
+#define NETWORK_PROTOCOL_VERSION (4u)
 
 #define DEFAULT_PORT (55555)
 #define DEFAULT_HOST "localhost"
@@ -8,9 +8,28 @@
 // in Hz
 #define SERVER_REFRESH_RATE (2)
 
+// How often rated rounds are written to the ratings file, and on exit
+#define SERVER_RATINGS_FLUSH_SECONDS (10)
+
+// Players a server remembers, a power of two, see skat/player_directory.h
+#define SERVER_PLAYER_DIRECTORY_CAPACITY (1u << 16)
+
 // in Hz
 #define CLIENT_REFRESH_RATE (2)
 
+// Computer players, see skat/bot.h
+#define BOT_DEFAULT_THREADS     (1)
+#define BOT_DEFAULT_MOVE_MILLIS (2000)
+#define BOT_DEFAULT_EVAL_STICHE (4)
+#define SERVER_BOT_NAME         "Bot %d"// numbered from 1
+#define SUGGEST_DEFAULT_MILLIS  (5000)
+#define TOURNAMENT_MOVE_MILLIS  (100)// a series is many thousand moves
+#define SUGGEST_LINES           (5)
+
+// Ending rounds with a decided outcome, see skat/claim.h
+#define SERVER_CLAIM_TT_BITS   (16)
+#define SERVER_CLAIM_MAX_NODES (100000)// per search
+
 #define CONSOLE_INPUT           1
 #define DISTRIBUTE_SORTED_CARDS 0
 
@@ -24,7 +24,7 @@
   #define ACTION_HDR_TABLE_BEGIN typedef enum {
   #define FIRST_ACTION(x) ACTION_ ## x = 0
   #define ACTION(x) ACTION_ ## x
-  #define ACTION_HDR_TABLE_END } action_type;
+  #define ACTION_HDR_TABLE_END , ACTION_TYPE_COUNT } action_type;
 #endif
 
 
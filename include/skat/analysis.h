@@ -0,0 +1,54 @@
+#pragma once
+
+#include "skat/archive.h"
+#include "skat/rng.h"
+#include "skat/solver.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Post game analysis of archived rounds: every card a player chose (forced
+// cards are no choice) is compared with the best card at that point.
+//  - perfect: with every hand known, by the double dummy solver
+//  - sampled: with only what the player had seen, averaged over deals of the
+//    unseen cards as the bot plays
+// Losses are what the player's side gave away against the best card: card
+// points at the end of the game, for Null games the chance of winning it.
+// Ramsch rounds are skipped.
+
+#define ANALYSIS_TT_BITS        (18)
+#define ANALYSIS_DEFAULT_SAMPLES (8)
+#define ANALYSIS_MAX_THREADS     (64)
+
+typedef struct analysis_config {
+  int threads;
+  uint32_t samples;// per decision, 0: perfect information only
+  uint64_t seed;   // rounds are sampled alike however many threads run
+} analysis_config;
+
+typedef struct analysis_move {
+  uint8_t index;// into the cards of the round
+  int ap;       // who played it
+  card_id played;
+  card_id best;
+  int loss;
+  card_id best_sampled;
+  double loss_sampled;
+} analysis_move;
+
+typedef struct analysis_totals {
+  uint64_t rounds;
+  uint64_t skipped;
+  uint64_t moves;
+  int64_t loss;
+  double loss_sampled;
+} analysis_totals;
+
+// Returns 0 with *length = 0 for rounds that are not analyzed
+int analysis_round(solver *sv, rng *r, uint32_t samples,
+				   const archive_round *ar, analysis_move *moves,
+				   uint8_t *length);
+// Reads archived rounds from in and writes a line per move to out as soon as
+// its round is done, so rounds may come out of order. Memory does not grow
+// with the number of rounds.
+int analysis_run(FILE *in, FILE *out, const analysis_config *conf,
+				 analysis_totals *totals);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "skat/card.h"
+#include "skat/card_collection.h"
+#include "skat/deal.h"
+#include "skat/game_rules.h"
+#include "skat/player.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Finished rounds as written by the server, one line each with tab separated
+// fields:
+//   deal  game  alleinspieler  skat  cards  name  name  name
+//
+// The deal is in text form as in deal files. The game is 'c' and the trumpf
+// (1: Karo to 4: Kreuz), 'g', 'n' or 'r', followed by 'h' (hand),
+// 's' (Schneider angesagt), 'z' (Schwarz angesagt) and 'o' (ouvert) as
+// called, then the reizwert in decimal (missing in older archives). The
+// alleinspieler is an active player, '-' in Ramsch. The skat
+// holds the two cards left at the end of the round, the cards are the ones
+// played in order. Both use one deal text digit per card index, and a
+// claimed round has fewer than 30 cards. Names are by active player.
+
+#define ARCHIVE_CARDS (30)
+
+typedef struct archive_round {
+  deal d;// as dealt
+  game_rules gr;
+  int alleinspieler;  // active player, -1 in Ramsch
+  card_collection skat;// at the end of the round
+  card_id cards[ARCHIVE_CARDS];
+  uint8_t length;
+  char names[3][PLAYER_MAX_NAME_LENGTH + 1];// by active player
+  uint16_t reizwert;                        // 0 if not archived
+} archive_round;
+
+int archive_write(FILE *f, const archive_round *ar);
+// line may end with a line break
+int archive_parse(const char *line, archive_round *ar);
+// Whether the alleinspieler won, from the cards. A claimed round is played
+// out with the first legal card of every hand like the server does. Without
+// a reizwert an overbid game counts as won. Fails in Ramsch.
+int archive_round_won(const archive_round *ar, int *won);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "skat/card_collection.h"
+#include "skat/game_rules.h"
+#include "skat/hand_eval.h"
+#include "skat/rng.h"
+#include "skat/solver.h"
+#include "skat/thread_pool.h"
+#include <pthread.h>
+#include <stdint.h>
+
+// How high a hand is worth bidding. Every plausible game is tried as Hand
+// game and after taking the skat (pressing by hand_eval_press) on sampled
+// deals of the unseen cards, and the double dummy solver decides whether it
+// is won. Until there are enough samples the win rate leans on
+// hand_eval_margin, so an answer without sampling is always at hand.
+//
+// Results are cached by seat and the canonical form of the hand (see
+// canonical.h): a bidding asks many times about the same hand, only the
+// first question has to wait for samples, and hands that differ by
+// exchanging colors share them.
+
+#define BID_ADVISOR_OPTIONS     (2 * HAND_EVAL_GAMES)// Hand games first
+#define BID_ADVISOR_MAX_SAMPLES (256)// deals per hand, then questions are free
+#define BID_ADVISOR_CACHE_BITS  (12)
+
+typedef struct bid_advice {
+  game_rules gr;
+  uint16_t value;// won without schneider
+  uint32_t samples;
+  uint32_t wins;
+  double win_rate;
+} bid_advice;
+
+typedef struct bid_advisor_entry {
+  uint64_t key;// 0: empty
+  uint32_t deals;
+  uint16_t samples[BID_ADVISOR_OPTIONS];
+  uint16_t wins[BID_ADVISOR_OPTIONS];
+} bid_advisor_entry;
+
+typedef struct bid_advisor {
+  thread_pool *tp;
+  solver *solvers;// one per thread of tp
+  rng r;
+  pthread_mutex_t lock;
+  bid_advisor_entry *cache;
+  uint64_t cache_mask;
+} bid_advisor;
+
+int bid_advisor_init(bid_advisor *ba, thread_pool *tp, solver *solvers,
+					 uint8_t cache_bits, uint64_t seed);
+void bid_advisor_free(bid_advisor *ba);
+
+// position: active player index of the bidder, 0 leads the first stich.
+// Samples for at most millis, 0 answers from the cache. *reizwert is the
+// highest game value worth playing, 0 to pass.
+int bid_advisor_query(bid_advisor *ba, card_collection hand, int position,
+					  uint64_t millis, bid_advice advice[BID_ADVISOR_OPTIONS],
+					  uint16_t *reizwert);
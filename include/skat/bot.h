@@ -0,0 +1,64 @@
+#pragma once
+
+#include "skat/action.h"
+#include "skat/bid_advisor.h"
+#include "skat/card_collection.h"
+#include "skat/event.h"
+#include "skat/press_optimizer.h"
+#include "skat/rng.h"
+#include "skat/skat.h"
+#include "skat/solver.h"
+#include "skat/tablebase.h"
+#include "skat/thread_pool.h"
+#include <stdint.h>
+
+// Computer player for one seat.
+//
+// Bidding follows the bid advisor, the press and the game after taking the
+// skat the press optimizer. The skat stays untouched if the bid advisor
+// expects the best Hand game to score more than the best game with it. Cards
+// are chosen by perfect information Monte Carlo: deals of the unseen cards
+// consistent with the play so far are sampled, and every legal card is
+// scored by the double dummy solver on each sample. Samples are spread over
+// a thread pool until the time budget of the move is used up. With
+// eval_stiche the solver only searches that many stiche of each sample and
+// estimates the rest, trading exact values for many more samples. Searches
+// end where the tablebases of the config take over.
+//
+// The bot only produces actions, sending them is up to the caller.
+
+#define BOT_TT_BITS (18)
+
+typedef struct bot_config {
+  int threads;
+  uint64_t move_millis;
+  uint32_t max_samples;// 0: sample until move_millis are used up
+  uint64_t seed;       // 0: seed randomly
+  uint8_t eval_stiche; // 0: every sample is solved to the end
+  const eval_weights *eval;// NULL: eval_default_weights
+  const tablebase *tablebases;// probed by every solver of the bot
+  size_t tablebases_length;
+} bot_config;
+
+typedef struct bot {
+  bot_config conf;
+  thread_pool tp;
+  solver solvers[THREAD_POOL_MAX_THREADS];// one per worker
+  rng r;
+  bid_advisor ba;
+  card_collection bid_hand;// last hand asked about
+  card_collection planned_press;// and the game to call after it
+  game_rules planned_gr;
+} bot;
+
+int bot_init(bot *b, const bot_config *conf);
+void bot_free(bot *b);
+
+// Whether the seat is expected to act in the current state
+int bot_wants_to_act(const skat_client_state *cs, int *result);
+// Returns 0 and fills a (except a->id) if the seat has something to do
+int bot_decide(bot *b, const skat_client_state *cs, action *a);
+// Once the seat took the skat, for the "suggest" command as well
+int bot_rank_presses(bot *b, const skat_client_state *cs, uint64_t millis,
+					 press_option options[PRESS_OPTIMIZER_OPTIONS],
+					 size_t *length);
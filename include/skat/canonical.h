@@ -0,0 +1,32 @@
+#pragma once
+
+#include "skat/card.h"
+#include "skat/card_collection.h"
+#include "skat/game_rules.h"
+#include "skat/solver.h"
+#include <stdint.h>
+
+// Suit symmetry: colors that play alike can be exchanged without changing
+// the value of a hand or position. In Grand these are the four lanes without
+// the Buben (their order depends on the color), in a color game the three
+// non trumpf ones once the trumpf has been moved to Kreuz, and in Null the
+// four whole lanes. The canonical form sorts the exchangeable lanes, so it
+// is the same for every member of a class and caches keyed on it get up to
+// 24 times smaller.
+
+typedef struct canonical_perm {
+  uint8_t lane[4];// where lane i went in the canonical form
+  uint8_t lane_mask;// the part of a lane that moves
+} canonical_perm;
+
+// gr->type and gr->trumpf select the symmetries, the other fields are kept
+int canonical_hand(const game_rules *gr, card_collection hand,
+				   card_collection *canon, canonical_perm *p,
+				   game_rules *canon_gr);
+int canonical_position(const solver_position *pos, solver_position *canon,
+					   canonical_perm *p);
+
+card_collection canonical_apply(const canonical_perm *p, card_collection col);
+card_collection canonical_revert(const canonical_perm *p, card_collection col);
+int canonical_apply_card(const canonical_perm *p, card_id cid, card_id *out);
+int canonical_revert_card(const canonical_perm *p, card_id cid, card_id *out);
@@ -6,6 +6,18 @@
 
 typedef uint32_t card_collection;
 
+// Every card of one type, bit index is the card type plus 8 times the color
+#define CARD_MASK_BUBEN  (0x80808080u)
+#define CARD_MASK_ASS    (0x40404040u)
+#define CARD_MASK_ZEHN   (0x20202020u)
+#define CARD_MASK_KOENIG (0x10101010u)
+#define CARD_MASK_DAME   (0x08080808u)
+
+// The bit of a card in a card_collection, fails for an invalid card
+int card_collection_index_from_id(const card_id *cid, uint8_t *card_index);
+// The card of a bit, 0 (no valid card) if card_index is 32 or more
+card_id card_collection_id_from_index(uint8_t card_index);
+
 int card_collection_contains(const card_collection *, const card_id *, int *);
 int card_collection_add_card(card_collection *, const card_id *);
 int card_collection_add_card_array(card_collection *, const card_id *, size_t);
@@ -16,6 +28,13 @@ int card_collection_get_card_count(const card_collection *, uint8_t *);
 int card_collection_get_card(const card_collection *, const uint8_t *,
 							 card_id *);
 int card_collection_get_score(const card_collection *, unsigned int *);
+unsigned int card_collection_points(card_collection);
 int card_collection_empty(card_collection *);
 int card_collection_fill(card_collection *);
 int card_collection_draw_random(const card_collection *, card_id *);
+
+int card_collection_get_sorted(const card_collection *, card_sort_mode,
+							   const game_rules *, card_id *, uint8_t *);
+int card_collection_get_sort_position(const card_collection *, const card_id *,
+									  card_sort_mode, const game_rules *,
+									  uint8_t *);
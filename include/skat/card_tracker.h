@@ -0,0 +1,36 @@
+#pragma once
+
+#include "skat/card_collection.h"
+#include "skat/event.h"
+#include "skat/sampler.h"
+#include <stdint.h>
+
+// Where the cards a seat has not seen can still be, kept up to date from the
+// events of the round. An event changes a handful of masks, nothing is
+// recomputed from the cards played so far.
+//
+// Places are the three hands by active player and the skat, as in the
+// sampler. A card not seen yet is possible in every place that may hold it,
+// a card in my hand, pressed by me or played in none but my hand.
+
+typedef struct skat_client_state skat_client_state;
+
+typedef struct card_tracker {
+  int me;// active player, -1 while watching
+  card_collection possible[SAMPLER_PLACES];
+  card_collection played[3];// indexed by active player, with the curr stich
+  card_collection voids[3]; // cards an active player cannot hold anymore
+  card_collection skat;     // skat cards we know about
+  uint8_t alleinspieler_points;// won in stiche so far
+  uint8_t alleinspieler_stiche;
+} card_tracker;
+
+void card_tracker_reset(card_tracker *t, int me, card_collection hand);
+// Once e has been applied to cs
+int card_tracker_observe(card_tracker *t, const skat_client_state *cs,
+						 const event *e);
+// Neither in my hand nor played
+card_collection card_tracker_unseen(const card_tracker *t);
+// Deals of the unseen cards, for the places they are possible in
+int card_tracker_sampler(const card_tracker *t, card_collection hand,
+						 sampler *s);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "skat/solver.h"
+
+// Rounds are claimed once their outcome cannot change any more, however the
+// remaining cards are played: won or lost, Schneider, Schwarz, or a Null
+// game the alleinspieler has already lost. Card points beyond that do not
+// count, so the rest of the round needs not be played.
+//
+// Simple point bounds decide most positions, the others take up to four
+// zero window searches over every line of play. Searches that hit the node
+// limit leave the round open.
+
+// Only at the start of a stich. Sets *fixed if the outcome is decided.
+int claim_outcome_fixed(solver *sv, const solver_position *pos,
+						uint64_t max_nodes, int *fixed);
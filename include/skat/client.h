@@ -1,5 +1,6 @@
 #pragma once
 
+#include "skat/bot.h"
 #include "skat/connection.h"
 #include "skat/exec_async.h"
 #include "skat/package.h"
@@ -43,6 +44,9 @@ struct client {
   skat_client_state cs;
   player *pls[4];
   ll_client_action_callback ll_cac;
+  bot *b;// NULL if a human is playing
+  int bot_busy;      // deciding or waiting for the answer to its action
+  int bot_wait_ticks;// after an illegal action
 };
 
 void client_acquire_state_lock(client *c);
@@ -67,4 +71,5 @@ void client_skat_leave(client *, client_action_callback *);
 void client_skat_press(client *, card_id, card_id, client_action_callback *);
 
 void client_init(client *c, char *host, int port, char *name);
+void client_use_bot(client *c, bot *b);
 void client_run(client *c, int resume);
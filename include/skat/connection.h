@@ -51,7 +51,8 @@ CONN_ERROR_HDR_TABLE_BEGIN
   CONN_ERROR(INVALID_PACKAGE_TYPE),
   CONN_ERROR(TOO_MANY_PLAYERS),
   CONN_ERROR(INVALID_JOIN_TIME),
-  CONN_ERROR(DISCONNECTED)
+  CONN_ERROR(DISCONNECTED),
+  CONN_ERROR(PLAYER_DIRECTORY_FULL)
 CONN_ERROR_HDR_TABLE_END
 
 #ifndef CONNECTION_HDR_TO_STRING
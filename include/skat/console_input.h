@@ -66,5 +66,10 @@ typedef struct {
   client_action_callback_hdr hdr;
 } client_play_card_callback_args;
 
+struct client_suggest_args {
+  client *c;
+  uint64_t millis;
+};
+
 void *handle_console_input(void *v);
 void io_handle_event(client *, event *);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "skat/card.h"
+#include "skat/card_collection.h"
+#include "skat/rng.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct deal {
+  card_collection hands[3];// indexed by active player
+  card_collection skat;
+} deal;
+
+// C(32, 10) * C(22, 10) * C(12, 10)
+#define DEAL_RANK_COUNT  (2753294408504640ull)
+#define DEAL_TEXT_LENGTH (11)
+
+int deal_random(deal *d, rng *r);
+int deal_get_skat(const deal *d, card_id skat[2]);
+int deal_is_valid(const deal *d);
+
+int deal_to_rank(const deal *d, uint64_t *rank);
+int deal_from_rank(uint64_t rank, deal *d);
+int deal_to_text(const deal *d, char *str);
+int deal_from_text(const char *str, deal *d);
+// Single digits of deal texts, also used for card indices. Values are 0-31,
+// -1 for characters that are no digit.
+char deal_text_digit(uint8_t value);
+int deal_text_digit_value(char ch);
+
+// Combinatorial (colex) ranking of k-subsets, k <= 10
+uint64_t deal_binomial(int n, int k);
+uint64_t deal_subset_rank(card_collection subset, card_collection from);
+card_collection deal_subset_unrank(uint64_t rank, int k, card_collection from);
+
+int deal_read_file(const char *path, deal **deals, size_t *length);
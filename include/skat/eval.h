@@ -0,0 +1,77 @@
+#pragma once
+
+#include "skat/card_collection.h"
+#include "skat/game_rules.h"
+#include <stdint.h>
+
+// Static estimate of the card points the alleinspieler still takes in a
+// Color or Grand game, from the hands at the start of a stich. A linear
+// model over a few counts of the hands (trumpf, Spitzen, standing cards,
+// points, cards left), so the solver can stop searching a few stiche deep
+// and estimate the rest. Weights are fixed point, an estimate is a dozen
+// popcounts and multiplications.
+//
+// Weights are fitted by least squares to solver values of positions from
+// perfect information self play, see eval_train and skat_tool eval-train.
+// Null games have no estimate, the null solver is fast enough.
+
+#define EVAL_SHIFT (16)// fractional bits of the weights
+#define EVAL_KINDS (2) // color, grand
+
+#define EVAL_TRAIN_GAMES   (2000)
+#define EVAL_TRAIN_TT_BITS (20)
+
+typedef enum eval_feature {
+  EVAL_BIAS,
+  EVAL_TRUMPS,       // held by the alleinspieler
+  EVAL_TRUMPS_AGAINST,// held by the two others
+  EVAL_SPITZEN,      // highest live trumpf held in a row
+  EVAL_SPITZEN_AGAINST,
+  EVAL_STAND,        // highest live cards of the other suits held in a row
+  EVAL_STAND_AGAINST,
+  EVAL_STAND_POINTS,
+  EVAL_POINTS,
+  EVAL_POINTS_AGAINST,
+  EVAL_VOIDS,        // suits the alleinspieler can trumpf
+  EVAL_CARDS,        // per hand
+  EVAL_LEADS,
+  EVAL_FEATURES
+} eval_feature;
+
+typedef struct eval_weights {
+  int32_t w[EVAL_KINDS][EVAL_FEATURES];
+} eval_weights;
+
+extern const eval_weights eval_default_weights;
+
+// What does not change during a search
+typedef struct eval_context {
+  const int32_t *w;
+  card_collection trumpf;
+  int alleinspieler;
+} eval_context;
+
+typedef struct eval_train_config {
+  int threads;
+  uint32_t games;
+  uint64_t seed;
+  uint8_t tt_bits;// of the solver of each thread
+} eval_train_config;
+
+typedef struct eval_train_stats {
+  uint64_t positions[EVAL_KINDS];
+  double rms_error[EVAL_KINDS];// in card points, on the fitted positions
+} eval_train_stats;
+
+int eval_prepare(eval_context *ctx, const eval_weights *ew,
+				 const game_rules *gr, int alleinspieler);
+void eval_features(const eval_context *ctx, const card_collection hands[3],
+				   int leader, int32_t f[EVAL_FEATURES]);
+// Clamped to the points left in the hands
+int eval_estimate(const eval_context *ctx, const card_collection hands[3],
+				  int leader);
+
+int eval_train(const eval_train_config *conf, eval_weights *ew,
+			   eval_train_stats *stats);
+int eval_write_file(const char *path, const eval_weights *ew);
+int eval_read_file(const char *path, eval_weights *ew);
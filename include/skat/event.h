@@ -48,7 +48,8 @@ EVENT_HDR_TABLE_BEGIN
   EVENT(STICH_DONE),
   EVENT(ANNOUNCE_SCORES),
   EVENT(ROUND_DONE),
-  EVENT(GAME_CALLED)
+  EVENT(GAME_CALLED),
+  EVENT(ROUND_CLAIMED)
 EVENT_HDR_TABLE_END
 
 #ifndef EVENT_HDR_TO_STRING
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "skat/card_collection.h"
+#include "skat/game_rules.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Features of many hands for the same game at once, for simulations that
+// look at millions of them. Hands are evaluated 16 (AVX-512) or 8 (AVX2) at
+// a time when the CPU has it, the rest one by one. Only color games and
+// Grand have the trumpf these features are about.
+
+#define HAND_BATCH_WIDTH (16)// most hands per vector
+
+typedef struct hand_features {
+  uint8_t points;  // card points
+  uint8_t trumpf;  // number of trumpf cards
+  uint8_t strength;// as hand_eval_strength
+  int8_t spitzen;  // > 0: mit, < 0: ohne, as in reizen
+} hand_features;
+
+int hand_batch_evaluate(const game_rules *gr, const card_collection *hands,
+						size_t length, hand_features *features);
+// "avx512", "avx2" or "scalar"
+const char *hand_batch_backend(void);
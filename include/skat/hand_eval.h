@@ -0,0 +1,41 @@
+#pragma once
+
+#include "skat/card_collection.h"
+#include "skat/game_rules.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Quick judgement of a hand without any search, for bidding and pressing.
+// Cards are indexed as in card_collection: lane bit (7 8 9 D K 10 A B) plus
+// 8 times the color.
+
+#define HAND_EVAL_MASK_LANE (0xffu)
+
+// Minimal hand_eval_strength of games worth playing
+#define HAND_EVAL_COLOR_STRENGTH (16)
+#define HAND_EVAL_GRAND_STRENGTH (14)
+
+#define HAND_EVAL_GAMES (6)// the four colors, Grand and Null
+
+extern const uint8_t hand_eval_lane_points[8];
+extern const uint8_t hand_eval_null_rank[8];
+extern const game_rules hand_eval_games[HAND_EVAL_GAMES];
+
+card_collection hand_eval_lane(card_color cc);
+card_collection hand_eval_trumpf_mask(const game_rules *gr);
+
+int hand_eval_strength(card_collection hand, const game_rules *gr);
+int hand_eval_null_margin(card_collection hand);
+// > 0 if the (10 card) hand is strong enough to play gr
+int hand_eval_margin(card_collection hand, const game_rules *gr);
+// hand_eval_margin of many hands, trumpf games are evaluated by hand_batch
+int hand_eval_margins(const game_rules *gr, const card_collection *hands,
+					  size_t length, int *margins);
+// Two cards to press out of the hand with the skat
+card_collection hand_eval_press(card_collection cards, const game_rules *gr);
+// The game to call with the hand with the skat, the most comfortable one
+// that is worth reizwert. With choose_press the skat is chosen for every
+// game, otherwise press is what lies in the skat already.
+void hand_eval_choose_game(card_collection cards, int choose_press,
+						   card_collection press, uint16_t reizwert,
+						   game_rules *gr, card_collection *press_out);
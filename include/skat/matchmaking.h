@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Groups waiting players into tables of three with similar ratings. The
+// ratings are cut into buckets, each bucket keeps its players in join
+// order. A new player first only accepts its own bucket, the longer a
+// player waits the more buckets to both sides it accepts. Every two players
+// at a table are accepted by the one of them who waited longer, so a long
+// waiting player takes a newcomer from any bucket in its window, but two
+// newcomers from different buckets never meet. A heap of the times the next
+// widening is due makes a tick touch only players whose window grows,
+// joining, leaving and widening are O(log n) in the number of waiting
+// players plus a scan of the first two players of every bucket.
+//
+// Entries live in a pool allocated up front, nothing is allocated after
+// matchmaking_init.
+
+#define MATCHMAKING_BUCKET_WIDTH  (100)// rating points
+#define MATCHMAKING_BUCKETS       (40)
+#define MATCHMAKING_WIDEN_MILLIS  (5000)// per bucket to each side
+#define MATCHMAKING_NONE          UINT32_MAX
+#define MATCHMAKING_HISTOGRAM_BINS (24)// powers of two
+
+typedef struct matchmaking_entry {
+  uint32_t player;
+  uint16_t bucket;
+  uint64_t joined;  // millis
+  uint64_t widen_at;// next time the window grows
+  uint32_t prev, next;// in the bucket, in join order
+  uint32_t heap;      // position in the widening heap, NONE when free
+} matchmaking_entry;
+
+// Bin i counts values below 2^i, the first bin counts zeros
+typedef struct matchmaking_histogram {
+  uint64_t counts[MATCHMAKING_HISTOGRAM_BINS];
+} matchmaking_histogram;
+
+typedef struct matchmaking_match {
+  uint32_t players[3];// in join order
+} matchmaking_match;
+
+typedef struct matchmaking {
+  matchmaking_entry *entries;
+  uint32_t *free_entries;
+  uint32_t free_count;
+  uint32_t *heap;// entry indices by widen_at
+  uint32_t waiting;
+  uint32_t capacity;
+  uint32_t head[MATCHMAKING_BUCKETS];
+  uint32_t tail[MATCHMAKING_BUCKETS];
+  uint32_t count[MATCHMAKING_BUCKETS];
+  uint64_t matches;
+  matchmaking_histogram queue_length;// sampled at every join
+  matchmaking_histogram match_millis;// waited by every matched player
+} matchmaking;
+
+int matchmaking_init(matchmaking *mm, uint32_t capacity);
+void matchmaking_free(matchmaking *mm);
+
+// Queues a player, ticket identifies the entry for matchmaking_leave.
+// Returns 0 if the player waits, 1 if it completed a table right away and
+// m is filled, 2 if the queue is full.
+int matchmaking_join(matchmaking *mm, uint32_t player, int rating,
+					 uint64_t now, uint32_t *ticket, matchmaking_match *m);
+int matchmaking_leave(matchmaking *mm, uint32_t ticket);
+// Widens the windows that are due and matches with them, returns the number
+// of tables written to m, at most max
+int matchmaking_tick(matchmaking *mm, uint64_t now, matchmaking_match *m,
+					 int max);
+
+void matchmaking_histogram_add(matchmaking_histogram *h, uint64_t value);
+void matchmaking_histogram_print(const matchmaking_histogram *h,
+								 const char *name, FILE *out);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "skat/card_collection.h"
+
+// Null games decompose by suit. For each of the 4^8 ways to spread one suit
+// over "gone", alleinspieler, left and right opponent (left plays right
+// after the alleinspieler) two tables answer:
+//  - safe: the alleinspieler never takes a stich in this suit, even if the
+//    opponents may lead it whenever they like and drop any of their cards of
+//    it at any time (free discards)
+//  - lost: the opponents force him to take a stich in this suit by leading
+//    it again and again, starting with the given opponent
+// If an opponent is to lead and every suit is safe, the alleinspieler wins.
+// If a suit is lost for the opponent to lead, he loses.
+// Dropping his highest card of a safe suit keeps it safe, so when he cannot
+// follow suit he never spoils another one.
+
+// Returns 0 and sets *alleinspieler_takes if the position is decided at the
+// start of a stich. hands are indexed by active player.
+int null_solver_decide(const card_collection hands[3], int alleinspieler,
+					   int leader, int *alleinspieler_takes);
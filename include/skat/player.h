@@ -1,15 +1,20 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #define PLAYER_MAX_NAME_LENGTH 256
 
 typedef struct {
-  int gupid;// gupid, 0-3
-  int ap;   // active player index, -1 or 0-2
+  int gupid;  // gupid, 0-3
+  int ap;     // active player index, -1 or 0-2
+  uint32_t id;// in the server's player directory, 0 on clients
   size_t name_length;
-  char name[];
+  const char *name;// in its seat on the server, after the player otherwise
 } player;
 
 int player_equals_by_name(const player *p1, const player *p2);
+// One allocation with the name, free with free
 player *create_player(int gupid, int ap, const char *name);
+player *create_player_n(int gupid, int ap, const char *name,
+						size_t name_length);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "skat/player.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Every player a server has seen, by name. Names are interned in the
+// entries, a player keeps its id for as long as it is in the directory. The
+// entries are an open addressing table of fixed capacity in one mapping,
+// backed by a file if the directory should survive restarts, so lookups
+// are a hash and a probe or two and joining never allocates.
+//
+// Once the table is three quarters full, a new name evicts the player seen
+// least recently among PLAYER_DIRECTORY_EVICT_SAMPLES players without a
+// seat, looking on from where the last eviction stopped. Removing shifts
+// later entries back, so entry pointers only hold until the next intern.
+// The slot of every id is kept in a second table after the entries, ids of
+// evicted players are reused.
+//
+// Seats are session state of one server run and are cleared when a file is
+// mapped again; the number of sessions and when a player was last seen are
+// kept. A file is only ever mapped by one server at a time.
+
+#define PLAYER_DIRECTORY_MAGIC   (0x52594c5054414b53ull)// "SKATPLYR"
+#define PLAYER_DIRECTORY_VERSION (2)
+#define PLAYER_DIRECTORY_EVICT_SAMPLES (64)
+#define PLAYER_DIRECTORY_FREE_ID (0x80000000u)// marks unused ids in slots
+
+typedef struct player_directory_entry {
+  uint32_t id;  // 1 to capacity, 0 for a free slot
+  uint32_t hash;
+  uint32_t name_length;
+  int32_t gupid;// seat in this server run, -1 if none
+  uint32_t sessions;// joins and resumes
+  uint32_t reserved;
+  int64_t last_seen;// unix time
+  char name[PLAYER_MAX_NAME_LENGTH];
+} player_directory_entry;
+
+typedef struct player_directory_header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t capacity;// a power of two
+  uint32_t count;
+  uint32_t free_id;// first unused id, 0 if none
+} player_directory_header;
+
+typedef struct player_directory {
+  player_directory_header *header;
+  player_directory_entry *entries;
+  uint32_t *slots;    // by id - 1, or FREE_ID | the next unused id
+  size_t size;        // of the mapping
+  int fd;             // -1 without a file
+  uint32_t evict_next;// slot the next eviction starts at
+} player_directory;
+
+// Maps path, creating it with capacity slots if it does not exist. Without
+// a path the directory only lives in memory.
+int player_directory_open(player_directory *d, const char *path,
+						  uint32_t capacity);
+void player_directory_close(player_directory *d);
+
+// NULL if the name is unknown
+player_directory_entry *player_directory_find(const player_directory *d,
+											  const char *name,
+											  size_t name_length);
+// Adds an unknown name, evicting a stale player if the directory is full.
+// Fails for names that are too long and if every player left has a seat.
+int player_directory_intern(player_directory *d, const char *name,
+							size_t name_length, player_directory_entry **e);
+// NULL if no player has the id
+player_directory_entry *player_directory_get(const player_directory *d,
+											 uint32_t id);
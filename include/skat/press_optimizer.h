@@ -0,0 +1,49 @@
+#pragma once
+
+#include "skat/card_collection.h"
+#include "skat/game_rules.h"
+#include "skat/rng.h"
+#include "skat/solver.h"
+#include "skat/thread_pool.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Ranks what the alleinspieler can do after taking the skat. For every game
+// that is still worth the reizwert, hand evaluation shortlists the presses
+// that leave the best hands. Each option is played by the double dummy
+// solver against the same sampled deals of the two other hands, the score
+// is how often it is won. Between rounds of samples, options clearly worse
+// than the best one are dropped, so the time goes into telling the good ones
+// apart. An option needs PRESS_OPTIMIZER_MIN_RANKED samples before it may
+// rank above the choice of hand_eval_choose_game, the fallback.
+
+#define PRESS_OPTIMIZER_GAMES     (6)// as hand_eval_games
+#define PRESS_OPTIMIZER_SHORTLIST (3)// presses per game
+#define PRESS_OPTIMIZER_OPTIONS \
+  (PRESS_OPTIMIZER_SHORTLIST * PRESS_OPTIMIZER_GAMES)
+#define PRESS_OPTIMIZER_MIN_RANKED (8)
+
+typedef struct press_query {
+  card_collection cards;// the hand with the skat
+  int alleinspieler;    // active player index
+  uint16_t reizwert;
+  uint64_t millis;
+  uint32_t max_samples;// per option, 0: sample until millis are used up
+  uint8_t eval_stiche; // searched in every sample, 0: to the end
+  const eval_weights *eval;// NULL: eval_default_weights
+} press_query;
+
+typedef struct press_option {
+  card_collection press;
+  game_rules gr;
+  uint32_t samples;
+  uint32_t wins;
+  int margin;  // hand_eval_margin of the rest of the hand
+  int fallback;// the choice of hand_eval_choose_game
+} press_option;
+
+// solvers: one for each thread of tp. Options are sorted best first.
+int press_optimize(thread_pool *tp, solver *solvers, rng *r,
+				   const press_query *q,
+				   press_option options[PRESS_OPTIMIZER_OPTIONS],
+				   size_t *length);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "skat/archive.h"
+#include "skat/player.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Elo ratings of players by name. Every game with an alleinspieler is a
+// match of the alleinspieler against the mean rating of the two others,
+// who share the opposite change. New players move faster until they have
+// RATING_NEW_GAMES games. Ramsch does not count.
+//
+// For the leaderboard the players are kept in sorted lists per rating point
+// and a Fenwick tree counts them, best first. The rank of a player is
+// O(log RATING_BINS) plus the players less than a point above it, the top k
+// are O(k log RATING_BINS), and neither ever sorts everyone. Inserting walks
+// the better players of the bin.
+
+#define RATING_INITIAL   (1500)
+#define RATING_BINS      (4096)// leaderboard resolution, one rating point each
+#define RATING_K_NEW     (40)
+#define RATING_K         (20)
+#define RATING_NEW_GAMES (30)
+#define RATING_NONE      UINT32_MAX
+
+typedef struct rating_player {
+  char name[PLAYER_MAX_NAME_LENGTH + 1];
+  double rating;
+  uint32_t games;
+  uint32_t won; // as alleinspieler
+  uint32_t lost;// as alleinspieler
+  uint32_t prev, next;// in its leaderboard bin
+  uint16_t bin;
+} rating_player;
+
+typedef struct rating_table {
+  rating_player *players;
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t *index;// open addressing by name hash
+  uint32_t index_mask;
+  uint32_t head[RATING_BINS];
+  uint32_t tree[RATING_BINS + 1];// by bin from the top
+} rating_table;
+
+int rating_init(rating_table *t);
+void rating_free(rating_table *t);
+
+// Index of the player, RATING_NONE if unknown
+uint32_t rating_find(const rating_table *t, const char *name);
+// Adds an unknown player at RATING_INITIAL
+int rating_find_or_add(rating_table *t, const char *name, uint32_t *index);
+
+// One finished game, names by active player
+int rating_update(rating_table *t, const char *const names[3],
+				  int alleinspieler, int won);
+// Updates from a round of the archive format, Ramsch is skipped
+int rating_update_round(rating_table *t, const archive_round *ar);
+
+// 1 for the best player
+uint32_t rating_rank(const rating_table *t, uint32_t index);
+// Writes the indices of the best k players, returns how many
+uint32_t rating_top(const rating_table *t, uint32_t k, uint32_t *indices);
+
+// Rebuilds every rating from an archive, the rounds are parsed and replayed
+// by threads in batches and applied in archive order. Ramsch is left out,
+// *skipped counts the lines that were no valid round.
+int rating_recompute(rating_table *t, FILE *archive, int threads,
+					 uint64_t *skipped);
+
+// One line per player: name, rating, games, won and lost, tab separated.
+// Written to a temporary file first and renamed over path.
+int rating_write_file(const rating_table *t, const char *path);
+// The same from a copy of the players, so it can be written without the lock
+// that guards the table
+int rating_write_players(const rating_player *players, uint32_t count,
+						 const char *path);
+int rating_read_file(rating_table *t, const char *path);
@@ -1,6 +1,7 @@
 #ifndef REIZEN_HDR
 #define REIZEN_HDR
 
+#include "skat/card_collection.h"
 #include "skat/game_rules.h"
 #include <stdint.h>
 
@@ -40,6 +41,9 @@ REIZ_PHASE_HDR_TABLE_END
 
 extern char *reiz_phase_name_table[];
 
+#define REIZWERT_MIN (18)
+#define REIZWERT_MAX (264)
+
 typedef struct reiz_state {
   reiz_phase rphase;
   int waiting_teller;
@@ -55,6 +59,7 @@ uint16_t reizen_get_game_value(skat_server_state *cs, int won, int schneider,
 							   int schwarz);
 
 int reizen_get_grundwert(game_rules const *gr);
+uint16_t reizen_get_min_game_value(const game_rules *gr, card_collection cards);
 
 typedef enum {
   LOSS_TYPE_INVALID = 0,
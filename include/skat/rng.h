@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+// ChaCha20 based generator, buffered one block (16 words) at a time
+typedef struct rng {
+  uint32_t state[16];
+  uint32_t buf[16];
+  uint8_t buf_pos;
+} rng;
+
+void rng_seed(rng *r, uint64_t seed);
+int rng_seed_random(rng *r);
+rng *rng_thread(void);
+
+uint32_t rng_next_u32(rng *r);
+uint64_t rng_next_u64(rng *r);
+uint32_t rng_bounded_u32(rng *r, uint32_t bound);
+uint64_t rng_bounded_u64(rng *r, uint64_t bound);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "skat/card_collection.h"
+#include "skat/deal.h"
+#include "skat/rng.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Uniformly random deals of the cards still in play that agree with what a
+// seat has observed: cards known to be in a place, cards already played and
+// cards a place cannot hold (a hand that did not follow suit).
+//
+// Cards with the same set of candidate places form a class. sampler_prepare
+// enumerates every split of the class sizes over the room of the places and
+// counts the deals of each split, sampler_draw then picks a split weighted by
+// that count and shuffles the cards of each class into its places. Every
+// consistent deal is drawn with the same probability and nothing is rejected.
+#define SAMPLER_PLACES  (4)// the three hands by active player, then the skat
+#define SAMPLER_SKAT    (3)
+#define SAMPLER_CLASSES (1 << SAMPLER_PLACES)
+
+typedef struct sampler_split {
+  uint64_t deals_end;// deals of this and all previous splits
+  uint8_t counts[SAMPLER_CLASSES][SAMPLER_PLACES];// by class index
+} sampler_split;
+
+typedef struct sampler {
+  card_collection known[SAMPLER_PLACES];
+  card_collection excluded[SAMPLER_PLACES];
+  card_collection played;
+  uint8_t size[SAMPLER_PLACES];// cards still held
+
+  // Filled by sampler_prepare
+  uint8_t class_count;
+  uint8_t class_places[SAMPLER_CLASSES];// bit per place
+  uint8_t class_size[SAMPLER_CLASSES];
+  uint8_t class_cards[SAMPLER_CLASSES][32];
+  sampler_split *splits;
+  size_t split_count;
+  size_t split_capacity;
+  uint64_t deals;
+} sampler;
+
+void sampler_init(sampler *s);
+void sampler_free(sampler *s);
+
+int sampler_set_known(sampler *s, int place, card_collection cards);
+int sampler_set_played(sampler *s, int place, card_collection cards);
+int sampler_set_void(sampler *s, int place, card_collection cards);
+
+// Returns non zero if no deal agrees with the constraints
+int sampler_prepare(sampler *s);
+// Played cards are in no place of the drawn deal
+int sampler_draw(const sampler *s, rng *r, deal *d);
@@ -4,18 +4,32 @@
 #include "skat/ctimer.h"
 #include "skat/package.h"
 #include "skat/player.h"
+#include "skat/player_directory.h"
+#include "skat/server_bots.h"
 #include "skat/skat.h"
 #include <netinet/in.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 
 typedef struct {
   int socket_fd;
   struct sockaddr_in addr;
 } server_listener_args;
 
+// Game state last published by server_tick, readable without the lock
+typedef struct {
+  uint32_t generation;// odd while server_tick mutates the game state
+  game_phase phase;
+  uint16_t reizwert;
+  card_collection hands[4];// indexed by gupid
+} server_snapshot;
+
 typedef struct server {
   int exit;
   pthread_mutex_t lock;
+  pthread_mutex_t ratings_lock;// one writer of the ratings file, before lock
+  struct timespec ratings_due; // next write of the ratings, under lock
   skat_server_state ss;
   ctimer tick_timer;
   pthread_t signal_listener;
@@ -24,8 +38,13 @@ typedef struct server {
   int port;
   int ncons;
   connection_s2c conns[4];
-  player *pls[4];
+  player *pls[4];   // NULL or into seats
+  player seats[4];  // by gupid
+  char seat_names[4][PLAYER_MAX_NAME_LENGTH];// dir moves its entries
+  player_directory dir;
   int playermask;
+  server_bots bots;
+  server_snapshot snap;
 } server;
 
 int server_is_player_active(server *s, int gupid);
@@ -33,9 +52,13 @@ int server_has_player_name(server *s, char *pname);
 connection_s2c *server_get_free_connection(server *, int *);
 connection_s2c *server_get_connection_by_pname(server *s, char *pname, int *n);
 connection_s2c *server_get_connection_by_gupid(server *s, int gupid);
-void server_add_player_for_connection(server *, player *, int gupid);
+// Interns the name and seats the player, fails if no player of the directory
+// can be evicted
+int server_add_player_for_connection(server *, const char *name, int gupid);
 void server_resume_player_for_connection(server *s, int gupid);
 void server_notify_join(server *, int gupid);
+// Before anyone joins, replaces the in memory directory with the file at path
+int server_open_player_directory(server *s, const char *path);
 size_t server_resync_player(server *, player *, payload_resync **);
 
 void server_acquire_state_lock(server *);
@@ -44,9 +67,15 @@ void server_release_state_lock(server *);
 void server_disconnect_connection(server *, connection_s2c *);
 
 void server_tick(server *s);
+int server_prefilter_action(server *s, int gupid, const action *a);
 
 void server_send_event(server *, event *, player *);
 void server_distribute_event(server *, event *, void (*)(event *, player *));
 
 void server_init(server *, int);
 _Noreturn void server_run(server *);
+
+// A table without connections, timer or threads. Only bot seats play at it,
+// driven by server_bots_step on the caller's thread.
+void server_init_headless(server *s);
+void server_free_headless(server *s);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "skat/action.h"
+#include "skat/bot.h"
+#include "skat/event.h"
+#include "skat/exec_async.h"
+#include "skat/skat.h"
+#include <pthread.h>
+
+// Seats of the server played by bots inside the server process. Events are
+// applied to the seat's client state right where they are sent, actions
+// go straight into the server state on the next tick: no socket, no
+// packages. Every seat has a bot of its own, as a bot keeps the plans of
+// its seat between decisions, but one thread decides for all of them.
+//
+// Bots only say ready while no human is seated, so people at the table
+// decide when the next round starts.
+
+typedef struct server_bot_seat {
+  skat_client_state cs;
+  int busy;      // deciding, or the decided action waits for the tick
+  int wait_ticks;// after an illegal action
+  int has_action;
+  action pending;
+} server_bot_seat;
+
+typedef struct server_bots {
+  bot_config conf;
+  bot bots[4];// indexed by gupid, for the seats of botmask
+  int botmask;// seats whose bot is initialized
+  int seatmask;// gupids played by bots
+  server_bot_seat seats[4];// indexed by gupid
+  async_callback_queue acq;
+  pthread_t decider;
+  int started;
+} server_bots;
+
+int server_bots_init(server *s, const bot_config *conf);
+// Seats a bot at the next free seat. Without server_bots_init the seat only
+// acts through server_bots_step.
+int server_bots_add(server *s, const char *name);
+int server_bots_is_seat(const server *s, int gupid);
+// Must be called with the state lock held
+void server_bots_send_event(server *s, int gupid, event *e);
+// Must be called with the state lock held, from server_tick
+void server_bots_tick(server *s);
+// For headless servers: the first seat that wants to act decides with its
+// bot (by gupid) and the action is applied right away. Returns 0 if a seat
+// acted, 1 if none wants to and 2 if a bot failed or acted illegally.
+int server_bots_step(server *s, bot *const bots[4]);
@@ -2,13 +2,18 @@
 #define SKAT_HDR
 
 #include "skat/action.h"
+#include "skat/archive.h"
 #include "skat/card.h"
+#include "skat/card_tracker.h"
 #include "skat/card_collection.h"
+#include "skat/deal.h"
 #include "skat/event.h"
 #include "skat/game_rules.h"
 #include "skat/player.h"
+#include "skat/rating.h"
 #include "skat/reizen.h"
 #include "skat/stich.h"
+#include <stdio.h>
 
 #ifndef STRINGIFY
 #define STRINGIFY_   #x
@@ -29,7 +34,7 @@
   #define GAME_PHASE_HDR_TABLE_BEGIN typedef enum {
   #define FIRST_GAME_PHASE(x) GAME_PHASE_ ## x = 0
   #define GAME_PHASE(x) GAME_PHASE_ ## x
-  #define GAME_PHASE_HDR_TABLE_END } game_phase;
+  #define GAME_PHASE_HDR_TABLE_END , GAME_PHASE_COUNT } game_phase;
 #endif
 
 
@@ -57,6 +62,7 @@ extern char *game_phase_name_table[];
 
 typedef struct server server;
 typedef struct client client;
+typedef struct solver solver;
 
 typedef struct shared_game_state {
   game_phase cgphase;
@@ -82,6 +88,7 @@ typedef struct skat_client_state {
   int my_active_player_index;// active_player
   int my_partner;            // active_player
   int ist_alleinspieler;
+  card_tracker tracker;// where the cards we have not seen can be
 } skat_client_state;
 
 typedef struct skat_server_state {
@@ -95,6 +102,23 @@ typedef struct skat_server_state {
   card_collection *stiche[3];
 
   card_collection stiche_buf[3];// indexed via *stiche (3 weil ramschen)
+
+  rng deal_rng;
+  deal *fixed_deals;// dealt in order, before falling back to deal_rng
+  size_t fixed_deals_length;
+  size_t fixed_deals_next;
+
+  solver *claim_solver;// NULL: rounds are always played to the end
+
+  FILE *archive;      // NULL: finished rounds are not archived
+  archive_round round;// the one being played
+
+  rating_table *ratings;  // NULL: players are not rated
+  const char *ratings_path;// written by the server, may be NULL
+  int ratings_dirty;       // rated rounds since it was written
+
+  round_result result;// of the last finished round
+  uint32_t rounds_finished;
 } skat_server_state;
 
 void skat_state_notify_disconnect(skat_server_state *, player *, server *);
@@ -108,16 +132,26 @@ typedef struct payload_notify_leave payload_notify_leave;
 void client_skat_state_notify_leave(skat_client_state *,
 									payload_notify_leave *);
 
+// Whether defs/game_transitions.def lists the (phase, action) pair
+int skat_transition_exists(game_phase phase, action_type type);
 int skat_server_state_apply(skat_server_state *ss, action *a, player *pl,
 							server *s);
 void skat_server_state_tick(skat_server_state *ss, server *s);
 
+// s may be NULL for seats that are played without a client
 int skat_client_state_apply(skat_client_state *cs, event *e, client *s);
 void skat_client_state_tick(skat_client_state *cs, client *c);
 
 void skat_resync_player(skat_server_state *, skat_client_state *, player *);
 
 void server_skat_state_init(skat_server_state *ss);
+void server_skat_state_free(skat_server_state *ss);
+void server_skat_state_seed_deals(skat_server_state *ss, uint64_t seed);
+void server_skat_state_set_deals(skat_server_state *ss, deal *deals,
+								 size_t length);
+void server_skat_state_set_archive(skat_server_state *ss, FILE *archive);
+void server_skat_state_set_ratings(skat_server_state *ss, rating_table *ratings,
+								   const char *path);
 void client_skat_state_init(skat_client_state *cs);
 
 #endif
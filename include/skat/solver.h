@@ -0,0 +1,86 @@
+#pragma once
+
+#include "skat/card.h"
+#include "skat/card_collection.h"
+#include "skat/eval.h"
+#include "skat/game_rules.h"
+#include "skat/stich.h"
+#include "skat/tablebase.h"
+#include <stdint.h>
+
+// Double dummy solver: every hand is known to every player.
+//
+// Card game values are card points won by the alleinspieler, Null games
+// are solved as win/loss. Ramsch is not supported.
+//
+// Limited solves and reaches of Color and Grand games may stop after a
+// number of stiche and take the static evaluation for the rest. Their
+// values are estimates, not bounds, even if complete is set.
+
+#define SOLVER_DEFAULT_TT_BITS (20)
+
+typedef struct skat_server_state skat_server_state;
+
+typedef struct solver_position {
+  game_rules gr;
+  card_collection hands[3];// indexed by active player
+  int alleinspieler;       // indexed by active player
+  stich curr_stich;        // cards already in the current stich
+  uint8_t alleinspieler_points;// already won, including the skat
+  uint8_t alleinspieler_stiche;
+} solver_position;
+
+typedef struct solver_result {
+  int alleinspieler_points;// at the end of the game, 0 for Null
+  int alleinspieler_wins;
+  card_id best_card;// for the player to move
+  uint64_t nodes;
+  int complete;// otherwise points and wins are proven lower bounds only
+} solver_result;
+
+typedef struct solver_limits {
+  int threads;        // searching threads, including the calling one
+  uint64_t max_nodes; // 0: unlimited, summed over all threads
+  uint64_t max_millis;// 0: unlimited
+  uint8_t eval_stiche;// searched before estimating the rest, 0: to the end
+  const eval_weights *eval;// NULL: eval_default_weights
+} solver_limits;
+
+typedef struct solver_tt_entry {
+  uint64_t check;// key ^ data
+  uint64_t data;
+} solver_tt_entry;
+
+typedef struct solver {
+  solver_tt_entry *tt;
+  uint64_t tt_mask;
+  uint64_t nodes;
+  const tablebase *tablebases[3];// color, grand, null
+} solver;
+
+int solver_init(solver *sv, uint8_t tt_bits);
+void solver_free(solver *sv);
+void solver_clear(solver *sv);
+int solver_use_tablebase(solver *sv, const tablebase *tb);
+
+int solver_position_from_state(const skat_server_state *ss,
+							   solver_position *pos);
+int solver_position_player(const solver_position *pos, int *ap);
+int solver_position_legal_moves(const solver_position *pos,
+								card_collection *moves);
+int solver_position_play(solver_position *pos, card_id cid);
+
+int solver_solve(solver *sv, const solver_position *pos, solver_result *res);
+int solver_solve_limited(solver *sv, const solver_position *pos,
+						 const solver_limits *limits, solver_result *res);
+int solver_reaches(solver *sv, const solver_position *pos, int points,
+				   int *result);
+int solver_reaches_limited(solver *sv, const solver_position *pos, int points,
+						   const solver_limits *limits, int *result,
+						   int *complete);
+int solver_lines_reach_limited(solver *sv, const solver_position *pos,
+							   int points, int every,
+							   const solver_limits *limits, int *result,
+							   int *complete);
+int solver_evaluate_moves(solver *sv, const solver_position *pos,
+						  card_id *moves, int *values, uint8_t *length);
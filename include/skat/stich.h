@@ -15,3 +15,5 @@ int stich_get_winner(const game_rules *gr, const stich *stich, int *result);
 int stich_card_legal(const game_rules *gr, const stich *stich,
 					 const card_id *new_card, const card_collection *hand,
 					 int *result);
+int stich_get_bekennen_mask(const game_rules *gr, const card_id *first_card,
+							card_collection *mask);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "skat/exec_async.h"
+#include <pthread.h>
+
+#define THREAD_POOL_MAX_THREADS (64)
+
+// Fixed number of worker threads running async_callbacks from one queue.
+// thread_pool_wait blocks until every submitted callback has returned.
+typedef struct thread_pool {
+  pthread_t threads[THREAD_POOL_MAX_THREADS];
+  int thread_count;
+  async_callback_queue q;
+  pthread_mutex_t lock;
+  pthread_cond_t idle;
+  size_t pending;
+} thread_pool;
+
+int thread_pool_init(thread_pool *tp, int threads, const char *name);
+void thread_pool_free(thread_pool *tp);
+void thread_pool_submit(thread_pool *tp, async_callback *cb);
+void thread_pool_wait(thread_pool *tp);
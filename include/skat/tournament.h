@@ -0,0 +1,60 @@
+#pragma once
+
+#include "skat/bot.h"
+#include "skat/player.h"
+#include "skat/reizen.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Club tournament between bots: every series the players are drawn into
+// tables of three, each table plays its games on a headless server, and the
+// rounds are scored with the Seeger-Fabian list. Tables are independent
+// jobs spread over a thread pool; a finished game adds to the standings of
+// its three players with atomics, so no table waits for another one.
+//
+// In duplicate mode every table of a series gets the same seeded deals and
+// plays them three times with the players rotated over the seats, so every
+// player holds every hand once. Each result is then compared to the mean of
+// all plays of the same hand, which takes the luck of the cards out.
+
+#define TOURNAMENT_MAX_PLAYERS  (3000)
+#define TOURNAMENT_MAX_ENGINES  (8) // distinct bot configs
+#define TOURNAMENT_SERIES_GAMES (36)// a list of three players
+#define TOURNAMENT_GAME_POINTS  (50)// added to won games, taken from lost ones
+#define TOURNAMENT_LOSS_POINTS  (40)// for each opponent of a lost game at three
+
+typedef struct tournament_player {
+  char name[PLAYER_MAX_NAME_LENGTH];
+  int engine;// index into tournament_config.engines
+  // Updated with atomics while tables run
+  int64_t points;
+  uint32_t games;
+  uint32_t won;
+  uint32_t lost;
+  double duplicate;// points above the mean of the same hands
+} tournament_player;
+
+typedef struct tournament_config {
+  int threads;  // tables played at once
+  uint32_t series;
+  uint32_t games;// per series and table, best a multiple of three
+  uint64_t seed;
+  int duplicate;
+  bot_config engines[TOURNAMENT_MAX_ENGINES];
+  int engine_count;
+} tournament_config;
+
+typedef struct tournament {
+  const tournament_config *conf;
+  tournament_player *players;
+  int player_count;// a multiple of three
+} tournament;
+
+// Seeger-Fabian points of a finished round, indexed by active player.
+// Ramsch counts as passed in.
+void tournament_score(const round_result *rr, int alleinspieler,
+					  int points[3]);
+// Plays every series, printing the standings after each one to out
+int tournament_run(tournament *t, FILE *out);
+// Sorted by points, or duplicate points in duplicate mode, best first
+void tournament_print_standings(const tournament *t, FILE *out);
@@ -5,9 +5,11 @@
 #include <pthread.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
 #define MIN(a, b) (a < b ? a : b)
@@ -18,6 +20,10 @@ size_t util_rand_int(size_t min, size_t max);
 size_t round_to_next_pow2(size_t n);
 void perm(int *, int, int);
 
+// Deadlines are on CLOCK_MONOTONIC
+void deadline_after_millis(struct timespec *deadline, uint64_t millis);
+int64_t deadline_millis_left(const struct timespec *deadline);
+
 #define THREAD_NAME_SIZE (16)
 
 int thread_get_name(pthread_t t, char *name_buffer);
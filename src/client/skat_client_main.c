@@ -11,7 +11,10 @@
 
 static void
 print_usage(const char *const name) {
-  printf("Usage: %s [-r] [-g] [-f] [-h host] [-p port] name\n", name);
+  printf("Usage: %s [-r] [-g] [-f] [-b] [-t millis] [-j threads] "
+		 "[-e stiche] [-w weights_file] [-T tablebase_file]... [-h host] "
+		 "[-p port] name\n",
+		 name);
 }
 
 int start_GRAPHICAL(int fullscreen);
@@ -25,9 +28,65 @@ main(int argc, char **argv) {
   int resume = 0;
   int graphical = 0;
   int fullscreen = 0;
+  int use_bot = 0;
+  bot_config bc = {.threads = BOT_DEFAULT_THREADS,
+				   .move_millis = BOT_DEFAULT_MOVE_MILLIS,
+				   .eval_stiche = BOT_DEFAULT_EVAL_STICHE};
+  long val;
+  char *weights_file = NULL;
+  eval_weights weights;
+  tablebase tablebases[3];
 
-  while ((opt = getopt(argc, argv, "h:p:rgf")) != -1) {
+  while ((opt = getopt(argc, argv, "h:p:rgfbt:j:e:w:T:")) != -1) {
 	switch (opt) {
+	  case 'b':
+		use_bot = 1;
+		break;
+	  case 't':
+		errno = 0;
+		val = strtol(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0' && val > 0) {
+		  bc.move_millis = val;
+		  break;
+		}
+		printf("Invalid time per move: %s\n", optarg);
+		print_usage(argv[0]);
+		exit(EXIT_FAILURE);
+	  case 'j':
+		errno = 0;
+		val = strtol(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0' && val > 0
+			&& val <= THREAD_POOL_MAX_THREADS) {
+		  bc.threads = (int) val;
+		  break;
+		}
+		printf("Invalid number of threads: %s\n", optarg);
+		print_usage(argv[0]);
+		exit(EXIT_FAILURE);
+	  case 'e':
+		errno = 0;
+		val = strtol(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0' && val >= 0 && val <= 10) {
+		  bc.eval_stiche = (uint8_t) val;
+		  break;
+		}
+		printf("Invalid number of stiche: %s\n", optarg);
+		print_usage(argv[0]);
+		exit(EXIT_FAILURE);
+	  case 'w':
+		weights_file = optarg;
+		break;
+	  case 'T':
+		// One per game type at most
+		if (bc.tablebases_length < 3
+			&& !tablebase_open(&tablebases[bc.tablebases_length], optarg)) {
+		  bc.tablebases = tablebases;
+		  bc.tablebases_length++;
+		  break;
+		}
+		printf("Could not open tablebase '%s'\n", optarg);
+		print_usage(argv[0]);
+		exit(EXIT_FAILURE);
 	  case 'r':
 		resume = 1;
 		break;
@@ -71,8 +130,9 @@ main(int argc, char **argv) {
 	exit(EXIT_FAILURE);
   }
 
-  printf("Options: host=%s; port=%ld; name=%s; resume=%d; graphical=%d\n", host,
-		 port, name, resume, graphical);
+  printf("Options: host=%s; port=%ld; name=%s; resume=%d; graphical=%d; "
+		 "bot=%d\n",
+		 host, port, name, resume, graphical, use_bot);
 
   if (graphical) {
 	// TODO: add graphical loop for render and skat logic
@@ -83,6 +143,21 @@ main(int argc, char **argv) {
 
   client *c = malloc(sizeof(client));
   client_init(c, host, (int) port, name);
+  if (use_bot) {
+	bot *b = malloc(sizeof(bot));
+	if (weights_file) {
+	  if (eval_read_file(weights_file, &weights)) {
+		printf("Could not read evaluation weights from '%s'\n", weights_file);
+		exit(EXIT_FAILURE);
+	  }
+	  bc.eval = &weights;
+	}
+	if (bot_init(b, &bc)) {
+	  printf("Could not start the bot\n");
+	  exit(EXIT_FAILURE);
+	}
+	client_use_bot(c, b);
+  }
   client_run(c, resume);
   __builtin_unreachable();
 }
@@ -11,9 +11,91 @@ main(int argc, char **argv) {
   int opt;
   char *remaining;
   long port = DEFAULT_PORT;
+  int seeded = 0;
+  unsigned long long seed = 0;
+  char *deal_file = NULL, *archive_file = NULL, *weights_file = NULL;
+  char *ratings_file = NULL, *players_file = NULL;
+  rating_table ratings;
+  FILE *archive;
+  long bots = 0, val;
+  bot_config bc = {.threads = BOT_DEFAULT_THREADS,
+				   .move_millis = BOT_DEFAULT_MOVE_MILLIS,
+				   .eval_stiche = BOT_DEFAULT_EVAL_STICHE};
+  char bot_name[PLAYER_MAX_NAME_LENGTH];
+  eval_weights weights;
+  tablebase tablebases[3];
 
-  while ((opt = getopt(argc, argv, "p:")) != -1) {
+  while ((opt = getopt(argc, argv, "p:s:d:a:b:t:j:e:w:r:P:T:")) != -1) {
 	switch (opt) {
+	  case 'b':
+		errno = 0;
+		bots = strtol(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0' && bots >= 0 && bots <= 3)
+		  break;
+		printf("Invalid number of bots: %s\n", optarg);
+		exit(EXIT_FAILURE);
+	  case 't':
+		errno = 0;
+		val = strtol(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0' && val > 0) {
+		  bc.move_millis = val;
+		  break;
+		}
+		printf("Invalid time per move: %s\n", optarg);
+		exit(EXIT_FAILURE);
+	  case 'j':
+		errno = 0;
+		val = strtol(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0' && val > 0
+			&& val <= THREAD_POOL_MAX_THREADS) {
+		  bc.threads = (int) val;
+		  break;
+		}
+		printf("Invalid number of threads: %s\n", optarg);
+		exit(EXIT_FAILURE);
+	  case 'e':
+		errno = 0;
+		val = strtol(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0' && val >= 0 && val <= 10) {
+		  bc.eval_stiche = (uint8_t) val;
+		  break;
+		}
+		printf("Invalid number of stiche: %s\n", optarg);
+		exit(EXIT_FAILURE);
+	  case 's':
+		errno = 0;
+		seed = strtoull(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0') {
+		  seeded = 1;
+		  break;
+		}
+		printf("Invalid seed: %s\n", optarg);
+		exit(EXIT_FAILURE);
+	  case 'd':
+		deal_file = optarg;
+		break;
+	  case 'a':
+		archive_file = optarg;
+		break;
+	  case 'w':
+		weights_file = optarg;
+		break;
+	  case 'r':
+		ratings_file = optarg;
+		break;
+	  case 'P':
+		players_file = optarg;
+		break;
+	  case 'T':
+		// One per game type at most
+		if (bc.tablebases_length < 3
+			&& !tablebase_open(&tablebases[bc.tablebases_length], optarg)) {
+		  bc.tablebases = tablebases;
+		  bc.tablebases_length++;
+		  break;
+		}
+		printf("Could not open tablebase '%s'\n", optarg);
+		exit(EXIT_FAILURE);
 	  case 'p':
 		errno = 0;
 		port = strtol(optarg, &remaining, 0);
@@ -27,7 +109,11 @@ main(int argc, char **argv) {
 
 		__attribute__((fallthrough));
 	  default:
-		printf("Usage: %s [-p port]\n", argv[0]);
+		printf("Usage: %s [-p port] [-s seed] [-d deal_file] [-a archive_file] "
+			   "[-b bots] [-t millis] [-j threads] [-e stiche] "
+			   "[-w weights_file] [-r ratings_file] [-P players_file] "
+			   "[-T tablebase_file]...\n",
+			   argv[0]);
 		exit(EXIT_FAILURE);
 	}
   }
@@ -36,6 +122,67 @@ main(int argc, char **argv) {
 
   server *s = malloc(sizeof(server));
   server_init(s, (int) port);
+
+  if (players_file && server_open_player_directory(s, players_file)) {
+	printf("Could not open the player directory '%s'\n", players_file);
+	exit(EXIT_FAILURE);
+  }
+
+  if (seeded)
+	server_skat_state_seed_deals(&s->ss, seed);
+
+  if (deal_file) {
+	deal *deals;
+	size_t deals_length;
+	if (deal_read_file(deal_file, &deals, &deals_length)) {
+	  printf("Could not read deals from '%s'\n", deal_file);
+	  exit(EXIT_FAILURE);
+	}
+	printf("Playing %zu deals from '%s'\n", deals_length, deal_file);
+	server_skat_state_set_deals(&s->ss, deals, deals_length);
+  }
+
+  if (archive_file) {
+	if (!(archive = fopen(archive_file, "a"))) {
+	  printf("Could not open archive '%s'\n", archive_file);
+	  exit(EXIT_FAILURE);
+	}
+	printf("Archiving finished rounds to '%s'\n", archive_file);
+	server_skat_state_set_archive(&s->ss, archive);
+  }
+
+  if (ratings_file) {
+	// A missing file starts everyone at the initial rating
+	if (rating_init(&ratings)
+		|| (access(ratings_file, F_OK) == 0
+			&& rating_read_file(&ratings, ratings_file))) {
+	  printf("Could not read ratings from '%s'\n", ratings_file);
+	  exit(EXIT_FAILURE);
+	}
+	printf("Rating players into '%s'\n", ratings_file);
+	server_skat_state_set_ratings(&s->ss, &ratings, ratings_file);
+  }
+
+  if (weights_file) {
+	if (eval_read_file(weights_file, &weights)) {
+	  printf("Could not read evaluation weights from '%s'\n", weights_file);
+	  exit(EXIT_FAILURE);
+	}
+	bc.eval = &weights;
+  }
+
+  if (bots && server_bots_init(s, &bc)) {
+	printf("Could not start the bots\n");
+	exit(EXIT_FAILURE);
+  }
+  for (long i = 0; i < bots; i++) {
+	snprintf(bot_name, sizeof(bot_name), SERVER_BOT_NAME, (int) i + 1);
+	if (server_bots_add(s, bot_name)) {
+	  printf("Could not seat '%s'\n", bot_name);
+	  exit(EXIT_FAILURE);
+	}
+  }
+
   server_run(s);
   __builtin_unreachable();
 }
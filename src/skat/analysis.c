@@ -0,0 +1,325 @@
+#include "skat/analysis.h"
+#include "skat/sampler.h"
+#include "skat/util.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// What every seat has seen so far
+typedef struct analysis_view {
+  card_collection played[3];// indexed by active player, with the curr stich
+  card_collection voids[3];
+  unsigned int skat_points;
+} analysis_view;
+
+static int
+analysis_value(const solver_position *pos, const solver_result *res) {
+  return pos->gr.type == GAME_TYPE_NULL ? res->alleinspieler_wins
+										: res->alleinspieler_points;
+}
+
+static int
+analysis_start(const archive_round *ar, solver_position *pos,
+			   analysis_view *v) {
+  const int as = ar->alleinspieler;
+  card_collection all = 0;
+
+  if (as < 0 || as > 2 || !deal_is_valid(&ar->d)
+	  || (ar->skat & ~(ar->d.skat | ar->d.hands[as])))
+	return 1;
+
+  memset(pos, '\0', sizeof(*pos));
+  memset(v, '\0', sizeof(*v));
+  pos->gr = ar->gr;
+  pos->alleinspieler = as;
+  pos->curr_stich = (stich){.played_cards = 0, .vorhand = 0, .winner = -1};
+  memcpy(pos->hands, ar->d.hands, sizeof(pos->hands));
+  // The alleinspieler may have swapped cards with the skat
+  pos->hands[as] = (ar->d.hands[as] | ar->d.skat) & ~ar->skat;
+  for (int p = 0; p < 3; p++)
+	all |= pos->hands[p];
+  if (__builtin_popcount(pos->hands[as]) != 10 || __builtin_popcount(all) != 30
+	  || card_collection_get_score(&ar->skat, &v->skat_points))
+	return 1;
+  pos->alleinspieler_points = v->skat_points;
+  return 0;
+}
+
+// Summed values of every legal card over deals that agree with what the
+// player at move has seen
+static int
+analysis_sampled(solver *sv, rng *r, uint32_t samples, const archive_round *ar,
+				 const solver_position *pos, const analysis_view *v,
+				 card_collection legal, int64_t values[32],
+				 uint32_t *drawn) {
+  const int as = pos->alleinspieler;
+  sampler s;
+  solver_position sampled, next;
+  solver_result res;
+  unsigned int skat_points;
+  deal d;
+  int ap, error = 0;
+
+  *drawn = 0;
+  if (solver_position_player(pos, &ap))
+	return 1;
+
+  sampler_init(&s);
+  for (int p = 0; p < 3; p++)
+	if (sampler_set_played(&s, p, v->played[p])
+		|| sampler_set_void(&s, p, v->voids[p]))
+	  error = 1;
+  if (sampler_set_known(&s, ap, pos->hands[ap]))
+	error = 1;
+  if (ap == as && !ar->gr.hand && sampler_set_known(&s, SAMPLER_SKAT, ar->skat))
+	error = 1;
+  if (ap != as && ar->gr.ouvert && sampler_set_known(&s, as, pos->hands[as]))
+	error = 1;
+  if (error || sampler_prepare(&s)) {
+	sampler_free(&s);
+	return 1;
+  }
+
+  for (; *drawn < samples; (*drawn)++) {
+	if (sampler_draw(&s, r, &d)) {
+	  error = 1;
+	  break;
+	}
+	sampled = *pos;
+	memcpy(sampled.hands, d.hands, sizeof(sampled.hands));
+	card_collection_get_score(&d.skat, &skat_points);
+	sampled.alleinspieler_points += skat_points - v->skat_points;
+
+	for (card_collection m = legal; m; m &= m - 1) {
+	  next = sampled;
+	  if (solver_position_play(&next,
+							   card_collection_id_from_index(__builtin_ctz(m)))
+		  || solver_solve(sv, &next, &res)) {
+		error = 1;
+		break;
+	  }
+	  values[__builtin_ctz(m)] += analysis_value(&next, &res);
+	}
+	if (error)
+	  break;
+  }
+
+  sampler_free(&s);
+  return error;
+}
+
+// Best card for the player at move and what the played one loses against it,
+// the opponents of the alleinspieler go for low values
+static void
+analysis_compare(const int sign, const card_collection legal,
+				 const int64_t values[32], const uint8_t played,
+				 uint8_t *const best, int64_t *const loss) {
+  *best = played;
+  for (card_collection m = legal; m; m &= m - 1) {
+	uint8_t i = __builtin_ctz(m);
+	if (sign * values[i] > sign * values[*best])
+	  *best = i;
+  }
+  *loss = sign * (values[*best] - values[played]);
+}
+
+static int
+analysis_move_at(solver *sv, rng *r, uint32_t samples, const archive_round *ar,
+				 const solver_position *pos, const analysis_view *v,
+				 card_collection legal, uint8_t played, analysis_move *m) {
+  card_id moves[10];
+  int values[10], ap, sign;
+  int64_t perfect[32] = {0}, sampled[32] = {0}, loss;
+  uint8_t length, best;
+  uint32_t drawn;
+
+  if (solver_position_player(pos, &ap)
+	  || solver_evaluate_moves(sv, pos, moves, values, &length))
+	return 1;
+  for (uint8_t i = 0; i < length; i++) {
+	uint8_t index;
+	if (card_collection_index_from_id(&moves[i], &index))
+	  return 1;
+	perfect[index] = values[i];
+  }
+
+  sign = ap == pos->alleinspieler ? 1 : -1;
+  m->ap = ap;
+  m->played = card_collection_id_from_index(played);
+  analysis_compare(sign, legal, perfect, played, &best, &loss);
+  m->best = card_collection_id_from_index(best);
+  m->loss = (int) loss;
+
+  m->best_sampled = m->played;
+  m->loss_sampled = 0;
+  if (!samples)
+	return 0;
+  if (analysis_sampled(sv, r, samples, ar, pos, v, legal, sampled, &drawn)
+	  || !drawn)
+	return 1;
+  analysis_compare(sign, legal, sampled, played, &best, &loss);
+  m->best_sampled = card_collection_id_from_index(best);
+  m->loss_sampled = (double) loss / drawn;
+  return 0;
+}
+
+int
+analysis_round(solver *sv, rng *r, uint32_t samples, const archive_round *ar,
+			   analysis_move *moves, uint8_t *length) {
+  solver_position pos;
+  analysis_view v;
+  card_collection legal, bit, follow;
+  card c;
+  int ap;
+
+  *length = 0;
+  if (ar->gr.type != GAME_TYPE_COLOR && ar->gr.type != GAME_TYPE_GRAND
+	  && ar->gr.type != GAME_TYPE_NULL)
+	return 0;
+  if (analysis_start(ar, &pos, &v))
+	return 1;
+
+  for (uint8_t i = 0; i < ar->length; i++) {
+	if (solver_position_player(&pos, &ap)
+		|| solver_position_legal_moves(&pos, &legal)
+		|| card_get(&ar->cards[i], &c))
+	  return 1;
+	bit = 0;
+	card_collection_add_card(&bit, &ar->cards[i]);
+	if (!(bit & legal))
+	  return 1;
+
+	if (legal & (legal - 1)) {
+	  moves[*length].index = i;
+	  if (analysis_move_at(sv, r, samples, ar, &pos, &v, legal,
+						   __builtin_ctz(bit), &moves[*length]))
+		return 1;
+	  (*length)++;
+	}
+
+	if (pos.curr_stich.played_cards
+		&& !stich_get_bekennen_mask(&pos.gr, &pos.curr_stich.cs[0], &follow)
+		&& !(bit & follow))
+	  v.voids[ap] |= follow;
+	v.played[ap] |= bit;
+	if (solver_position_play(&pos, ar->cards[i]))
+	  return 1;
+  }
+  return 0;
+}
+
+typedef struct analysis_batch {
+  FILE *in, *out;
+  const analysis_config *conf;
+  pthread_mutex_t lock;// for everything below
+  uint64_t line_num;
+  analysis_totals totals;
+  int error;
+} analysis_batch;
+
+static void
+analysis_print(analysis_batch *b, uint64_t line_num, const archive_round *ar,
+			   const analysis_move *moves, uint8_t length) {
+  char played[4], best[4], best_sampled[4];
+
+  for (uint8_t i = 0; i < length; i++) {
+	const analysis_move *m = &moves[i];
+	card_get_name(&m->played, played);
+	card_get_name(&m->best, best);
+	card_get_name(&m->best_sampled, best_sampled);
+	fprintf(b->out, "%llu\t%u\t%s\t%s\t%s\t%d", (unsigned long long) line_num,
+			m->index + 1, ar->names[m->ap], played, best, m->loss);
+	if (b->conf->samples)
+	  fprintf(b->out, "\t%s\t%.2f", best_sampled, m->loss_sampled);
+	fputc('\n', b->out);
+  }
+  fflush(b->out);
+}
+
+static void *
+analysis_worker(void *args) {
+  analysis_batch *b = args;
+  solver sv;
+  rng r;
+  archive_round ar;
+  analysis_move moves[ARCHIVE_CARDS];
+  uint8_t length;
+  uint64_t line_num;
+  char *line = NULL;
+  size_t line_size = 0;
+  ssize_t read;
+  int invalid;
+
+  if (solver_init(&sv, ANALYSIS_TT_BITS)) {
+	pthread_mutex_lock(&b->lock);
+	b->error = 1;
+	pthread_mutex_unlock(&b->lock);
+	return NULL;
+  }
+
+  for (;;) {
+	pthread_mutex_lock(&b->lock);
+	read = getline(&line, &line_size, b->in);
+	line_num = ++b->line_num;
+	pthread_mutex_unlock(&b->lock);
+	if (read == -1)
+	  break;
+	if (line[0] == '\n' || line[0] == '#')
+	  continue;
+
+	// Every round is sampled the same way, whichever thread gets it
+	rng_seed(&r, b->conf->seed ^ (line_num * 0x9e3779b97f4a7c15ull));
+	solver_clear(&sv);
+	invalid = archive_parse(line, &ar)
+			  || analysis_round(&sv, &r, b->conf->samples, &ar, moves, &length);
+	if (invalid)
+	  DERROR_PRINTF("Could not analyze the round in line %llu",
+					(unsigned long long) line_num);
+
+	pthread_mutex_lock(&b->lock);
+	if (invalid || !length) {
+	  b->totals.skipped++;
+	} else {
+	  analysis_print(b, line_num, &ar, moves, length);
+	  b->totals.rounds++;
+	  b->totals.moves += length;
+	  for (uint8_t i = 0; i < length; i++) {
+		b->totals.loss += moves[i].loss;
+		b->totals.loss_sampled += moves[i].loss_sampled;
+	  }
+	}
+	pthread_mutex_unlock(&b->lock);
+  }
+
+  free(line);
+  solver_free(&sv);
+  return NULL;
+}
+
+int
+analysis_run(FILE *in, FILE *out, const analysis_config *conf,
+			 analysis_totals *totals) {
+  pthread_t threads[ANALYSIS_MAX_THREADS];
+  analysis_batch b = {.in = in, .out = out, .conf = conf};
+  int count = conf->threads, started = 0;
+
+  if (count < 1 || count > ANALYSIS_MAX_THREADS)
+	return 1;
+  pthread_mutex_init(&b.lock, NULL);
+
+  fprintf(out, "# line\tcard\tplayer\tplayed\tbest\tloss%s\n",
+		  conf->samples ? "\tsampled best\tsampled loss" : "");
+  for (int t = 0; t < count; t++) {
+	if (pthread_create(&threads[t], NULL, analysis_worker, &b)) {
+	  b.error = 1;
+	  break;
+	}
+	started++;
+  }
+  for (int t = 0; t < started; t++)
+	pthread_join(threads[t], NULL);
+
+  pthread_mutex_destroy(&b.lock);
+  *totals = b.totals;
+  return b.error || ferror(out);
+}
@@ -0,0 +1,276 @@
+#include "skat/archive.h"
+#include "skat/reizen.h"
+#include "skat/stich.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARCHIVE_FIELDS (8)
+
+static char
+archive_card_digit(const card_id cid) {
+  uint8_t index;
+  if (card_collection_index_from_id(&cid, &index))
+	return '\0';
+  return deal_text_digit(index);
+}
+
+static int
+archive_card_from_digit(const char ch, card_id *const cid) {
+  int index = deal_text_digit_value(ch);
+  if (index < 0)
+	return 1;
+  *cid = card_collection_id_from_index(index);
+  return !*cid;
+}
+
+static int
+archive_game_to_text(const game_rules *const gr, const uint16_t reizwert,
+					 char *const str) {
+  int n = 0;
+  switch (gr->type) {
+	case GAME_TYPE_COLOR:
+	  if (gr->trumpf < COLOR_KARO || gr->trumpf > COLOR_KREUZ)
+		return 1;
+	  str[n++] = 'c';
+	  str[n++] = (char) ('1' + gr->trumpf - COLOR_KARO);
+	  break;
+	case GAME_TYPE_GRAND:
+	  str[n++] = 'g';
+	  break;
+	case GAME_TYPE_NULL:
+	  str[n++] = 'n';
+	  break;
+	case GAME_TYPE_RAMSCH:
+	  str[n++] = 'r';
+	  break;
+	default:
+	  return 1;
+  }
+  if (gr->hand)
+	str[n++] = 'h';
+  if (gr->schneider_angesagt)
+	str[n++] = 's';
+  if (gr->schwarz_angesagt)
+	str[n++] = 'z';
+  if (gr->ouvert)
+	str[n++] = 'o';
+  str[n] = '\0';
+  if (reizwert)
+	sprintf(&str[n], "%u", reizwert);
+  return 0;
+}
+
+static int
+archive_game_from_text(const char *str, game_rules *const gr,
+					   uint16_t *const reizwert) {
+  unsigned long value;
+  char *end;
+
+  memset(gr, '\0', sizeof(*gr));
+  *reizwert = 0;
+  switch (*str++) {
+	case 'c':
+	  if (*str < '1' || *str > '4')
+		return 1;
+	  gr->type = GAME_TYPE_COLOR;
+	  gr->trumpf = COLOR_KARO + (*str++ - '1');
+	  break;
+	case 'g':
+	  gr->type = GAME_TYPE_GRAND;
+	  break;
+	case 'n':
+	  gr->type = GAME_TYPE_NULL;
+	  break;
+	case 'r':
+	  gr->type = GAME_TYPE_RAMSCH;
+	  break;
+	default:
+	  return 1;
+  }
+  for (; *str; str++) {
+	switch (*str) {
+	  case 'h':
+		gr->hand = 1;
+		break;
+	  case 's':
+		gr->schneider_angesagt = 1;
+		break;
+	  case 'z':
+		gr->schwarz_angesagt = 1;
+		break;
+	  case 'o':
+		gr->ouvert = 1;
+		break;
+	  default:
+		if (*str < '0' || *str > '9')
+		  return 1;
+		value = strtoul(str, &end, 10);
+		if (*end || value > REIZWERT_MAX)
+		  return 1;
+		*reizwert = (uint16_t) value;
+		return 0;
+	}
+  }
+  return 0;
+}
+
+int
+archive_write(FILE *f, const archive_round *ar) {
+  char deal_text[DEAL_TEXT_LENGTH + 1], game[12], skat[3];
+  char cards[ARCHIVE_CARDS + 1];
+  uint8_t count;
+  card_id cid;
+
+  if (deal_to_text(&ar->d, deal_text)
+	  || archive_game_to_text(&ar->gr, ar->reizwert, game)
+	  || ar->length > ARCHIVE_CARDS
+	  || card_collection_get_card_count(&ar->skat, &count) || count != 2)
+	return 1;
+  for (uint8_t i = 0; i < 2; i++)
+	if (card_collection_get_card(&ar->skat, &i, &cid)
+		|| !(skat[i] = archive_card_digit(cid)))
+	  return 1;
+  skat[2] = '\0';
+  for (int i = 0; i < ar->length; i++)
+	if (!(cards[i] = archive_card_digit(ar->cards[i])))
+	  return 1;
+  cards[ar->length] = '\0';
+
+  fprintf(f, "%s\t%s\t", deal_text, game);
+  if (ar->alleinspieler < 0)
+	fputc('-', f);
+  else
+	fprintf(f, "%d", ar->alleinspieler);
+  fprintf(f, "\t%s\t%s", skat, cards);
+  // Names end at a tab or line break, which they do not hold anyway
+  for (int i = 0; i < 3; i++)
+	fprintf(f, "\t%.*s", (int) strcspn(ar->names[i], "\t\r\n"), ar->names[i]);
+  fputc('\n', f);
+  return ferror(f);
+}
+
+int
+archive_parse(const char *line, archive_round *ar) {
+  char *copy, *rest, *fields[ARCHIVE_FIELDS];
+  card_id cid;
+  size_t length;
+  int error = 1;
+
+  if (!(rest = copy = strdup(line)))
+	return 2;
+  copy[strcspn(copy, "\r\n")] = '\0';
+  for (int i = 0; i < ARCHIVE_FIELDS; i++)
+	if (!(fields[i] = strsep(&rest, "\t")))
+	  goto done;
+  if (rest)
+	goto done;
+
+  memset(ar, '\0', sizeof(*ar));
+  if (deal_from_text(fields[0], &ar->d)
+	  || archive_game_from_text(fields[1], &ar->gr, &ar->reizwert))
+	goto done;
+
+  if (!strcmp(fields[2], "-"))
+	ar->alleinspieler = -1;
+  else if (strlen(fields[2]) == 1 && fields[2][0] >= '0' && fields[2][0] <= '2')
+	ar->alleinspieler = fields[2][0] - '0';
+  else
+	goto done;
+  if ((ar->alleinspieler < 0) != (ar->gr.type == GAME_TYPE_RAMSCH))
+	goto done;
+
+  if (strlen(fields[3]) != 2)
+	goto done;
+  for (int i = 0; i < 2; i++)
+	if (archive_card_from_digit(fields[3][i], &cid)
+		|| card_collection_add_card(&ar->skat, &cid))
+	  goto done;
+
+  if ((length = strlen(fields[4])) > ARCHIVE_CARDS)
+	goto done;
+  for (size_t i = 0; i < length; i++)
+	if (archive_card_from_digit(fields[4][i], &ar->cards[i]))
+	  goto done;
+  ar->length = length;
+
+  for (int i = 0; i < 3; i++) {
+	if (strlen(fields[5 + i]) > PLAYER_MAX_NAME_LENGTH)
+	  goto done;
+	strcpy(ar->names[i], fields[5 + i]);
+  }
+  error = 0;
+
+done:
+  free(copy);
+  return error;
+}
+
+int
+archive_round_won(const archive_round *ar, int *won) {
+  const int as = ar->alleinspieler;
+  card_collection hands[3], taken = ar->skat, initial;
+  stich st = {.vorhand = 0, .winner = -1};
+  uint8_t count;
+  unsigned points;
+  int legal, winnerv, curr, next = 0, schneider, schwarz;
+  card_id cid;
+
+  if (as < 0 || as > 2 || !deal_is_valid(&ar->d)
+	  || (ar->skat & ~(ar->d.skat | ar->d.hands[as])))
+	return 1;
+  memcpy(hands, ar->d.hands, sizeof(hands));
+  initial = ar->d.hands[as] | ar->d.skat;
+  hands[as] = initial & ~ar->skat;
+
+  for (int n = 0; n < 10; n++) {
+	for (int i = 0; i < 3; i++) {
+	  curr = (st.vorhand + i) % 3;
+	  if (next < ar->length) {
+		cid = ar->cards[next++];
+		if (stich_card_legal(&ar->gr, &st, &cid, &hands[curr], &legal)
+			|| !legal)
+		  return 1;
+	  } else {
+		// Played out after a claim
+		for (uint8_t j = 0;; j++) {
+		  if (card_collection_get_card(&hands[curr], &j, &cid))
+			return 1;
+		  if (!stich_card_legal(&ar->gr, &st, &cid, &hands[curr], &legal)
+			  && legal)
+			break;
+		}
+	  }
+	  card_collection_remove_card(&hands[curr], &cid);
+	  st.cs[i] = cid;
+	  st.played_cards = i + 1;
+	}
+	if (stich_get_winner(&ar->gr, &st, &winnerv))
+	  return 1;
+	st.winner = (st.vorhand + winnerv) % 3;
+	if (st.winner == as)
+	  card_collection_add_card_array(&taken, st.cs, 3);
+	st = (stich){.vorhand = st.winner, .winner = -1};
+  }
+
+  card_collection_get_card_count(&taken, &count);
+  if (ar->gr.type == GAME_TYPE_NULL) {
+	*won = count == 2;
+	schneider = schwarz = 0;
+  } else if (ar->gr.type == GAME_TYPE_COLOR
+			 || ar->gr.type == GAME_TYPE_GRAND) {
+	card_collection_get_score(&taken, &points);
+	schneider = points >= 90;
+	schwarz = count == 32;
+	*won = points > 60 && (schneider || !ar->gr.schneider_angesagt)
+		   && (schwarz || !ar->gr.schwarz_angesagt);
+  } else {
+	return 1;
+  }
+  if (*won
+	  && ar->reizwert
+				 > reizen_get_min_game_value(&ar->gr, initial)
+						   + (schneider + schwarz)
+									 * reizen_get_grundwert(&ar->gr))
+	*won = 0;
+  return 0;
+}
@@ -0,0 +1,272 @@
+#include "skat/bid_advisor.h"
+#include "skat/canonical.h"
+#include "skat/reizen.h"
+#include "skat/sampler.h"
+#include "skat/util.h"
+#include <string.h>
+#include <time.h>
+
+// hand_eval_margin 0 is a coin flip, every point of margin is worth 10 %.
+// The prior counts as this many samples.
+#define BID_ADVISOR_PRIOR_WEIGHT (4)
+// Games further below the margin are left to the prior
+#define BID_ADVISOR_PLAUSIBLE (-2)
+// Deals harder than this are skipped rather than holding up the answer
+#define BID_ADVISOR_MAX_NODES (250000)
+
+typedef struct bid_search {
+  const sampler *s;
+  card_collection hand;
+  int position;
+  uint8_t plausible[BID_ADVISOR_OPTIONS];
+  uint32_t max_samples;
+  uint32_t samples_started;
+  struct timespec deadline;
+} bid_search;
+
+typedef struct bid_worker {
+  bid_search *bs;
+  solver *sv;
+  rng r;
+  uint32_t samples[BID_ADVISOR_OPTIONS];
+  uint32_t wins[BID_ADVISOR_OPTIONS];
+} bid_worker;
+
+// One sample plays every plausible option on the same deal
+static void
+bid_worker_run(void *args) {
+  bid_worker *w = args;
+  bid_search *bs = w->bs;
+  const int me = bs->position;
+  solver_position pos;
+  deal d;
+  card_collection cards, press;
+  unsigned int points;
+  int result, complete;
+  int64_t left;
+
+  while (__atomic_fetch_add(&bs->samples_started, 1, __ATOMIC_RELAXED)
+		 < bs->max_samples) {
+	sampler_draw(bs->s, &w->r, &d);
+	for (int o = 0; o < BID_ADVISOR_OPTIONS; o++) {
+	  const game_rules *gr = &hand_eval_games[o % HAND_EVAL_GAMES];
+	  if (!bs->plausible[o])
+		continue;
+	  memset(&pos, '\0', sizeof(pos));
+	  memcpy(pos.hands, d.hands, sizeof(pos.hands));
+	  pos.gr = *gr;
+	  pos.alleinspieler = me;
+	  pos.curr_stich = (stich){.played_cards = 0, .vorhand = 0, .winner = -1};
+	  if (o < HAND_EVAL_GAMES) {
+		press = d.skat;
+	  } else {
+		cards = bs->hand | d.skat;
+		press = hand_eval_press(cards, gr);
+		pos.hands[me] = cards & ~press;
+	  }
+	  card_collection_get_score(&press, &points);
+	  pos.alleinspieler_points = gr->type == GAME_TYPE_NULL ? 0 : points;
+
+	  if ((left = deadline_millis_left(&bs->deadline)) <= 0)
+		return;
+	  solver_limits limits = {.threads = 1,
+							  .max_nodes = BID_ADVISOR_MAX_NODES,
+							  .max_millis = left};
+	  if (solver_reaches_limited(w->sv, &pos, 61, &limits, &result,
+								 &complete)) {
+		DERROR_PRINTF("Solver rejected a sampled position");
+		return;
+	  }
+	  if (!complete)
+		continue;
+	  w->samples[o]++;
+	  w->wins[o] += result;
+	}
+  }
+}
+
+// Null is not symmetric in the same suits as the trumpf games, so its
+// statistics live in an entry of their own
+#define BID_ADVISOR_NULL_KEY (1ull << 34)
+
+// Where the statistics of one option are kept: trumpf games in the entry of
+// the hand canonical for Grand, under the trumpf the canonical hand has
+typedef struct bid_advisor_view {
+  uint64_t keys[2];// trumpf games, Null
+  uint8_t entry[BID_ADVISOR_OPTIONS];
+  uint8_t option[BID_ADVISOR_OPTIONS];
+} bid_advisor_view;
+
+static void
+bid_advisor_view_init(bid_advisor_view *const v, const card_collection hand,
+					  const int position) {
+  const game_rules grand = {.type = GAME_TYPE_GRAND};
+  const game_rules null = {.type = GAME_TYPE_NULL};
+  const uint64_t seat = (uint64_t) (position + 1) << 32;
+  canonical_perm suit_perm, null_perm;
+  card_collection canon;
+
+  canonical_hand(&grand, hand, &canon, &suit_perm, NULL);
+  v->keys[0] = canon | seat;
+  canonical_hand(&null, hand, &canon, &null_perm, NULL);
+  v->keys[1] = canon | seat | BID_ADVISOR_NULL_KEY;
+
+  for (int o = 0; o < BID_ADVISOR_OPTIONS; o++) {
+	const game_rules *gr = &hand_eval_games[o % HAND_EVAL_GAMES];
+	int g = o % HAND_EVAL_GAMES;
+	v->entry[o] = gr->type == GAME_TYPE_NULL;
+	if (gr->type == GAME_TYPE_COLOR)
+	  g = suit_perm.lane[gr->trumpf - COLOR_KARO];
+	v->option[o] = o - o % HAND_EVAL_GAMES + g;
+  }
+}
+
+static bid_advisor_entry *
+bid_advisor_slot(const bid_advisor *const ba, const uint64_t key) {
+  uint64_t h = key * 0x9e3779b97f4a7c15ull;
+  return &ba->cache[(h >> 32) & ba->cache_mask];
+}
+
+int
+bid_advisor_init(bid_advisor *ba, thread_pool *tp, solver *solvers,
+				 uint8_t cache_bits, uint64_t seed) {
+  if (cache_bits > 30)
+	return 1;
+  memset(ba, '\0', sizeof(*ba));
+  ba->cache = calloc(1ull << cache_bits, sizeof(*ba->cache));
+  if (!ba->cache)
+	return 2;
+  ba->cache_mask = (1ull << cache_bits) - 1;
+  ba->tp = tp;
+  ba->solvers = solvers;
+  if (seed)
+	rng_seed(&ba->r, seed);
+  else if (rng_seed_random(&ba->r)) {
+	free(ba->cache);
+	return 3;
+  }
+  pthread_mutex_init(&ba->lock, NULL);
+  return 0;
+}
+
+void
+bid_advisor_free(bid_advisor *ba) {
+  free(ba->cache);
+  ba->cache = NULL;
+  pthread_mutex_destroy(&ba->lock);
+}
+
+// Adds the samples of the hand itself to samples and wins, returns the
+// number of deals
+static uint32_t
+bid_advisor_sample(bid_advisor *const ba, const card_collection hand,
+				   const int position, const uint32_t max_samples,
+				   const uint64_t millis, uint32_t *const samples,
+				   uint32_t *const wins) {
+  bid_worker workers[THREAD_POOL_MAX_THREADS];
+  bid_search bs;
+  sampler s;
+
+  sampler_init(&s);
+  if (sampler_set_known(&s, position, hand) || sampler_prepare(&s)) {
+	sampler_free(&s);
+	return 0;
+  }
+  bs = (bid_search){.s = &s,
+					.hand = hand,
+					.position = position,
+					.max_samples = max_samples};
+  for (int o = 0; o < BID_ADVISOR_OPTIONS; o++)
+	bs.plausible[o] =
+			hand_eval_margin(hand, &hand_eval_games[o % HAND_EVAL_GAMES])
+			>= BID_ADVISOR_PLAUSIBLE;
+  deadline_after_millis(&bs.deadline, millis);
+
+  for (int t = 0; t < ba->tp->thread_count; t++) {
+	memset(&workers[t], '\0', sizeof(workers[t]));
+	workers[t].bs = &bs;
+	workers[t].sv = &ba->solvers[t];
+	rng_seed(&workers[t].r, rng_next_u64(&ba->r));
+	thread_pool_submit(ba->tp, &(async_callback){.do_stuff = bid_worker_run,
+												 .data = &workers[t]});
+  }
+  thread_pool_wait(ba->tp);
+  sampler_free(&s);
+
+  for (int t = 0; t < ba->tp->thread_count; t++) {
+	for (int o = 0; o < BID_ADVISOR_OPTIONS; o++) {
+	  samples[o] += workers[t].samples[o];
+	  wins[o] += workers[t].wins[o];
+	}
+  }
+  return MIN(bs.samples_started, bs.max_samples);
+}
+
+int
+bid_advisor_query(bid_advisor *ba, card_collection hand, int position,
+				  uint64_t millis, bid_advice advice[BID_ADVISOR_OPTIONS],
+				  uint16_t *reizwert) {
+  bid_advisor_view v;
+  bid_advisor_entry entries[2], *slot;
+  uint32_t samples[BID_ADVISOR_OPTIONS] = {0}, wins[BID_ADVISOR_OPTIONS] = {0};
+  uint32_t deals;
+  double prior;
+
+  if (__builtin_popcount(hand) != 10 || position < 0 || position > 2)
+	return 1;
+
+  bid_advisor_view_init(&v, hand, position);
+  pthread_mutex_lock(&ba->lock);
+  for (int i = 0; i < 2; i++) {
+	entries[i] = *bid_advisor_slot(ba, v.keys[i]);
+	if (entries[i].key != v.keys[i])
+	  entries[i] = (bid_advisor_entry){.key = v.keys[i]};
+  }
+  pthread_mutex_unlock(&ba->lock);
+
+  deals = MIN(entries[0].deals, entries[1].deals);
+  if (millis && deals < BID_ADVISOR_MAX_SAMPLES) {
+	deals = bid_advisor_sample(ba, hand, position,
+							   BID_ADVISOR_MAX_SAMPLES - deals, millis,
+							   samples, wins);
+	pthread_mutex_lock(&ba->lock);
+	for (int i = 0; i < 2; i++) {
+	  // Another question may have sampled the same class meanwhile
+	  slot = bid_advisor_slot(ba, v.keys[i]);
+	  if (slot->key == v.keys[i])
+		entries[i] = *slot;
+	  entries[i].deals += deals;
+	}
+	for (int o = 0; o < BID_ADVISOR_OPTIONS; o++) {
+	  bid_advisor_entry *e = &entries[v.entry[o]];
+	  e->samples[v.option[o]] = MIN(e->samples[v.option[o]] + samples[o],
+									UINT16_MAX);
+	  e->wins[v.option[o]] = MIN(e->wins[v.option[o]] + wins[o], UINT16_MAX);
+	}
+	for (int i = 0; i < 2; i++)
+	  *bid_advisor_slot(ba, v.keys[i]) = entries[i];
+	pthread_mutex_unlock(&ba->lock);
+  }
+
+  // Worth it if the expected Seeger-Fabian score (won: value + 50, lost:
+  // -2 value - 50) beats passing
+  *reizwert = 0;
+  for (int o = 0; o < BID_ADVISOR_OPTIONS; o++) {
+	bid_advice *a = &advice[o];
+	a->gr = hand_eval_games[o % HAND_EVAL_GAMES];
+	a->gr.hand = o < HAND_EVAL_GAMES;
+	a->value = reizen_get_min_game_value(&a->gr, hand);
+	a->samples = entries[v.entry[o]].samples[v.option[o]];
+	a->wins = entries[v.entry[o]].wins[v.option[o]];
+
+	prior = 0.5 + 0.1 * hand_eval_margin(hand, &a->gr);
+	prior = prior < 0.05 ? 0.05 : prior > 0.95 ? 0.95 : prior;
+	a->win_rate = (a->wins + BID_ADVISOR_PRIOR_WEIGHT * prior)
+				  / (a->samples + BID_ADVISOR_PRIOR_WEIGHT);
+
+	if (a->win_rate * (a->value + 50) > (1 - a->win_rate) * (2 * a->value + 50)
+		&& a->value > *reizwert)
+	  *reizwert = a->value;
+  }
+  return 0;
+}
@@ -0,0 +1,495 @@
+#include "skat/bot.h"
+#include "skat/hand_eval.h"
+#include "skat/reizen.h"
+#include "skat/sampler.h"
+#include "skat/stich.h"
+#include "skat/util.h"
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+static int
+bot_game_value(const card_collection cards, const game_rules *const gr) {
+  return reizen_get_min_game_value(gr, cards);
+}
+
+static int
+bot_bid_limit(const card_collection hand) {
+  int limit = 0, value;
+  for (int g = 0; g < HAND_EVAL_GAMES; g++) {
+	if (hand_eval_margin(hand, &hand_eval_games[g]) <= 0)
+	  continue;
+	value = bot_game_value(hand, &hand_eval_games[g]);
+	if (value > limit)
+	  limit = value;
+  }
+  return limit;
+}
+
+static int
+bot_reizen_roles(const reiz_state *const rs, int *const teller,
+				 int *const listener) {
+  switch (rs->rphase) {
+	case REIZ_PHASE_MITTELHAND_TO_VORHAND:
+	  *teller = 1;
+	  *listener = 0;
+	  return 0;
+	case REIZ_PHASE_HINTERHAND_TO_WINNER:
+	  *teller = 2;
+	  *listener = rs->winner;
+	  return 0;
+	case REIZ_PHASE_WINNER:
+	  *teller = rs->winner;
+	  *listener = -1;
+	  return 0;
+	default:
+	  return 1;
+  }
+}
+
+static int
+bot_is_my_reizen_turn(const skat_client_state *const cs) {
+  const reiz_state *rs = &cs->sgs.rs;
+  int teller, listener;
+  if (bot_reizen_roles(rs, &teller, &listener))
+	return 0;
+  if (rs->rphase == REIZ_PHASE_WINNER || rs->waiting_teller)
+	return cs->my_active_player_index == teller;
+  return cs->my_active_player_index == listener;
+}
+
+// Only the first question about a hand waits for samples
+static int
+bot_query_advisor(bot *const b, const card_collection hand, const int position,
+				  bid_advice advice[BID_ADVISOR_OPTIONS],
+				  uint16_t *const reizwert) {
+  uint64_t millis = hand != b->bid_hand ? b->conf.move_millis : 0;
+
+  b->bid_hand = hand;
+  return bid_advisor_query(&b->ba, hand, position, millis, advice, reizwert);
+}
+
+static int
+bot_bid_advice(bot *const b, const card_collection hand, const int position) {
+  bid_advice advice[BID_ADVISOR_OPTIONS];
+  uint16_t reizwert;
+
+  if (bot_query_advisor(b, hand, position, advice, &reizwert))
+	return bot_bid_limit(hand);
+  return reizwert;
+}
+
+// Whether the best Hand game worth the reizwert scores better than the best
+// game after taking the skat, both as the bid advisor expects them. Plans
+// the Hand game if so.
+static int
+bot_plays_hand(bot *const b, const skat_client_state *const cs) {
+  bid_advice advice[BID_ADVISOR_OPTIONS];
+  double score, best[2] = {-INFINITY, -INFINITY};
+  game_rules hand_gr = {0};
+  uint16_t reizwert;
+
+  if (bot_query_advisor(b, cs->my_hand, cs->my_active_player_index, advice,
+						&reizwert))
+	return 0;
+  for (int o = 0; o < BID_ADVISOR_OPTIONS; o++) {
+	const bid_advice *a = &advice[o];
+	if (a->value < cs->sgs.rs.reizwert)
+	  continue;
+	// Seeger-Fabian as in the bid advisor
+	score = a->win_rate * (a->value + 50)
+			- (1 - a->win_rate) * (2 * a->value + 50);
+	if (score > best[!a->gr.hand]) {
+	  best[!a->gr.hand] = score;
+	  if (a->gr.hand)
+		hand_gr = a->gr;
+	}
+  }
+  if (best[0] <= best[1])
+	return 0;
+
+  DEBUG_PRINTF("Bot plays Hand, expecting %.0f instead of %.0f", best[0],
+			   best[1]);
+  b->planned_press = 0;
+  b->planned_gr = hand_gr;
+  return 1;
+}
+
+static int
+bot_reizen(bot *const b, const skat_client_state *const cs,
+		   action *const a) {
+  reiz_state rs = cs->sgs.rs;
+  int limit = bot_bid_advice(b, cs->my_hand, cs->my_active_player_index);
+  uint16_t next;
+
+  if (rs.rphase == REIZ_PHASE_WINNER) {
+	// Nobody bid: play for 18 or go to Ramsch
+	a->type = limit >= REIZWERT_MIN ? ACTION_REIZEN_CONFIRM
+									: ACTION_REIZEN_PASSE;
+  } else if (rs.waiting_teller) {
+	next = reizen_get_next_reizwert(&rs);
+	if (next && next <= limit) {
+	  a->type = ACTION_REIZEN_NUMBER;
+	  a->reizwert = next;
+	} else {
+	  a->type = ACTION_REIZEN_PASSE;
+	}
+  } else {
+	a->type = rs.reizwert <= limit ? ACTION_REIZEN_CONFIRM
+								   : ACTION_REIZEN_PASSE;
+  }
+  return 0;
+}
+
+static int
+bot_is_alleinspieler(const skat_client_state *const cs) {
+  return cs->sgs.alleinspieler >= 0
+		 && cs->sgs.alleinspieler == cs->my_active_player_index;
+}
+
+static int
+bot_is_my_card_turn(const skat_client_state *const cs) {
+  const stich *st = &cs->sgs.curr_stich;
+  return cs->sgs.active_players[(st->vorhand + st->played_cards) % 3]
+		 == cs->my_gupid;
+}
+
+int
+bot_wants_to_act(const skat_client_state *cs, int *result) {
+  switch (cs->sgs.cgphase) {
+	case GAME_PHASE_SETUP:
+	case GAME_PHASE_BETWEEN_ROUNDS:
+	  *result = 1;
+	  return 0;
+	case GAME_PHASE_REIZEN:
+	  *result = bot_is_my_reizen_turn(cs);
+	  return 0;
+	case GAME_PHASE_SKAT_AUFNEHMEN:
+	case GAME_PHASE_SPIELANSAGE:
+	  *result = bot_is_alleinspieler(cs);
+	  return 0;
+	case GAME_PHASE_PLAY_STICH_C1:
+	case GAME_PHASE_PLAY_STICH_C2:
+	case GAME_PHASE_PLAY_STICH_C3:
+	  *result = bot_is_my_card_turn(cs);
+	  return 0;
+	default:
+	  *result = 0;
+	  return 0;
+  }
+}
+
+static int
+bot_legal_moves(const skat_client_state *const cs,
+				card_collection *const legal) {
+  int result;
+  *legal = 0;
+  for (card_collection m = cs->my_hand; m; m &= m - 1) {
+	card_id cid = card_collection_id_from_index(__builtin_ctz(m));
+	if (stich_card_legal(&cs->sgs.gr, &cs->sgs.curr_stich, &cid, &cs->my_hand,
+						 &result))
+	  return 1;
+	if (result)
+	  *legal |= m & -m;
+  }
+  return !*legal;
+}
+
+// Fewest points first, then the lowest card
+static uint8_t
+bot_lowest_card(const card_collection legal) {
+  int best_score = INT_MAX, score;
+  uint8_t best = 0;
+  for (card_collection m = legal; m; m &= m - 1) {
+	uint8_t i = __builtin_ctz(m);
+	score = 8 * hand_eval_lane_points[i & 0b111u] + (i & 0b111u);
+	if (score < best_score) {
+	  best_score = score;
+	  best = i;
+	}
+  }
+  return best;
+}
+
+typedef struct bot_search {
+  const bot *b;
+  const skat_client_state *cs;
+  sampler s;
+  card_collection legal;
+  struct timespec deadline;
+  uint32_t samples_started;
+} bot_search;
+
+typedef struct bot_worker {
+  bot_search *bs;
+  solver *sv;
+  rng r;
+  uint32_t samples;
+  int64_t utility[32];// summed over samples, for the alleinspieler
+} bot_worker;
+
+static int
+bot_utility(const game_rules *const gr, const solver_result *const res) {
+  int v = res->alleinspieler_points;
+  if (gr->type == GAME_TYPE_NULL)
+	return res->alleinspieler_wins;
+  return v + (v > 60 ? 120 : 0) + (v >= 90 ? 30 : 0) - (v <= 30 ? 30 : 0);
+}
+
+static void
+bot_worker_run(void *args) {
+  bot_worker *w = args;
+  bot_search *bs = w->bs;
+  const skat_client_state *cs = bs->cs;
+  const card_tracker *k = &cs->tracker;
+  const uint32_t max_samples = bs->b->conf.max_samples;
+  solver_position pos, next;
+  solver_result res;
+  deal d;
+  unsigned int skat_points;
+  int64_t utility[32], left;
+
+  for (;;) {
+	if (max_samples
+		&& __atomic_fetch_add(&bs->samples_started, 1, __ATOMIC_RELAXED)
+				   >= max_samples)
+	  return;
+
+	memset(&pos, '\0', sizeof(pos));
+	if (sampler_draw(&bs->s, &w->r, &d))
+	  return;
+	memcpy(pos.hands, d.hands, sizeof(pos.hands));
+	pos.gr = cs->sgs.gr;
+	pos.alleinspieler = cs->sgs.alleinspieler;
+	pos.curr_stich = cs->sgs.curr_stich;
+	card_collection_get_score(&d.skat, &skat_points);
+	pos.alleinspieler_points = k->alleinspieler_points + skat_points;
+	pos.alleinspieler_stiche = k->alleinspieler_stiche;
+
+	for (card_collection m = bs->legal; m; m &= m - 1) {
+	  uint8_t i = __builtin_ctz(m);
+	  if ((left = deadline_millis_left(&bs->deadline)) <= 0)
+		return;
+	  next = pos;
+	  solver_limits limits = {.threads = 1,
+							  .max_millis = left,
+							  .eval_stiche = bs->b->conf.eval_stiche,
+							  .eval = bs->b->conf.eval};
+	  if (solver_position_play(&next, card_collection_id_from_index(i))
+		  || solver_solve_limited(w->sv, &next, &limits, &res)) {
+		DERROR_PRINTF("Solver rejected a sampled position");
+		return;
+	  }
+	  if (!res.complete)
+		return;
+	  utility[i] = bot_utility(&cs->sgs.gr, &res);
+	}
+
+	for (card_collection m = bs->legal; m; m &= m - 1)
+	  w->utility[__builtin_ctz(m)] += utility[__builtin_ctz(m)];
+	w->samples++;
+  }
+}
+
+static int
+bot_choose_card(bot *const b, const skat_client_state *const cs,
+				card_id *const cid) {
+  bot_worker workers[THREAD_POOL_MAX_THREADS];
+  bot_search bs;
+  int64_t utility[32] = {0}, best_utility = INT64_MIN;
+  uint32_t samples = 0;
+  int sign;
+  uint8_t best;
+
+  if (bot_legal_moves(cs, &bs.legal))
+	return 2;
+
+  best = bot_lowest_card(bs.legal);
+  if (!(bs.legal & (bs.legal - 1)) || cs->sgs.alleinspieler < 0
+	  || (cs->sgs.gr.type != GAME_TYPE_COLOR
+		  && cs->sgs.gr.type != GAME_TYPE_GRAND
+		  && cs->sgs.gr.type != GAME_TYPE_NULL)) {
+	*cid = card_collection_id_from_index(best);
+	return 0;
+  }
+
+  if (card_tracker_sampler(&cs->tracker, cs->my_hand, &bs.s)) {
+	DERROR_PRINTF("No deal is consistent with the game so far");
+	sampler_free(&bs.s);
+	*cid = card_collection_id_from_index(best);
+	return 0;
+  }
+  bs.b = b;
+  bs.cs = cs;
+  bs.samples_started = 0;
+  deadline_after_millis(&bs.deadline, b->conf.move_millis);
+
+  for (int t = 0; t < b->tp.thread_count; t++) {
+	memset(&workers[t], '\0', sizeof(workers[t]));
+	workers[t].bs = &bs;
+	workers[t].sv = &b->solvers[t];
+	rng_seed(&workers[t].r, rng_next_u64(&b->r));
+	thread_pool_submit(&b->tp, &(async_callback){.do_stuff = bot_worker_run,
+												 .data = &workers[t]});
+  }
+  thread_pool_wait(&b->tp);
+  sampler_free(&bs.s);
+
+  for (int t = 0; t < b->tp.thread_count; t++) {
+	samples += workers[t].samples;
+	for (int i = 0; i < 32; i++)
+	  utility[i] += workers[t].utility[i];
+  }
+
+  // The opponents of the alleinspieler minimize his utility
+  sign = bot_is_alleinspieler(cs) ? 1 : -1;
+  if (samples) {
+	for (card_collection m = bs.legal; m; m &= m - 1) {
+	  uint8_t i = __builtin_ctz(m);
+	  if (sign * utility[i] > best_utility) {
+		best_utility = sign * utility[i];
+		best = i;
+	  }
+	}
+  }
+
+  DEBUG_PRINTF("Bot chose card %u after %u samples", best, samples);
+  *cid = card_collection_id_from_index(best);
+  return 0;
+}
+
+int
+bot_rank_presses(bot *b, const skat_client_state *cs, uint64_t millis,
+				 press_option options[PRESS_OPTIMIZER_OPTIONS],
+				 size_t *length) {
+  press_query q = {.cards = cs->my_hand,
+				   .alleinspieler = cs->my_active_player_index,
+				   .reizwert = cs->sgs.rs.reizwert,
+				   .millis = millis,
+				   .eval_stiche = b->conf.eval_stiche,
+				   .eval = b->conf.eval};
+  if (cs->sgs.cgphase != GAME_PHASE_SKAT_AUFNEHMEN || !bot_is_alleinspieler(cs))
+	return 1;
+  return press_optimize(&b->tp, b->solvers, &b->r, &q, options, length);
+}
+
+static void
+bot_press(bot *const b, const skat_client_state *const cs,
+		  card_collection *const press) {
+  press_option options[PRESS_OPTIMIZER_OPTIONS];
+  size_t length;
+
+  if (!bot_rank_presses(b, cs, b->conf.move_millis, options, &length)
+	  && length) {
+	DEBUG_PRINTF("Bot presses for a game won in %u of %u deals",
+				 options[0].wins, options[0].samples);
+	b->planned_press = *press = options[0].press;
+	b->planned_gr = options[0].gr;
+	return;
+  }
+  hand_eval_choose_game(cs->my_hand, 1, 0, cs->sgs.rs.reizwert,
+						&b->planned_gr, press);
+  b->planned_press = *press;
+}
+
+int
+bot_decide(bot *b, const skat_client_state *cs, action *a) {
+  const card_tracker *k = &cs->tracker;
+  int act;
+  game_rules gr;
+  card_collection press;
+
+  memset(a, '\0', sizeof(*a));
+  if (bot_wants_to_act(cs, &act) || !act)
+	return 1;
+
+  switch (cs->sgs.cgphase) {
+	case GAME_PHASE_SETUP:
+	case GAME_PHASE_BETWEEN_ROUNDS:
+	  a->type = ACTION_READY;
+	  return 0;
+	case GAME_PHASE_REIZEN:
+	  return bot_reizen(b, cs, a);
+	case GAME_PHASE_SKAT_AUFNEHMEN:
+	  if (__builtin_popcount(cs->my_hand) <= 10) {
+		a->type = bot_plays_hand(b, cs) ? ACTION_SKAT_LEAVE : ACTION_SKAT_TAKE;
+		return 0;
+	  }
+	  bot_press(b, cs, &press);
+	  a->type = ACTION_SKAT_PRESS;
+	  a->skat_press_cards[0] =
+			  card_collection_id_from_index(__builtin_ctz(press));
+	  a->skat_press_cards[1] =
+			  card_collection_id_from_index(31 - __builtin_clz(press));
+	  return 0;
+	case GAME_PHASE_SPIELANSAGE:
+	  // The planned Hand game has no press
+	  if (k->skat == b->planned_press && cs->sgs.took_skat == !!k->skat)
+		gr = b->planned_gr;
+	  else
+		hand_eval_choose_game(cs->my_hand | k->skat, 0, k->skat,
+							  cs->sgs.rs.reizwert, &gr, &press);
+	  gr.hand = !cs->sgs.took_skat;
+	  a->type = ACTION_CALL_GAME;
+	  a->gr = gr;
+	  return 0;
+	case GAME_PHASE_PLAY_STICH_C1:
+	case GAME_PHASE_PLAY_STICH_C2:
+	case GAME_PHASE_PLAY_STICH_C3:
+	  a->type = ACTION_PLAY_CARD;
+	  return bot_choose_card(b, cs, &a->card);
+	default:
+	  return 1;
+  }
+}
+
+int
+bot_init(bot *b, const bot_config *conf) {
+  memset(b, '\0', sizeof(*b));
+  if (conf->threads < 1 || conf->threads > THREAD_POOL_MAX_THREADS
+	  || !conf->move_millis)
+	return 1;
+  b->conf = *conf;
+
+  if (conf->seed)
+	rng_seed(&b->r, conf->seed);
+  else if (rng_seed_random(&b->r))
+	return 2;
+
+  for (int t = 0; t < conf->threads; t++) {
+	if (solver_init(&b->solvers[t], BOT_TT_BITS)) {
+	  while (t--)
+		solver_free(&b->solvers[t]);
+	  return 2;
+	}
+	for (size_t i = 0; i < conf->tablebases_length; i++) {
+	  if (solver_use_tablebase(&b->solvers[t], &conf->tablebases[i])) {
+		for (t++; t--;)
+		  solver_free(&b->solvers[t]);
+		return 2;
+	  }
+	}
+  }
+
+  if (thread_pool_init(&b->tp, conf->threads, "bot")) {
+	for (int t = 0; t < conf->threads; t++)
+	  solver_free(&b->solvers[t]);
+	return 3;
+  }
+
+  if (bid_advisor_init(&b->ba, &b->tp, b->solvers, BID_ADVISOR_CACHE_BITS,
+					   rng_next_u64(&b->r))) {
+	bot_free(b);
+	return 4;
+  }
+  return 0;
+}
+
+void
+bot_free(bot *b) {
+  bid_advisor_free(&b->ba);
+  thread_pool_free(&b->tp);
+  for (int t = 0; t < b->conf.threads; t++)
+	solver_free(&b->solvers[t]);
+}
@@ -0,0 +1,156 @@
+#include "skat/canonical.h"
+
+#define CANONICAL_LANE_SIDE (0x7fu)// without the Bube
+#define CANONICAL_LANE_FULL (0xffu)
+#define CANONICAL_NO_LANE   (4)
+
+// Sets what moves, a color game keeps its trumpf lane in *fixed
+static int
+canonical_init(const game_rules *const gr, canonical_perm *const p,
+			   uint8_t *const fixed) {
+  *fixed = CANONICAL_NO_LANE;
+  switch (gr->type) {
+	case GAME_TYPE_COLOR:
+	  if (gr->trumpf < COLOR_KARO || gr->trumpf > COLOR_KREUZ)
+		return 1;
+	  *fixed = gr->trumpf - COLOR_KARO;
+	  p->lane_mask = CANONICAL_LANE_SIDE;
+	  return 0;
+	case GAME_TYPE_GRAND:
+	  p->lane_mask = CANONICAL_LANE_SIDE;
+	  return 0;
+	case GAME_TYPE_NULL:
+	  p->lane_mask = CANONICAL_LANE_FULL;
+	  return 0;
+	default:
+	  return 1;
+  }
+}
+
+// The trumpf goes to Kreuz, the other lanes by descending key to the
+// highest free lane. Lanes with equal keys hold the same cards, so their
+// order does not matter.
+static void
+canonical_sort(canonical_perm *const p, const uint8_t fixed,
+			   const uint64_t key[4]) {
+  uint8_t order[4], n = 0, top = 3;
+
+  if (fixed != CANONICAL_NO_LANE) {
+	p->lane[fixed] = COLOR_KREUZ - COLOR_KARO;
+	top--;
+  }
+  for (uint8_t l = 0; l < 4; l++) {
+	if (l == fixed)
+	  continue;
+	uint8_t i = n++;
+	for (; i > 0 && key[order[i - 1]] < key[l]; i--)
+	  order[i] = order[i - 1];
+	order[i] = l;
+  }
+  for (uint8_t i = 0; i < n; i++)
+	p->lane[order[i]] = top - i;
+}
+
+static game_rules
+canonical_rules(const game_rules *const gr) {
+  game_rules canon = *gr;
+  if (gr->type == GAME_TYPE_COLOR)
+	canon.trumpf = COLOR_KREUZ;
+  return canon;
+}
+
+int
+canonical_hand(const game_rules *gr, card_collection hand,
+			   card_collection *canon, canonical_perm *p,
+			   game_rules *canon_gr) {
+  uint64_t key[4];
+  uint8_t fixed;
+
+  if (canonical_init(gr, p, &fixed))
+	return 1;
+  for (int l = 0; l < 4; l++)
+	key[l] = (hand >> (8 * l)) & p->lane_mask;
+  canonical_sort(p, fixed, key);
+
+  *canon = canonical_apply(p, hand);
+  if (canon_gr)
+	*canon_gr = canonical_rules(gr);
+  return 0;
+}
+
+// Lanes are told apart by the cards of every hand and by the types of the
+// cards already in the stich, in the order they were played
+int
+canonical_position(const solver_position *pos, solver_position *canon,
+				   canonical_perm *p) {
+  uint64_t key[4] = {0};
+  uint8_t fixed;
+  card c;
+
+  if (canonical_init(&pos->gr, p, &fixed) || pos->curr_stich.played_cards < 0
+	  || pos->curr_stich.played_cards > 2)
+	return 1;
+  for (int l = 0; l < 4; l++)
+	for (int h = 0; h < 3; h++)
+	  key[l] |= (uint64_t) ((pos->hands[h] >> (8 * l)) & p->lane_mask)
+				<< (8 * h);
+  for (int i = 0; i < pos->curr_stich.played_cards; i++) {
+	if (card_get(&pos->curr_stich.cs[i], &c) || c.cc == COLOR_INVALID
+		|| c.ct == CARD_TYPE_INVALID)
+	  return 1;
+	if (c.ct == CARD_TYPE_B && p->lane_mask == CANONICAL_LANE_SIDE)
+	  continue;
+	key[c.cc - COLOR_KARO] |= (uint64_t) c.ct << (24 + 4 * i);
+  }
+  canonical_sort(p, fixed, key);
+
+  *canon = *pos;
+  canon->gr = canonical_rules(&pos->gr);
+  for (int h = 0; h < 3; h++)
+	canon->hands[h] = canonical_apply(p, pos->hands[h]);
+  for (int i = 0; i < pos->curr_stich.played_cards; i++)
+	canonical_apply_card(p, pos->curr_stich.cs[i], &canon->curr_stich.cs[i]);
+  return 0;
+}
+
+card_collection
+canonical_apply(const canonical_perm *p, card_collection col) {
+  card_collection out = col & ~(p->lane_mask * 0x01010101u);
+  for (int l = 0; l < 4; l++)
+	out |= ((col >> (8 * l)) & p->lane_mask) << (8 * p->lane[l]);
+  return out;
+}
+
+card_collection
+canonical_revert(const canonical_perm *p, card_collection col) {
+  card_collection out = col & ~(p->lane_mask * 0x01010101u);
+  for (int l = 0; l < 4; l++)
+	out |= ((col >> (8 * p->lane[l])) & p->lane_mask) << (8 * l);
+  return out;
+}
+
+int
+canonical_apply_card(const canonical_perm *p, card_id cid, card_id *out) {
+  card c;
+  if (card_get(&cid, &c) || c.cc == COLOR_INVALID)
+	return 1;
+  if (c.ct != CARD_TYPE_B || p->lane_mask == CANONICAL_LANE_FULL)
+	c.cc = p->lane[c.cc - COLOR_KARO] + COLOR_KARO;
+  return card_get_id(&c, out);
+}
+
+int
+canonical_revert_card(const canonical_perm *p, card_id cid, card_id *out) {
+  card c;
+  if (card_get(&cid, &c) || c.cc == COLOR_INVALID)
+	return 1;
+  if (c.ct != CARD_TYPE_B || p->lane_mask == CANONICAL_LANE_FULL) {
+	for (int l = 0; l < 4; l++) {
+	  if (p->lane[l] == c.cc - COLOR_KARO) {
+		c.cc = l + COLOR_KARO;
+		break;
+	  }
+	}
+  }
+  return card_get_id(&c, out);
+}
@@ -1,7 +1,8 @@
 #include "skat/card_collection.h"
+#include "skat/game_rules.h"
 #include "skat/util.h"
 
-static int
+int
 card_collection_index_from_id(const card_id *const cid,
 							  uint8_t *const result_index) {
   card c;
@@ -13,12 +14,15 @@ card_collection_index_from_id(const card_id *const cid,
   return 0;
 }
 
-static int
-card_collection_id_from_index(const uint8_t *const card_index,
-							  card_id *const result_cid) {
-  card c = (card){.ct = (*card_index & 0b111u) + 1,
-				  .cc = ((*card_index & 0b11000u) >> 3u) + 1};
-  return card_get_id(&c, result_cid);
+card_id
+card_collection_id_from_index(const uint8_t card_index) {
+  card_id cid = 0;
+  if (card_index >= 32)
+	return 0;
+  card_get_id(&(card){.ct = (card_index & 0b111u) + 1,
+					  .cc = ((card_index & 0b11000u) >> 3u) + 1},
+			  &cid);
+  return cid;
 }
 
 static int
@@ -120,56 +124,36 @@ card_collection_get_card_count(const card_collection *const col,
   return 0;
 }
 
-// XXX: very inefficient
 int
 card_collection_get_card(const card_collection *const col,
 						 const uint8_t *const idx, card_id *const result_cid) {
-  unsigned int found = 0;
-
-  for (uint8_t card_index = 0; card_index < 32; card_index++) {
-	int result;
-	int error = card_collection_contains_index(col, &card_index, &result);
-	if (error)
-	  return 1;
+  card_collection rest = *col;
+  for (uint8_t i = 0; i < *idx && rest; i++)
+	rest &= rest - 1;
 
-	if (result && found++ == *idx) {
-	  error = card_collection_id_from_index(&card_index, result_cid);
-	  if (error)
-		return 2;
-	  return 0;
-	}
-  }
+  if (!rest)
+	return 3;
 
-  return 3;
+  *result_cid = card_collection_id_from_index(__builtin_ctz(rest));
+  return 0;
 }
 
 int
 card_collection_get_score(const card_collection *const col,
 						  unsigned int *const score) {
-  unsigned int total_score = 0;
-
-  for (uint8_t card_index = 0; card_index < 32; card_index++) {
-	int result;
-	int error = card_collection_contains_index(col, &card_index, &result);
-	if (error)
-	  return 1;
-
-	if (result) {
-	  card_id cid;
-	  error = card_collection_id_from_index(&card_index, &cid);
-	  if (error)
-		return 2;
-
-	  uint8_t card_score;
-	  card_get_score(&cid, &card_score);
-	  total_score += card_score;
-	}
-  }
-
-  *score = total_score;
+  *score = card_collection_points(*col);
   return 0;
 }
 
+unsigned int
+card_collection_points(const card_collection col) {
+  return 11 * __builtin_popcount(col & CARD_MASK_ASS)
+		 + 10 * __builtin_popcount(col & CARD_MASK_ZEHN)
+		 + 4 * __builtin_popcount(col & CARD_MASK_KOENIG)
+		 + 3 * __builtin_popcount(col & CARD_MASK_DAME)
+		 + 2 * __builtin_popcount(col & CARD_MASK_BUBEN);
+}
+
 int
 card_collection_empty(card_collection *const col) {
   *col = 0;
@@ -201,3 +185,164 @@ card_collection_draw_random(card_collection const *const col,
 
   return 0;
 }
+
+// 0: id, 1: pregame hand, 2-9: ingame hand, 10-17: stiche
+#define CARD_SORT_RULES_SLOTS (8)
+#define CARD_SORT_TABLES      (2 + 2 * CARD_SORT_RULES_SLOTS)
+
+// key: card index -> rank, order: rank -> card id
+static uint8_t card_sort_keys[CARD_SORT_TABLES][32];
+static card_id card_sort_order[CARD_SORT_TABLES][32];
+
+static int
+card_sort_rules_slot(const game_rules *const gr, uint8_t *const slot) {
+  switch (gr->type) {
+	case GAME_TYPE_INVALID:
+	  *slot = 0;
+	  return 0;
+	case GAME_TYPE_COLOR:
+	  if (gr->trumpf >= COLOR_KARO && gr->trumpf <= COLOR_KREUZ)
+		*slot = gr->trumpf;// 1-4
+	  else
+		*slot = 5;// sorts like grand
+	  return 0;
+	case GAME_TYPE_GRAND:
+	  *slot = 5;
+	  return 0;
+	case GAME_TYPE_NULL:
+	  *slot = 6;
+	  return 0;
+	case GAME_TYPE_RAMSCH:
+	  *slot = 7;
+	  return 0;
+	default:
+	  return 1;
+  }
+}
+
+static int
+card_sort_table_index(const card_sort_mode mode, const game_rules *const gr,
+					  uint8_t *const table) {
+  uint8_t slot;
+  switch (mode) {
+	case CARD_SORT_MODE_ID:
+	  *table = 0;
+	  return 0;
+	case CARD_SORT_MODE_PREGAME_HAND:
+	  *table = 1;
+	  return 0;
+	case CARD_SORT_MODE_INGAME_HAND:
+	  if (card_sort_rules_slot(gr, &slot))
+		return 1;
+	  *table = 2 + slot;
+	  return 0;
+	case CARD_SORT_MODE_STICHE:
+	  if (card_sort_rules_slot(gr, &slot))
+		return 1;
+	  *table = 2 + CARD_SORT_RULES_SLOTS + slot;
+	  return 0;
+	default:
+	  return 2;
+  }
+}
+
+static void
+card_sort_build_table(const uint8_t table, const card_sort_mode mode,
+					  const game_rules *const gr) {
+  card_compare_args args = (card_compare_args){.gr = gr, .mode = &mode};
+  card_id ids[32];
+
+  // insertion sort, ties (e.g. the buben in hand order) are broken by index
+  for (uint8_t i = 0; i < 32; i++) {
+	card_id cid = card_collection_id_from_index(i);
+
+	int j = i;
+	while (j > 0 && card_compare(&ids[j - 1], &cid, &args) > 0) {
+	  ids[j] = ids[j - 1];
+	  j--;
+	}
+	ids[j] = cid;
+  }
+
+  for (uint8_t rank = 0; rank < 32; rank++) {
+	uint8_t card_index;
+	if (card_collection_index_from_id(&ids[rank], &card_index)) {
+	  DERROR_PRINTF("Could not build card sort table %d", table);
+	  return;
+	}
+	card_sort_keys[table][card_index] = rank;
+	card_sort_order[table][rank] = ids[rank];
+  }
+}
+
+__attribute__((constructor)) static void
+card_sort_init_tables(void) {
+  static const game_rules slot_rules[CARD_SORT_RULES_SLOTS] = {
+		  {.type = GAME_TYPE_INVALID},
+		  {.type = GAME_TYPE_COLOR, .trumpf = COLOR_KARO},
+		  {.type = GAME_TYPE_COLOR, .trumpf = COLOR_HERZ},
+		  {.type = GAME_TYPE_COLOR, .trumpf = COLOR_PIK},
+		  {.type = GAME_TYPE_COLOR, .trumpf = COLOR_KREUZ},
+		  {.type = GAME_TYPE_GRAND},
+		  {.type = GAME_TYPE_NULL},
+		  {.type = GAME_TYPE_RAMSCH}};
+
+  card_sort_build_table(0, CARD_SORT_MODE_ID, &slot_rules[0]);
+  card_sort_build_table(1, CARD_SORT_MODE_PREGAME_HAND, &slot_rules[0]);
+  for (uint8_t slot = 0; slot < CARD_SORT_RULES_SLOTS; slot++) {
+	card_sort_build_table(2 + slot, CARD_SORT_MODE_INGAME_HAND,
+						  &slot_rules[slot]);
+	card_sort_build_table(2 + CARD_SORT_RULES_SLOTS + slot,
+						  CARD_SORT_MODE_STICHE, &slot_rules[slot]);
+  }
+}
+
+static card_collection
+card_sort_permute(const card_collection col, const uint8_t *const keys) {
+  card_collection permuted = 0;
+  for (card_collection rest = col; rest; rest &= rest - 1)
+	permuted |= 0b1u << keys[__builtin_ctz(rest)];
+  return permuted;
+}
+
+// result_cids has to hold up to 32 cards
+int
+card_collection_get_sorted(const card_collection *const col,
+						   const card_sort_mode mode,
+						   const game_rules *const gr,
+						   card_id *const result_cids,
+						   uint8_t *const result_count) {
+  uint8_t table;
+  if (card_sort_table_index(mode, gr, &table))
+	return 1;
+
+  card_collection permuted = card_sort_permute(*col, card_sort_keys[table]);
+
+  uint8_t count = 0;
+  for (; permuted; permuted &= permuted - 1)
+	result_cids[count++] = card_sort_order[table][__builtin_ctz(permuted)];
+
+  *result_count = count;
+  return 0;
+}
+
+// position of the card within the sorted collection, e.g. for hand layouts
+int
+card_collection_get_sort_position(const card_collection *const col,
+								  const card_id *const cid,
+								  const card_sort_mode mode,
+								  const game_rules *const gr,
+								  uint8_t *const result_position) {
+  uint8_t table, card_index;
+  if (card_sort_table_index(mode, gr, &table))
+	return 1;
+  if (card_collection_index_from_id(cid, &card_index))
+	return 2;
+
+  const uint8_t *const keys = card_sort_keys[table];
+  card_collection permuted = card_sort_permute(*col, keys);
+
+  *result_position =
+		  __builtin_popcount(permuted & ((0b1u << keys[card_index]) - 1));
+  return 0;
+}
@@ -2,7 +2,6 @@
 #include "skat/skat.h"
 #include "skat/util.h"
 #include <stdio.h>
-#include <stdlib.h>
 
 #define RED_CARD_COLOR     "\e[31;1m"
 #define BLACK_CARD_COLOR   "\e[30;1m"
@@ -60,26 +59,10 @@ print_card_collection(const shared_game_state *const sgs,
 					  const card_collection *const cc,
 					  const card_sort_mode sort_mode,
 					  const card_color_mode color_mode) {
+  card_id cid_array[32];
   uint8_t count;
-  if (card_collection_get_card_count(cc, &count))
+  if (card_collection_get_sorted(cc, sort_mode, &sgs->gr, cid_array, &count))
 	return;
 
-  card_id cid_array[count];// VLAaaaaaaaaaaaaaaaahhhhhhhhhhhh
-
-  uint8_t j = 0;
-  for (uint8_t i = 0; i < count; i++) {
-	card_id cid;
-	if (card_collection_get_card(cc, &i, &cid))
-	  continue;
-
-	cid_array[j++] = cid;
-  }
-
-  card_compare_args args =
-		  (card_compare_args){.gr = &sgs->gr, .mode = &sort_mode};
-
-  qsort_r(cid_array, j, sizeof(card_id),
-		  (int (*)(const void *, const void *, void *)) card_compare, &args);
-
-  print_card_array(sgs, cc, cid_array, j, color_mode);
+  print_card_array(sgs, cc, cid_array, count, color_mode);
 }
@@ -0,0 +1,117 @@
+#include "skat/card_tracker.h"
+#include "skat/skat.h"
+#include "skat/stich.h"
+#include <string.h>
+
+static void
+card_tracker_remove(card_tracker *const t, const card_collection cards,
+					const int keep) {
+  for (int p = 0; p < SAMPLER_PLACES; p++)
+	if (p != keep)
+	  t->possible[p] &= ~cards;
+}
+
+void
+card_tracker_reset(card_tracker *t, int me, card_collection hand) {
+  memset(t, '\0', sizeof(*t));
+  t->me = me < 0 || me > 2 ? -1 : me;
+  for (int p = 0; p < SAMPLER_PLACES; p++)
+	t->possible[p] = t->me < 0 ? ~0u : ~hand;
+  if (t->me >= 0)
+	t->possible[t->me] = hand;
+}
+
+int
+card_tracker_observe(card_tracker *t, const skat_client_state *cs,
+					 const event *e) {
+  const int as = cs->sgs.alleinspieler;
+  const stich *st;
+  card_collection cards = 0, follow;
+  unsigned int score;
+  int ap;
+
+  switch (e->type) {
+	case EVENT_DISTRIBUTE_CARDS:
+	  card_tracker_reset(t, cs->my_active_player_index, cs->my_hand);
+	  return 0;
+	case EVENT_SKAT_TAKE:
+	  if (as < 0 || as > 2)
+		return 1;
+	  if (as == t->me) {
+		if (card_collection_add_card_array(&cards, e->skat, 2))
+		  return 1;
+		card_tracker_remove(t, cards, as);
+		t->possible[as] |= cards;
+	  } else {
+		t->possible[as] |= t->possible[SAMPLER_SKAT];
+	  }
+	  // Empty until the alleinspieler presses
+	  t->possible[SAMPLER_SKAT] = 0;
+	  return 0;
+	case EVENT_SKAT_PRESS:
+	  if (as < 0 || as > 2)
+		return 1;
+	  if (as == t->me) {
+		if (card_collection_add_card_array(&cards, e->skat_press_cards, 2))
+		  return 1;
+		t->possible[as] &= ~cards;
+		t->skat = cards;
+		t->possible[SAMPLER_SKAT] = cards;
+	  } else {
+		t->possible[SAMPLER_SKAT] = t->possible[as];
+	  }
+	  return 0;
+	case EVENT_PLAY_CARD:
+	  st = &cs->sgs.curr_stich;
+	  if (st->played_cards < 1 || card_collection_add_card(&cards, &e->card))
+		return 1;
+	  ap = (st->vorhand + st->played_cards - 1) % 3;
+	  card_tracker_remove(t, cards, -1);
+	  t->played[ap] |= cards;
+	  if (st->played_cards > 1) {
+		if (stich_get_bekennen_mask(&cs->sgs.gr, &st->cs[0], &follow))
+		  return 1;
+		if (!(cards & follow)) {
+		  t->voids[ap] |= follow;
+		  t->possible[ap] &= ~follow;
+		}
+	  }
+	  return 0;
+	case EVENT_STICH_DONE:
+	  st = &cs->sgs.last_stich;
+	  if (as < 0 || st->winner != as)
+		return 0;
+	  card_collection_add_card_array(&cards, st->cs, 3);
+	  card_collection_get_score(&cards, &score);
+	  t->alleinspieler_points += score;
+	  t->alleinspieler_stiche++;
+	  return 0;
+	default:
+	  return 0;
+  }
+}
+
+card_collection
+card_tracker_unseen(const card_tracker *t) {
+  card_collection unseen = 0;
+  for (int p = 0; p < SAMPLER_PLACES; p++)
+	if (p != t->me)
+	  unseen |= t->possible[p];
+  return unseen;
+}
+
+int
+card_tracker_sampler(const card_tracker *t, card_collection hand,
+					 sampler *s) {
+  sampler_init(s);
+  if (t->me < 0)
+	return 1;
+  for (int p = 0; p < 3; p++)
+	if (sampler_set_played(s, p, t->played[p])
+		|| sampler_set_void(s, p, ~t->possible[p]))
+	  return 1;
+  if (sampler_set_known(s, t->me, hand)
+	  || sampler_set_known(s, SAMPLER_SKAT, t->skat))
+	return 1;
+  return sampler_prepare(s);
+}
@@ -0,0 +1,82 @@
+#include "skat/claim.h"
+
+// Card points at which the outcome changes: won, Schneider
+static const int claim_thresholds[3] = {0, 61, 90};
+
+static int
+claim_level(const int points) {
+  return (points >= claim_thresholds[1]) + (points >= claim_thresholds[2]);
+}
+
+int
+claim_outcome_fixed(solver *sv, const solver_position *pos, uint64_t max_nodes,
+					int *fixed) {
+  const solver_limits limits = {.threads = 1, .max_nodes = max_nodes};
+  card_collection rest;
+  unsigned int rest_points;
+  uint8_t left;
+  int low, high, reached, complete;
+
+  *fixed = 0;
+  if (pos->alleinspieler < 0 || pos->alleinspieler > 2
+	  || pos->curr_stich.played_cards)
+	return 1;
+  if (card_collection_get_card_count(&pos->hands[pos->alleinspieler], &left))
+	return 1;
+  if (!left) {
+	*fixed = 1;
+	return 0;
+  }
+
+  if (pos->gr.type == GAME_TYPE_NULL) {
+	if (pos->alleinspieler_stiche) {
+	  *fixed = 1;
+	  return 0;
+	}
+	// Won whatever happens, or lost whatever happens
+	for (int every = 1; every >= 0; every--) {
+	  if (solver_lines_reach_limited(sv, pos, 0, every, &limits, &reached,
+									 &complete))
+		return 1;
+	  if (!complete)
+		return 0;
+	  if (reached == every) {
+		*fixed = 1;
+		return 0;
+	  }
+	}
+	return 0;
+  }
+  if (pos->gr.type != GAME_TYPE_COLOR && pos->gr.type != GAME_TYPE_GRAND)
+	return 1;
+
+  rest = pos->hands[0] | pos->hands[1] | pos->hands[2];
+  if (card_collection_get_score(&rest, &rest_points))
+	return 1;
+  low = claim_level(pos->alleinspieler_points);
+  high = claim_level(pos->alleinspieler_points + rest_points);
+
+  for (; low < high; low++) {
+	if (solver_lines_reach_limited(sv, pos, claim_thresholds[low + 1], 1,
+								   &limits, &reached, &complete))
+	  return 1;
+	if (!complete)
+	  return 0;
+	if (!reached)
+	  break;
+  }
+  for (; high > low; high--) {
+	if (solver_lines_reach_limited(sv, pos, claim_thresholds[high], 0,
+								   &limits, &reached, &complete))
+	  return 1;
+	if (!complete)
+	  return 0;
+	if (reached)
+	  break;
+  }
+
+  // Schwarz stays open until the opponents take a stich
+  *fixed = low == high
+		   && (high < 2 || pos->alleinspieler_stiche < 10 - left);
+  return 0;
+}
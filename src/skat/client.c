@@ -233,6 +233,70 @@ client_call_general_io_handler(client *c, event *e) {
 							.data = ioargs});
 }
 
+typedef struct {
+  client_action_callback_hdr hdr;
+} client_bot_callback_args;
+
+static void
+client_bot_callback(void *v) {
+  client_bot_callback_args *args = v;
+  client *c = args->hdr.c;
+
+  client_acquire_state_lock(c);
+  if (args->hdr.e.type == EVENT_ILLEGAL_ACTION) {
+	DERROR_PRINTF("The server rejected an action of the bot, retrying later");
+	c->bot_wait_ticks = CLIENT_REFRESH_RATE;
+  }
+  c->bot_busy = 0;
+  client_release_state_lock(c);
+
+  free(args);
+}
+
+// Runs on the async thread, so the tick never waits for the bot
+static void
+client_bot_decide(void *v) {
+  client *c = v;
+  skat_client_state cs;
+  client_action_callback cac;
+  action a;
+
+  client_acquire_state_lock(c);
+  cs = c->cs;
+  client_release_state_lock(c);
+
+  if (bot_decide(c->b, &cs, &a)) {
+	client_acquire_state_lock(c);
+	c->bot_busy = 0;
+	client_release_state_lock(c);
+	return;
+  }
+
+  cac.f = client_bot_callback;
+  cac.args = malloc(sizeof(client_bot_callback_args));
+  a.id = ll_client_action_callback_insert(&c->ll_cac, &cac);
+  DEBUG_PRINTF("Enqueueing %s action of the bot", action_name_table[a.type]);
+  conn_enqueue_action(&c->c2s.c, &a);
+}
+
+static void
+client_bot_tick(client *c) {
+  int act;
+
+  if (!c->b || c->bot_busy)
+	return;
+  if (c->bot_wait_ticks > 0) {
+	c->bot_wait_ticks--;
+	return;
+  }
+  if (bot_wants_to_act(&c->cs, &act) || !act)
+	return;
+
+  c->bot_busy = 1;
+  exec_async(&c->acq,
+			 &(async_callback){.do_stuff = client_bot_decide, .data = c});
+}
+
 void
 client_tick(client *c) {
   DPRINTF_COND(DEBUG_TICK, "Client tick");
@@ -256,6 +320,7 @@ client_tick(client *c) {
 	  client_call_general_io_handler(c, &e);
   }
   skat_client_state_tick(&c->cs, c);
+  client_bot_tick(c);
 
   client_release_state_lock(c);
 }
@@ -415,13 +480,8 @@ client_handle_resync(client *c, payload_resync *pl) {
 
 	size_t len = pl->player_name_lengths[i];
 	if (len > 0) {
-	  c->pls[i] = malloc(sizeof(player) + len + 1);
-	  c->pls[i]->gupid = i;
-	  c->pls[i]->ap = pl->active_player_indices[i];
-	  c->pls[i]->name_length = len;
-
-	  memcpy(c->pls[i]->name, pl->player_names + offset, len * sizeof(char));
-	  c->pls[i]->name[len] = '\0';
+	  c->pls[i] = create_player_n(i, pl->active_player_indices[i],
+								  pl->player_names + offset, len);
 	  offset += len;
 	} else {
 	  c->pls[i] = NULL;
@@ -521,6 +581,12 @@ client_init(client *c, char *host, int port, char *name) {
   client_start_interrupt_handler_thread(c);
 }
 
+// The bot plays every action of this client, the console only watches
+void
+client_use_bot(client *c, bot *b) {
+  c->b = b;
+}
+
 static void
 client_tick_wrap(void *c) {
   client_tick(c);
@@ -538,7 +604,8 @@ client_run(client *c, int resume) {
   client_acquire_state_lock(c);
   start_client_conn(c, c->host, c->port, resume);
   start_exec_async_thread(c);
-  start_io_thread(c);
+  if (!c->b)
+	start_io_thread(c);
   client_release_state_lock(c);
 
   ctimer_run(&t);
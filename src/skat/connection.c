@@ -161,14 +161,13 @@ establish_connection_server(server *s, int fd, pthread_t handler) {
 	CH_ASSERT(s2c = server_get_free_connection(s, &gupid), &c,
 			  CONN_ERROR_TOO_MANY_PLAYERS, err_release);
 
-	player *pl = create_player(gupid, -1, pl_join->name);
+	CH_ASSERT(!server_add_player_for_connection(s, pl_join->name, gupid), &c,
+			  CONN_ERROR_PLAYER_DIRECTORY_FULL, err_release);
 
 	init_conn_s2c(s2c, &c);
 	s2c->c.active = 1;
 	s2c->gupid = gupid;
 
-	server_add_player_for_connection(s, pl, gupid);
-
 	server_notify_join(s, gupid);
 
 	server_release_state_lock(s);
@@ -436,10 +435,21 @@ conn_handle_incoming_packages_server_single(server *s, connection_s2c *c,
   __label__ err;
   int still_connected;
   payload_action *pl_ac;
+  event err_ev;
 
   switch (p->type) {
 	case PACKAGE_ACTION:// server distributes events and receives actions
 	  pl_ac = p->payload.pl_a;
+	  if (server_prefilter_action(s, c->gupid, &pl_ac->ac)) {
+		DEBUG_PRINTF("Rejecting action with id %ld from gupid %d before "
+					 "queueing it",
+					 pl_ac->ac.id, c->gupid);
+		err_ev.type = EVENT_ILLEGAL_ACTION;
+		err_ev.answer_to = pl_ac->ac.id;
+		err_ev.acting_player = c->gupid;
+		conn_enqueue_event(&c->c, &err_ev);
+		break;
+	  }
 	  conn_enqueue_action(&c->c, &pl_ac->ac);
 	  break;
 	case PACKAGE_RESYNC:
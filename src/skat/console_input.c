@@ -5,6 +5,7 @@
 #include "skat/game_rules.h"
 #include "skat/player.h"
 #include "skat/util.h"
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -640,6 +641,127 @@ execute_print_info(client *c) {
   exec_async(&c->acq, &acb);
 }
 
+/* Begin execute suggest logic
+   -------------------------------- */
+
+static void
+print_suggest_exec(void *p) {
+  struct client_suggest_args *args = p;
+  client *c = args->c;
+  press_option options[PRESS_OPTIMIZER_OPTIONS];
+  skat_client_state cs;
+  size_t length;
+  bot *b = c->b;
+
+  client_acquire_state_lock(c);
+  cs = c->cs;
+  client_release_state_lock(c);
+
+  // Without a bot of our own, rank with every core
+  if (!b) {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	bot_config conf = {
+			.threads = cores < 1 ? 1 : MIN(cores, THREAD_POOL_MAX_THREADS),
+			.move_millis = args->millis};
+	b = malloc(sizeof(*b));
+	if (!b || bot_init(b, &conf)) {
+	  printf("--\nCould not start the search\n> ");
+	  goto end;
+	}
+  }
+
+  printf("--\nThinking for %" PRIu64 " ms...\n", args->millis);
+  fflush(stdout);
+  if (bot_rank_presses(b, &cs, args->millis, options, &length)) {
+	printf("Nothing to suggest, there is no skat to press\n> ");
+	goto end;
+  }
+
+  printf("Best presses:\n");
+  for (size_t i = 0; i < length && i < SUGGEST_LINES; i++) {
+	printf("%2zu. won %u of %u deals with", i + 1, options[i].wins,
+		   options[i].samples);
+	print_card_collection(&cs.sgs, &options[i].press, CARD_SORT_MODE_ID,
+						  CARD_COLOR_MODE_ONLY_CARD_COLOR);
+	printf(" pressed. ");
+	print_game_rules_info(&options[i].gr);
+	printf("\n");
+  }
+  printf("> ");
+
+end:
+  fflush(stdout);
+  if (b && b != c->b) {
+	bot_free(b);
+	free(b);
+  }
+  free(args);
+}
+
+static void
+execute_suggest(client *c, uint64_t millis) {
+  async_callback acb;
+  struct client_suggest_args *args;
+
+  args = malloc(sizeof(*args));
+  args->c = c;
+  args->millis = millis;
+
+  acb = (async_callback){.do_stuff = print_suggest_exec, .data = args};
+
+  exec_async(&c->acq, &acb);
+}
+
+/* --------------------------------
+   End execute suggest logic */
+
+/* Begin execute remaining logic
+   -------------------------------- */
+
+static void
+print_remaining_exec(void *p) {
+  client *c = p;
+  const card_tracker *t = &c->cs.tracker;
+  card_collection unseen;
+
+  client_acquire_state_lock(c);
+
+  unseen = card_tracker_unseen(t);
+  printf("--\nUnseen cards (%d):", __builtin_popcount(unseen));
+  print_card_collection(&c->cs.sgs, &unseen, CARD_SORT_MODE_INGAME_HAND,
+						CARD_COLOR_MODE_ONLY_CARD_COLOR);
+  printf("\n");
+  for (int ap = 0; ap < 3; ap++) {
+	if (ap == t->me || c->cs.sgs.active_players[ap] < 0)
+	  continue;
+	printf("%s may hold:", player_name_lookup(ap));
+	print_card_collection(&c->cs.sgs, &t->possible[ap],
+						  CARD_SORT_MODE_INGAME_HAND,
+						  CARD_COLOR_MODE_ONLY_CARD_COLOR);
+	printf("\n");
+  }
+  printf("Skat may hold:");
+  print_card_collection(&c->cs.sgs, &t->possible[SAMPLER_SKAT],
+						CARD_SORT_MODE_INGAME_HAND,
+						CARD_COLOR_MODE_ONLY_CARD_COLOR);
+  printf("\n> ");
+  fflush(stdout);
+
+  client_release_state_lock(c);
+}
+
+static void
+execute_remaining(client *c) {
+  async_callback acb;
+
+  acb = (async_callback){.do_stuff = print_remaining_exec, .data = c};
+
+  exec_async(&c->acq, &acb);
+}
+
+/* --------------------------------
+   End execute remaining logic */
+
 void
 io_handle_event(client *c, event *e) {
   char buf[4];
@@ -716,6 +838,10 @@ io_handle_event(client *c, event *e) {
 		print_player_turn(c, PRINT_PLAYER_TURN_SHOW_HAND_MODE_DEFAULT);
 	  }
 	  break;
+	case EVENT_ROUND_CLAIMED:
+	  printf("Nothing can change the outcome any more, the rest of the round "
+			 "is not played.");
+	  break;
 	case EVENT_ANNOUNCE_SCORES:
 	  print_event_announce(c, e);
 	  break;
@@ -945,6 +1071,27 @@ handle_console_input(void *v) {
 	  }
 	}
 
+	// suggest [millis]
+	else if (!command_equals(cmd, &result, 1, "suggest") && result) {
+	  uint64_t millis = SUGGEST_DEFAULT_MILLIS;
+	  if (cmd->args_length > 1
+		  || (cmd->args_length == 1
+			  && command_parse_arg_u64(cmd, 1, 0, 1, 600000, &millis)))
+		printf("Usage: suggest [millis]\n");
+	  else
+		execute_suggest(c, millis);
+	}
+
+	// remaining
+	else if (!command_equals(cmd, &result, 1, "remaining") && result) {
+	  if (command_check_arg_length(cmd, 0, &result) || !result) {
+		printf("Expected exactly 0 args for remaining, but got %zu\n",
+			   cmd->args_length);
+	  } else {
+		execute_remaining(c);
+	  }
+	}
+
 	// exit
 	else if (!command_equals(cmd, &result, 2, "exit", "quit") && result) {
 	  if (command_check_arg_length(cmd, 0, &result) || !result) {
@@ -965,6 +1112,8 @@ handle_console_input(void *v) {
 	  printf("\tspiel\n");
 	  printf("\tplay\n");
 	  printf("\tinfo\n");
+	  printf("\tsuggest\n");
+	  printf("\tremaining\n");
 	  printf("\texit\n");
 	}
 
@@ -0,0 +1,254 @@
+#include "skat/deal.h"
+#include "skat/util.h"
+
+// One Fisher-Yates shuffle of the card indices, the first three runs of ten
+// cards are the hands and the last two are the skat.
+int
+deal_random(deal *const d, rng *const r) {
+  uint8_t deck[32];
+  for (uint8_t i = 0; i < 32; i++)
+	deck[i] = i;
+
+  for (uint8_t i = 31; i > 0; i--) {
+	uint8_t j = rng_bounded_u32(r, i + 1);
+	uint8_t tmp = deck[i];
+	deck[i] = deck[j];
+	deck[j] = tmp;
+  }
+
+  card_collection hands[3] = {0, 0, 0};
+  for (uint8_t i = 0; i < 30; i++)
+	hands[i / 10] |= 0b1u << deck[i];
+
+  d->hands[0] = hands[0];
+  d->hands[1] = hands[1];
+  d->hands[2] = hands[2];
+  d->skat = (0b1u << deck[30]) | (0b1u << deck[31]);
+
+  return 0;
+}
+
+int
+deal_get_skat(const deal *const d, card_id skat[2]) {
+  for (uint8_t i = 0; i < 2; i++) {
+	if (card_collection_get_card(&d->skat, &i, &skat[i])) {
+	  DERROR_PRINTF("Skat %#x of deal does not contain two cards", d->skat);
+	  return 1;
+	}
+  }
+  return 0;
+}
+
+int
+deal_is_valid(const deal *const d) {
+  return __builtin_popcount(d->hands[0]) == 10
+		 && __builtin_popcount(d->hands[1]) == 10
+		 && __builtin_popcount(d->hands[2]) == 10
+		 && __builtin_popcount(d->skat) == 2
+		 && (d->hands[0] | d->hands[1] | d->hands[2] | d->skat) == 0xffffffffu;
+}
+
+// binomial coefficients C(n, k) for n <= 32, k <= 10
+static uint64_t deal_binomials[33][11];
+
+__attribute__((constructor)) static void
+deal_init_binomials(void) {
+  for (int n = 0; n <= 32; n++) {
+	deal_binomials[n][0] = 1;
+	for (int k = 1; k <= 10; k++)
+	  deal_binomials[n][k] =
+			  n == 0 ? 0
+					 : deal_binomials[n - 1][k - 1] + deal_binomials[n - 1][k];
+  }
+}
+
+uint64_t
+deal_binomial(const int n, const int k) {
+  if (n < 0 || n > 32 || k < 0 || k > 10)
+	return 0;
+  return deal_binomials[n][k];
+}
+
+// Rank of subset among the k-subsets of the set bits of from (colex order)
+uint64_t
+deal_subset_rank(const card_collection subset, const card_collection from) {
+  uint64_t rank = 0;
+  int i = 1;
+  for (card_collection rest = subset; rest; rest &= rest - 1, i++) {
+	card_collection below = (rest & -rest) - 1;
+	rank += deal_binomials[__builtin_popcount(from & below)][i];
+  }
+  return rank;
+}
+
+card_collection
+deal_subset_unrank(uint64_t rank, const int k, const card_collection from) {
+  uint8_t from_indices[32];
+  int n = 0;
+  for (card_collection rest = from; rest; rest &= rest - 1)
+	from_indices[n++] = __builtin_ctz(rest);
+
+  card_collection subset = 0;
+  int c = n - 1;
+  for (int i = k; i > 0; i--) {
+	while (deal_binomials[c][i] > rank)
+	  c--;
+	rank -= deal_binomials[c][i];
+	subset |= 0b1u << from_indices[c--];
+  }
+  return subset;
+}
+
+int
+deal_to_rank(const deal *const d, uint64_t *const rank) {
+  if (!deal_is_valid(d))
+	return 1;
+
+  card_collection rest = 0xffffffffu;
+  uint64_t r0 = deal_subset_rank(d->hands[0], rest);
+  rest &= ~d->hands[0];
+  uint64_t r1 = deal_subset_rank(d->hands[1], rest);
+  rest &= ~d->hands[1];
+  uint64_t r2 = deal_subset_rank(d->hands[2], rest);
+
+  *rank = (r0 * deal_binomials[22][10] + r1) * deal_binomials[12][10] + r2;
+  return 0;
+}
+
+int
+deal_from_rank(uint64_t rank, deal *const d) {
+  if (rank >= DEAL_RANK_COUNT)
+	return 1;
+
+  uint64_t r2 = rank % deal_binomials[12][10];
+  rank /= deal_binomials[12][10];
+  uint64_t r1 = rank % deal_binomials[22][10];
+  uint64_t r0 = rank / deal_binomials[22][10];
+
+  card_collection rest = 0xffffffffu;
+  d->hands[0] = deal_subset_unrank(r0, 10, rest);
+  rest &= ~d->hands[0];
+  d->hands[1] = deal_subset_unrank(r1, 10, rest);
+  rest &= ~d->hands[1];
+  d->hands[2] = deal_subset_unrank(r2, 10, rest);
+  d->skat = rest & ~d->hands[2];
+
+  return 0;
+}
+
+// Crockford's base32, most significant digit first
+static const char *const DEAL_TEXT_DIGITS = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+
+// str has to hold DEAL_TEXT_LENGTH + 1 chars
+int
+deal_to_text(const deal *const d, char *const str) {
+  uint64_t rank;
+  if (deal_to_rank(d, &rank))
+	return 1;
+
+  for (int i = DEAL_TEXT_LENGTH - 1; i >= 0; i--) {
+	str[i] = deal_text_digit(rank & 0b11111u);
+	rank >>= 5u;
+  }
+  str[DEAL_TEXT_LENGTH] = '\0';
+  return 0;
+}
+
+char
+deal_text_digit(uint8_t value) {
+  return DEAL_TEXT_DIGITS[value & 0b11111u];
+}
+
+int
+deal_text_digit_value(char ch) {
+  if (ch >= 'a' && ch <= 'z')
+	ch = (char) (ch - 'a' + 'A');
+  if (ch == 'O')
+	ch = '0';
+  else if (ch == 'I' || ch == 'L')
+	ch = '1';
+
+  for (int i = 0; i < 32; i++)
+	if (DEAL_TEXT_DIGITS[i] == ch)
+	  return i;
+  return -1;
+}
+
+int
+deal_from_text(const char *const str, deal *const d) {
+  uint64_t rank = 0;
+  for (int i = 0; i < DEAL_TEXT_LENGTH; i++) {
+	int value = deal_text_digit_value(str[i]);
+	if (value < 0)
+	  return 1;
+	rank = (rank << 5u) | (uint64_t) value;
+  }
+  if (str[DEAL_TEXT_LENGTH] != '\0')
+	return 2;
+
+  return deal_from_rank(rank, d) ? 3 : 0;
+}
+
+// One deal in text form per line, empty lines and '#' comments are skipped.
+// Returns 1 if the file can't be opened, 2 for an invalid deal and 3 if out
+// of memory.
+int
+deal_read_file(const char *const path, deal **const deals,
+			   size_t *const length) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+	DERROR_PRINTF("Could not open deal file '%s'", path);
+	return 1;
+  }
+
+  size_t capacity = 16, count = 0;
+  deal *buf = malloc(capacity * sizeof(deal)), *grown;
+  if (!buf) {
+	DERROR_PRINTF("Could not allocate the deals of '%s'", path);
+	fclose(f);
+	return 3;
+  }
+
+  char *line = NULL;
+  size_t line_size = 0;
+  ssize_t read;
+  size_t line_num = 0;
+  while ((read = getline(&line, &line_size, f)) != -1) {
+	line_num++;
+	while (read > 0
+		   && (line[read - 1] == '\n' || line[read - 1] == '\r'
+			   || line[read - 1] == ' '))
+	  line[--read] = '\0';
+	if (read == 0 || line[0] == '#')
+	  continue;
+
+	if (count >= capacity) {
+	  if (!(grown = realloc(buf, 2 * capacity * sizeof(deal)))) {
+		DERROR_PRINTF("Could not allocate the deals of '%s'", path);
+		free(line);
+		free(buf);
+		fclose(f);
+		return 3;
+	  }
+	  buf = grown;
+	  capacity *= 2;
+	}
+
+	if (deal_from_text(line, &buf[count])) {
+	  DERROR_PRINTF("Invalid deal '%s' in line %zu of '%s'", line, line_num,
+					path);
+	  free(line);
+	  free(buf);
+	  fclose(f);
+	  return 2;
+	}
+	count++;
+  }
+
+  free(line);
+  fclose(f);
+
+  *deals = buf;
+  *length = count;
+  return 0;
+}
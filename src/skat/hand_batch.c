@@ -0,0 +1,339 @@
+#include "skat/hand_batch.h"
+#include "skat/hand_eval.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAND_BATCH_X86
+#include <immintrin.h>
+#endif
+
+#define HAND_BATCH_MASK_SIDE (0x7f7f7f7fu)// without the Buben
+
+// The features are stored as one 32 bit word per hand:
+// points | trumpf << 8 | strength << 16 | spitzen << 24
+_Static_assert(sizeof(hand_features) == 4, "hand_features is one word");
+
+typedef struct hand_batch_game {
+  uint32_t trumpf_mask;
+  uint32_t side_mask;// non trumpf cards without the Buben
+  int grand;
+  int lane_shift;// of the trumpf color in color games
+  int order;     // trumpf cards in the order of the spitzen
+} hand_batch_game;
+
+typedef void (*hand_batch_kernel)(const hand_batch_game *g,
+								  const card_collection *hands, size_t length,
+								  hand_features *features);
+
+// The trumpf cards from the highest down to the lowest as the bits order - 1
+// to 0: Kreuz, Pik, Herz and Karo Bube, then Ass, Zehn, König, Dame, 9, 8, 7
+// of the trumpf color
+static uint32_t
+hand_batch_rank(const hand_batch_game *const g, const uint32_t h) {
+  uint32_t buben = ((h >> 28) & 0b1000u) | ((h >> 21) & 0b100u)
+				   | ((h >> 14) & 0b10u) | ((h >> 7) & 0b1u);
+  if (g->grand)
+	return buben;
+  return (buben << 7) | ((h >> g->lane_shift) & 0x7fu);
+}
+
+static hand_features
+hand_batch_one(const hand_batch_game *const g, const uint32_t h) {
+  const uint32_t full = (0b1u << g->order) - 1;
+  uint32_t trumpf = h & g->trumpf_mask, side = h & g->side_mask;
+  uint32_t asse = side & CARD_MASK_ASS;
+  uint32_t r = hand_batch_rank(g, h), mit = (r >> (g->order - 1)) & 0b1u;
+  uint32_t y = r ^ (mit ? full : 0);
+  int tc = __builtin_popcount(trumpf), count;
+
+  y |= y >> 1;
+  y |= y >> 2;
+  y |= y >> 4;
+  y |= y >> 8;
+  count = g->order - __builtin_popcount(y);
+
+  return (hand_features){
+		  .points = card_collection_points(h),
+		  .trumpf = tc,
+		  .strength = 2 * __builtin_popcount(asse)
+					  + __builtin_popcount(side & CARD_MASK_ZEHN & (asse >> 1))
+					  + (g->grand ? 3 * tc
+								  : 2 * tc + __builtin_popcount(
+											  h & CARD_MASK_BUBEN)),
+		  .spitzen = mit ? count : -count};
+}
+
+static void
+hand_batch_scalar(const hand_batch_game *const g,
+				  const card_collection *const hands, const size_t length,
+				  hand_features *const features) {
+  for (size_t i = 0; i < length; i++)
+	features[i] = hand_batch_one(g, hands[i]);
+}
+
+#ifdef HAND_BATCH_X86
+
+// Bits set per 32 bit lane: nibble lookup, then the four bytes are summed
+// into the top one by a multiplication
+__attribute__((target("avx2"))) static inline __m256i
+hand_batch_popcount_avx2(const __m256i v) {
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2,
+									   3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+									   2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+  __m256i hi = _mm256_shuffle_epi8(
+		  lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+  return _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_add_epi8(lo, hi),
+											  _mm256_set1_epi32(0x01010101)),
+						   24);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+hand_batch_masked_count_avx2(const __m256i h, const uint32_t mask) {
+  return hand_batch_popcount_avx2(_mm256_and_si256(h, _mm256_set1_epi32(mask)));
+}
+
+__attribute__((target("avx2"))) static void
+hand_batch_avx2(const hand_batch_game *const g,
+				const card_collection *const hands, const size_t length,
+				hand_features *const features) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i full = _mm256_set1_epi32((0b1u << g->order) - 1);
+  size_t i = 0;
+
+  for (; i + 8 <= length; i += 8) {
+	__m256i h = _mm256_loadu_si256((const __m256i *) (hands + i));
+	__m256i side = _mm256_and_si256(h, _mm256_set1_epi32(g->side_mask));
+	__m256i asse = _mm256_and_si256(side, _mm256_set1_epi32(CARD_MASK_ASS));
+	__m256i tens = _mm256_and_si256(
+			_mm256_and_si256(side, _mm256_set1_epi32(CARD_MASK_ZEHN)),
+			_mm256_srli_epi32(asse, 1));
+	__m256i tc = hand_batch_masked_count_avx2(h, g->trumpf_mask);
+	__m256i buben = hand_batch_masked_count_avx2(h, CARD_MASK_BUBEN);
+
+	__m256i points = _mm256_add_epi32(
+			_mm256_add_epi32(
+					_mm256_mullo_epi32(hand_batch_masked_count_avx2(
+											   h, CARD_MASK_ASS),
+									   _mm256_set1_epi32(11)),
+					_mm256_mullo_epi32(hand_batch_masked_count_avx2(
+											   h, CARD_MASK_ZEHN),
+									   _mm256_set1_epi32(10))),
+			_mm256_add_epi32(
+					_mm256_add_epi32(
+							_mm256_slli_epi32(
+									hand_batch_masked_count_avx2(
+											h, CARD_MASK_KOENIG),
+									2),
+							_mm256_mullo_epi32(hand_batch_masked_count_avx2(
+													   h, CARD_MASK_DAME),
+											   _mm256_set1_epi32(3))),
+					_mm256_slli_epi32(buben, 1)));
+
+	__m256i strength = _mm256_add_epi32(
+			_mm256_slli_epi32(hand_batch_popcount_avx2(asse), 1),
+			hand_batch_popcount_avx2(tens));
+	if (g->grand)
+	  strength = _mm256_add_epi32(
+			  strength, _mm256_mullo_epi32(tc, _mm256_set1_epi32(3)));
+	else
+	  strength = _mm256_add_epi32(
+			  strength, _mm256_add_epi32(_mm256_slli_epi32(tc, 1), buben));
+
+	// hand_batch_rank
+	__m256i r = _mm256_or_si256(
+			_mm256_or_si256(
+					_mm256_and_si256(_mm256_srli_epi32(h, 28),
+									 _mm256_set1_epi32(0b1000)),
+					_mm256_and_si256(_mm256_srli_epi32(h, 21),
+									 _mm256_set1_epi32(0b100))),
+			_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(h, 14),
+											 _mm256_set1_epi32(0b10)),
+							_mm256_and_si256(_mm256_srli_epi32(h, 7), one)));
+	if (!g->grand)
+	  r = _mm256_or_si256(
+			  _mm256_slli_epi32(r, 7),
+			  _mm256_and_si256(
+					  _mm256_srl_epi32(h, _mm_cvtsi32_si128(g->lane_shift)),
+					  _mm256_set1_epi32(0x7f)));
+
+	// All ones for mit
+	__m256i mit = _mm256_sub_epi32(
+			_mm256_setzero_si256(),
+			_mm256_and_si256(
+					_mm256_srl_epi32(r, _mm_cvtsi32_si128(g->order - 1)), one));
+	__m256i y = _mm256_xor_si256(r, _mm256_and_si256(mit, full));
+	y = _mm256_or_si256(y, _mm256_srli_epi32(y, 1));
+	y = _mm256_or_si256(y, _mm256_srli_epi32(y, 2));
+	y = _mm256_or_si256(y, _mm256_srli_epi32(y, 4));
+	y = _mm256_or_si256(y, _mm256_srli_epi32(y, 8));
+	__m256i count = _mm256_sub_epi32(_mm256_set1_epi32(g->order),
+									 hand_batch_popcount_avx2(y));
+	__m256i ohne = _mm256_xor_si256(mit, _mm256_set1_epi32(-1));
+	__m256i spitzen =
+			_mm256_sub_epi32(_mm256_xor_si256(count, ohne), ohne);
+
+	__m256i packed = _mm256_or_si256(
+			_mm256_or_si256(points, _mm256_slli_epi32(tc, 8)),
+			_mm256_or_si256(_mm256_slli_epi32(strength, 16),
+							_mm256_slli_epi32(spitzen, 24)));
+	_mm256_storeu_si256((__m256i *) (features + i), packed);
+  }
+  hand_batch_scalar(g, hands + i, length - i, features + i);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static inline __m512i
+hand_batch_popcount_avx512(const __m512i v) {
+  const __m512i lut = _mm512_set4_epi32(0x04030302, 0x03020201, 0x03020201,
+										0x02010100);
+  const __m512i low = _mm512_set1_epi8(0x0f);
+  __m512i lo = _mm512_shuffle_epi8(lut, _mm512_and_si512(v, low));
+  __m512i hi = _mm512_shuffle_epi8(
+		  lut, _mm512_and_si512(_mm512_srli_epi16(v, 4), low));
+  return _mm512_srli_epi32(_mm512_mullo_epi32(_mm512_add_epi8(lo, hi),
+											  _mm512_set1_epi32(0x01010101)),
+						   24);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static inline __m512i
+hand_batch_masked_count_avx512(const __m512i h, const uint32_t mask) {
+  return hand_batch_popcount_avx512(
+		  _mm512_and_si512(h, _mm512_set1_epi32(mask)));
+}
+
+// As hand_batch_avx2, 16 hands at a time
+__attribute__((target("avx512f,avx512bw"))) static void
+hand_batch_avx512(const hand_batch_game *const g,
+				  const card_collection *const hands, const size_t length,
+				  hand_features *const features) {
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i full = _mm512_set1_epi32((0b1u << g->order) - 1);
+  size_t i = 0;
+
+  for (; i + 16 <= length; i += 16) {
+	__m512i h = _mm512_loadu_si512(hands + i);
+	__m512i side = _mm512_and_si512(h, _mm512_set1_epi32(g->side_mask));
+	__m512i asse = _mm512_and_si512(side, _mm512_set1_epi32(CARD_MASK_ASS));
+	__m512i tens = _mm512_and_si512(
+			_mm512_and_si512(side, _mm512_set1_epi32(CARD_MASK_ZEHN)),
+			_mm512_srli_epi32(asse, 1));
+	__m512i tc = hand_batch_masked_count_avx512(h, g->trumpf_mask);
+	__m512i buben = hand_batch_masked_count_avx512(h, CARD_MASK_BUBEN);
+
+	__m512i points = _mm512_add_epi32(
+			_mm512_add_epi32(
+					_mm512_mullo_epi32(hand_batch_masked_count_avx512(
+											   h, CARD_MASK_ASS),
+									   _mm512_set1_epi32(11)),
+					_mm512_mullo_epi32(hand_batch_masked_count_avx512(
+											   h, CARD_MASK_ZEHN),
+									   _mm512_set1_epi32(10))),
+			_mm512_add_epi32(
+					_mm512_add_epi32(
+							_mm512_slli_epi32(
+									hand_batch_masked_count_avx512(
+											h, CARD_MASK_KOENIG),
+									2),
+							_mm512_mullo_epi32(hand_batch_masked_count_avx512(
+													   h, CARD_MASK_DAME),
+											   _mm512_set1_epi32(3))),
+					_mm512_slli_epi32(buben, 1)));
+
+	__m512i strength = _mm512_add_epi32(
+			_mm512_slli_epi32(hand_batch_popcount_avx512(asse), 1),
+			hand_batch_popcount_avx512(tens));
+	if (g->grand)
+	  strength = _mm512_add_epi32(
+			  strength, _mm512_mullo_epi32(tc, _mm512_set1_epi32(3)));
+	else
+	  strength = _mm512_add_epi32(
+			  strength, _mm512_add_epi32(_mm512_slli_epi32(tc, 1), buben));
+
+	__m512i r = _mm512_or_si512(
+			_mm512_or_si512(
+					_mm512_and_si512(_mm512_srli_epi32(h, 28),
+									 _mm512_set1_epi32(0b1000)),
+					_mm512_and_si512(_mm512_srli_epi32(h, 21),
+									 _mm512_set1_epi32(0b100))),
+			_mm512_or_si512(_mm512_and_si512(_mm512_srli_epi32(h, 14),
+											 _mm512_set1_epi32(0b10)),
+							_mm512_and_si512(_mm512_srli_epi32(h, 7), one)));
+	if (!g->grand)
+	  r = _mm512_or_si512(
+			  _mm512_slli_epi32(r, 7),
+			  _mm512_and_si512(
+					  _mm512_srl_epi32(h, _mm_cvtsi32_si128(g->lane_shift)),
+					  _mm512_set1_epi32(0x7f)));
+
+	__m512i mit = _mm512_sub_epi32(
+			_mm512_setzero_si512(),
+			_mm512_and_si512(
+					_mm512_srl_epi32(r, _mm_cvtsi32_si128(g->order - 1)), one));
+	__m512i y = _mm512_xor_si512(r, _mm512_and_si512(mit, full));
+	y = _mm512_or_si512(y, _mm512_srli_epi32(y, 1));
+	y = _mm512_or_si512(y, _mm512_srli_epi32(y, 2));
+	y = _mm512_or_si512(y, _mm512_srli_epi32(y, 4));
+	y = _mm512_or_si512(y, _mm512_srli_epi32(y, 8));
+	__m512i count = _mm512_sub_epi32(_mm512_set1_epi32(g->order),
+									 hand_batch_popcount_avx512(y));
+	__m512i ohne = _mm512_xor_si512(mit, _mm512_set1_epi32(-1));
+	__m512i spitzen =
+			_mm512_sub_epi32(_mm512_xor_si512(count, ohne), ohne);
+
+	__m512i packed = _mm512_or_si512(
+			_mm512_or_si512(points, _mm512_slli_epi32(tc, 8)),
+			_mm512_or_si512(_mm512_slli_epi32(strength, 16),
+							_mm512_slli_epi32(spitzen, 24)));
+	_mm512_storeu_si512(features + i, packed);
+  }
+  hand_batch_scalar(g, hands + i, length - i, features + i);
+}
+
+#endif
+
+static hand_batch_kernel hand_batch_selected = hand_batch_scalar;
+static const char *hand_batch_selected_name = "scalar";
+
+__attribute__((constructor)) static void
+hand_batch_select(void) {
+#ifdef HAND_BATCH_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+	hand_batch_selected = hand_batch_avx512;
+	hand_batch_selected_name = "avx512";
+  } else if (__builtin_cpu_supports("avx2")) {
+	hand_batch_selected = hand_batch_avx2;
+	hand_batch_selected_name = "avx2";
+  }
+#endif
+}
+
+int
+hand_batch_evaluate(const game_rules *gr, const card_collection *hands,
+					size_t length, hand_features *features) {
+  hand_batch_game g = {.trumpf_mask = hand_eval_trumpf_mask(gr)};
+
+  switch (gr->type) {
+	case GAME_TYPE_COLOR:
+	  if (gr->trumpf < COLOR_KARO || gr->trumpf > COLOR_KREUZ)
+		return 1;
+	  g.lane_shift = 8 * (gr->trumpf - COLOR_KARO);
+	  g.order = 11;
+	  break;
+	case GAME_TYPE_GRAND:
+	  g.grand = 1;
+	  g.order = 4;
+	  break;
+	default:
+	  return 1;
+  }
+  g.side_mask = HAND_BATCH_MASK_SIDE & ~g.trumpf_mask;
+
+  hand_batch_selected(&g, hands, length, features);
+  return 0;
+}
+
+const char *
+hand_batch_backend(void) {
+  return hand_batch_selected_name;
+}
@@ -0,0 +1,173 @@
+#include "skat/hand_eval.h"
+#include "skat/hand_batch.h"
+#include "skat/reizen.h"
+#include <limits.h>
+
+// Card points and Null rank by lane bit
+const uint8_t hand_eval_lane_points[8] = {0, 0, 0, 3, 4, 10, 11, 2};
+const uint8_t hand_eval_null_rank[8] = {0, 1, 2, 5, 6, 3, 7, 4};
+
+const game_rules hand_eval_games[HAND_EVAL_GAMES] = {
+		{.type = GAME_TYPE_COLOR, .trumpf = COLOR_KARO},
+		{.type = GAME_TYPE_COLOR, .trumpf = COLOR_HERZ},
+		{.type = GAME_TYPE_COLOR, .trumpf = COLOR_PIK},
+		{.type = GAME_TYPE_COLOR, .trumpf = COLOR_KREUZ},
+		{.type = GAME_TYPE_GRAND, .trumpf = COLOR_INVALID},
+		{.type = GAME_TYPE_NULL, .trumpf = COLOR_INVALID}};
+
+card_collection
+hand_eval_lane(const card_color cc) {
+  return HAND_EVAL_MASK_LANE << (8 * (cc - COLOR_KARO));
+}
+
+card_collection
+hand_eval_trumpf_mask(const game_rules *const gr) {
+  switch (gr->type) {
+	case GAME_TYPE_COLOR:
+	  return CARD_MASK_BUBEN | hand_eval_lane(gr->trumpf);
+	case GAME_TYPE_GRAND:
+	case GAME_TYPE_RAMSCH:
+	  return CARD_MASK_BUBEN;
+	default:
+	  return 0;
+  }
+}
+
+// Two points per trumpf and side Ass, one per Bube and per Zehn guarded by
+// its Ass. Buben count three in Grand.
+int
+hand_eval_strength(const card_collection hand, const game_rules *const gr) {
+  card_collection trumpf = hand & hand_eval_trumpf_mask(gr), side;
+  int strength = 0;
+
+  for (card_color cc = COLOR_KARO; cc <= COLOR_KREUZ; cc++) {
+	if (gr->type == GAME_TYPE_COLOR && cc == gr->trumpf)
+	  continue;
+	side = hand & hand_eval_lane(cc) & ~CARD_MASK_BUBEN;
+	if (side & CARD_MASK_ASS)
+	  strength += 2 + !!(side & CARD_MASK_ZEHN);
+  }
+
+  if (gr->type == GAME_TYPE_GRAND)
+	return strength + 3 * __builtin_popcount(trumpf);
+  return strength + 2 * __builtin_popcount(trumpf)
+		 + __builtin_popcount(trumpf & CARD_MASK_BUBEN);
+}
+
+// The i-th lowest card of every color has at most Null rank 2 * i
+int
+hand_eval_null_margin(const card_collection hand) {
+  int margin = 1;
+  for (int lane = 0; lane < 4; lane++) {
+	unsigned ranks = 0;
+	for (int bit = 0; bit < 8; bit++)
+	  if ((hand >> (8 * lane + bit)) & 0b1u)
+		ranks |= 0b1u << hand_eval_null_rank[bit];
+	for (int i = 0; ranks; i++, ranks &= ranks - 1) {
+	  int over = __builtin_ctz(ranks) - 2 * i;
+	  if (over > 0)
+		margin -= over;
+	}
+  }
+  return margin;
+}
+
+int
+hand_eval_margin(const card_collection hand, const game_rules *const gr) {
+  switch (gr->type) {
+	case GAME_TYPE_NULL:
+	  return hand_eval_null_margin(hand);
+	case GAME_TYPE_GRAND:
+	  return hand_eval_strength(hand, gr) - HAND_EVAL_GRAND_STRENGTH + 1;
+	default:
+	  return hand_eval_strength(hand, gr) - HAND_EVAL_COLOR_STRENGTH + 1;
+  }
+}
+
+int
+hand_eval_margins(const game_rules *const gr,
+				  const card_collection *const hands, const size_t length,
+				  int *const margins) {
+  hand_features features[HAND_BATCH_WIDTH];
+  const int strength = gr->type == GAME_TYPE_GRAND ? HAND_EVAL_GRAND_STRENGTH
+												   : HAND_EVAL_COLOR_STRENGTH;
+  size_t n;
+
+  if (gr->type == GAME_TYPE_NULL) {
+	for (size_t i = 0; i < length; i++)
+	  margins[i] = hand_eval_null_margin(hands[i]);
+	return 0;
+  }
+  for (size_t i = 0; i < length; i += n) {
+	n = length - i < HAND_BATCH_WIDTH ? length - i : HAND_BATCH_WIDTH;
+	if (hand_batch_evaluate(gr, hands + i, n, features))
+	  return 1;
+	for (size_t j = 0; j < n; j++)
+	  margins[i + j] = features[j].strength - strength + 1;
+  }
+  return 0;
+}
+
+// Drops high cards of short colors, keeps Asse, guarded Zehnen and trumpf
+card_collection
+hand_eval_press(const card_collection cards, const game_rules *const gr) {
+  const card_collection trumpf = hand_eval_trumpf_mask(gr);
+  card_collection press = 0, rest, lane;
+  int score, best_score;
+  uint8_t best;
+
+  for (int k = 0; k < 2; k++) {
+	rest = cards & ~press;
+	best_score = INT_MIN;
+	best = __builtin_ctz(rest);
+	for (card_collection m = rest & ~trumpf; m; m &= m - 1) {
+	  uint8_t i = __builtin_ctz(m), bit = i & 0b111u;
+	  lane = rest & (HAND_EVAL_MASK_LANE << (i & ~0b111u)) & ~trumpf;
+	  if (gr->type == GAME_TYPE_NULL) {
+		score = 4 * hand_eval_null_rank[bit] - __builtin_popcount(lane);
+	  } else {
+		score = hand_eval_lane_points[bit] - 3 * __builtin_popcount(lane);
+		if (lane & CARD_MASK_ASS & (0b1u << i))
+		  score -= 20;
+		else if ((0b1u << i) & CARD_MASK_ZEHN && lane & CARD_MASK_ASS)
+		  score -= 8;
+	  }
+	  if (score > best_score) {
+		best_score = score;
+		best = i;
+	  }
+	}
+	press |= 0b1u << best;
+  }
+  return press;
+}
+
+void
+hand_eval_choose_game(const card_collection cards, const int choose_press,
+					  card_collection press, const uint16_t reizwert,
+					  game_rules *const gr, card_collection *const press_out) {
+  int best = -1, best_margin = INT_MIN, best_value = 0;
+  int best_reaches = 0, margin, value, reaches;
+  card_collection best_press = press, p;
+
+  for (int g = 0; g < HAND_EVAL_GAMES; g++) {
+	p = choose_press ? hand_eval_press(cards, &hand_eval_games[g]) : press;
+	margin = hand_eval_margin(cards & ~p, &hand_eval_games[g]);
+	value = reizen_get_min_game_value(&hand_eval_games[g], cards);
+	reaches = value >= reizwert;
+
+	// Not overbidding comes first, then the most comfortable game
+	if (best == -1 || reaches > best_reaches
+		|| (reaches == best_reaches
+			&& (reaches ? margin > best_margin : value > best_value))) {
+	  best = g;
+	  best_margin = margin;
+	  best_value = value;
+	  best_reaches = reaches;
+	  best_press = p;
+	}
+  }
+
+  *gr = hand_eval_games[best];
+  *press_out = best_press;
+}
@@ -0,0 +1,279 @@
+#include "skat/matchmaking.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int
+matchmaking_earlier(const matchmaking *mm, uint32_t a, uint32_t b) {
+  return mm->entries[mm->heap[a]].widen_at < mm->entries[mm->heap[b]].widen_at;
+}
+
+static void
+matchmaking_heap_swap(matchmaking *mm, uint32_t a, uint32_t b) {
+  uint32_t tmp = mm->heap[a];
+  mm->heap[a] = mm->heap[b];
+  mm->heap[b] = tmp;
+  mm->entries[mm->heap[a]].heap = a;
+  mm->entries[mm->heap[b]].heap = b;
+}
+
+static void
+matchmaking_heap_up(matchmaking *mm, uint32_t i) {
+  while (i && matchmaking_earlier(mm, i, (i - 1) / 2)) {
+	matchmaking_heap_swap(mm, i, (i - 1) / 2);
+	i = (i - 1) / 2;
+  }
+}
+
+static void
+matchmaking_heap_down(matchmaking *mm, uint32_t i) {
+  uint32_t c;
+  for (;;) {
+	c = 2 * i + 1;
+	if (c >= mm->waiting)
+	  return;
+	if (c + 1 < mm->waiting && matchmaking_earlier(mm, c + 1, c))
+	  c++;
+	if (!matchmaking_earlier(mm, c, i))
+	  return;
+	matchmaking_heap_swap(mm, i, c);
+	i = c;
+  }
+}
+
+// Takes an entry out of its bucket and the heap and frees it
+static void
+matchmaking_remove(matchmaking *mm, uint32_t idx) {
+  matchmaking_entry *e = &mm->entries[idx];
+  uint32_t pos = e->heap;
+
+  if (e->prev != MATCHMAKING_NONE)
+	mm->entries[e->prev].next = e->next;
+  else
+	mm->head[e->bucket] = e->next;
+  if (e->next != MATCHMAKING_NONE)
+	mm->entries[e->next].prev = e->prev;
+  else
+	mm->tail[e->bucket] = e->prev;
+  mm->count[e->bucket]--;
+
+  mm->waiting--;
+  if (pos != mm->waiting) {
+	matchmaking_heap_swap(mm, pos, mm->waiting);
+	matchmaking_heap_up(mm, pos);
+	matchmaking_heap_down(mm, pos);
+  }
+  e->heap = MATCHMAKING_NONE;
+  mm->free_entries[mm->free_count++] = idx;
+}
+
+// Buckets accepted to each side at now
+static int
+matchmaking_window(const matchmaking_entry *e, uint64_t now) {
+  uint64_t steps = (now - e->joined) / MATCHMAKING_WIDEN_MILLIS;
+  return steps >= MATCHMAKING_BUCKETS - 1 ? MATCHMAKING_BUCKETS - 1
+										  : (int) steps;
+}
+
+// Whoever of the two waited longer accepts the bucket of the other
+static int
+matchmaking_accepts(const matchmaking *mm, uint32_t a, uint32_t b,
+					uint64_t now) {
+  const matchmaking_entry *x = &mm->entries[a], *y = &mm->entries[b];
+  int d = abs((int) x->bucket - (int) y->bucket);
+  return d <= matchmaking_window(x, now) || d <= matchmaking_window(y, now);
+}
+
+// Removes the three players and writes them to m
+static void
+matchmaking_make_table(matchmaking *mm, uint32_t found[3], uint64_t now,
+					   matchmaking_match *m) {
+  uint32_t tmp;
+
+  // Join order, so callers can seat the longest waiting player first
+  for (int i = 0; i < 2; i++)
+	for (int j = 2; j > i; j--)
+	  if (mm->entries[found[j]].joined < mm->entries[found[j - 1]].joined) {
+		tmp = found[j];
+		found[j] = found[j - 1];
+		found[j - 1] = tmp;
+	  }
+  for (int i = 0; i < 3; i++) {
+	m->players[i] = mm->entries[found[i]].player;
+	matchmaking_histogram_add(&mm->match_millis,
+							  now - mm->entries[found[i]].joined);
+	matchmaking_remove(mm, found[i]);
+  }
+  mm->matches++;
+}
+
+// Two players who can share a table with idx and with each other, nearest
+// buckets first. Makes the table of three if there are two.
+static int
+matchmaking_try_match(matchmaking *mm, uint32_t idx, uint64_t now,
+					  matchmaking_match *m) {
+  const matchmaking_entry *e = &mm->entries[idx];
+  uint32_t cands[2 * MATCHMAKING_BUCKETS], cur;
+  int n = 0, taken, b;
+
+  // A bucket is in join order, so its first players have the widest windows
+  // and whoever idx accepts there is a prefix. Any table with a later player
+  // of the bucket also works with one of its first two.
+  for (int d = 0; d < MATCHMAKING_BUCKETS; d++) {
+	for (int side = 0; side < (d ? 2 : 1); side++) {
+	  b = side ? e->bucket + d : e->bucket - d;
+	  if (b < 0 || b >= MATCHMAKING_BUCKETS)
+		continue;
+	  taken = 0;
+	  for (cur = mm->head[b]; cur != MATCHMAKING_NONE && taken < 2;
+		   cur = mm->entries[cur].next) {
+		if (cur == idx)
+		  continue;
+		if (!matchmaking_accepts(mm, idx, cur, now))
+		  break;
+		cands[n++] = cur;
+		taken++;
+	  }
+	}
+  }
+
+  for (int i = 0; i < n; i++)
+	for (int j = i + 1; j < n; j++)
+	  if (matchmaking_accepts(mm, cands[i], cands[j], now)) {
+		matchmaking_make_table(mm, (uint32_t[3]){idx, cands[i], cands[j]},
+							   now, m);
+		return 1;
+	  }
+  return 0;
+}
+
+static void
+matchmaking_set_widen_at(matchmaking_entry *e, uint64_t now) {
+  uint64_t steps = (now - e->joined) / MATCHMAKING_WIDEN_MILLIS;
+  e->widen_at = steps >= MATCHMAKING_BUCKETS - 1
+						? UINT64_MAX
+						: e->joined + (steps + 1) * MATCHMAKING_WIDEN_MILLIS;
+}
+
+int
+matchmaking_init(matchmaking *mm, uint32_t capacity) {
+  memset(mm, '\0', sizeof(*mm));
+  if (!capacity || capacity == MATCHMAKING_NONE)
+	return 1;
+  mm->entries = malloc(capacity * sizeof(*mm->entries));
+  mm->free_entries = malloc(capacity * sizeof(*mm->free_entries));
+  mm->heap = malloc(capacity * sizeof(*mm->heap));
+  if (!mm->entries || !mm->free_entries || !mm->heap) {
+	matchmaking_free(mm);
+	return 2;
+  }
+
+  mm->capacity = capacity;
+  for (uint32_t i = 0; i < capacity; i++) {
+	mm->entries[i].heap = MATCHMAKING_NONE;
+	mm->free_entries[i] = capacity - 1 - i;
+  }
+  mm->free_count = capacity;
+  memset(mm->head, 0xff, sizeof(mm->head));
+  memset(mm->tail, 0xff, sizeof(mm->tail));
+  return 0;
+}
+
+void
+matchmaking_free(matchmaking *mm) {
+  free(mm->entries);
+  free(mm->free_entries);
+  free(mm->heap);
+  mm->entries = NULL;
+  mm->free_entries = mm->heap = NULL;
+  mm->capacity = mm->free_count = mm->waiting = 0;
+}
+
+int
+matchmaking_join(matchmaking *mm, uint32_t player, int rating, uint64_t now,
+				 uint32_t *ticket, matchmaking_match *m) {
+  matchmaking_entry *e;
+  uint32_t idx;
+  int bucket = rating / MATCHMAKING_BUCKET_WIDTH;
+
+  *ticket = MATCHMAKING_NONE;
+  if (!mm->free_count)
+	return 2;
+  matchmaking_histogram_add(&mm->queue_length, mm->waiting);
+
+  idx = mm->free_entries[--mm->free_count];
+  e = &mm->entries[idx];
+  e->player = player;
+  e->bucket = bucket < 0 ? 0
+			  : bucket >= MATCHMAKING_BUCKETS ? MATCHMAKING_BUCKETS - 1
+											  : bucket;
+  e->joined = now;
+  matchmaking_set_widen_at(e, now);
+
+  e->next = MATCHMAKING_NONE;
+  e->prev = mm->tail[e->bucket];
+  if (e->prev != MATCHMAKING_NONE)
+	mm->entries[e->prev].next = idx;
+  else
+	mm->head[e->bucket] = idx;
+  mm->tail[e->bucket] = idx;
+  mm->count[e->bucket]++;
+
+  e->heap = mm->waiting;
+  mm->heap[mm->waiting++] = idx;
+  matchmaking_heap_up(mm, e->heap);
+
+  if (matchmaking_try_match(mm, idx, now, m))
+	return 1;
+  *ticket = idx;
+  return 0;
+}
+
+int
+matchmaking_leave(matchmaking *mm, uint32_t ticket) {
+  if (ticket >= mm->capacity || mm->entries[ticket].heap == MATCHMAKING_NONE)
+	return 1;
+  matchmaking_remove(mm, ticket);
+  return 0;
+}
+
+int
+matchmaking_tick(matchmaking *mm, uint64_t now, matchmaking_match *m,
+				 int max) {
+  uint32_t idx;
+  int n = 0;
+
+  while (n < max && mm->waiting
+		 && mm->entries[mm->heap[0]].widen_at <= now) {
+	idx = mm->heap[0];
+	matchmaking_set_widen_at(&mm->entries[idx], now);
+	matchmaking_heap_down(mm, 0);
+	n += matchmaking_try_match(mm, idx, now, &m[n]);
+  }
+  return n;
+}
+
+void
+matchmaking_histogram_add(matchmaking_histogram *h, uint64_t value) {
+  int bin = value ? 64 - __builtin_clzll(value) : 0;
+  if (bin >= MATCHMAKING_HISTOGRAM_BINS)
+	bin = MATCHMAKING_HISTOGRAM_BINS - 1;
+  h->counts[bin]++;
+}
+
+void
+matchmaking_histogram_print(const matchmaking_histogram *h, const char *name,
+							FILE *out) {
+  uint64_t total = 0;
+
+  for (int i = 0; i < MATCHMAKING_HISTOGRAM_BINS; i++)
+	total += h->counts[i];
+  fprintf(out, "# %s, %llu samples\n", name, (unsigned long long) total);
+  for (int i = 0; i < MATCHMAKING_HISTOGRAM_BINS; i++) {
+	if (!h->counts[i])
+	  continue;
+	fprintf(out, "%10s %-10llu %10llu %6.2f%%\n",
+			i == MATCHMAKING_HISTOGRAM_BINS - 1 ? ">=" : "<",
+			i ? 1ull << (i - 1 + (i < MATCHMAKING_HISTOGRAM_BINS - 1)) : 1ull,
+			(unsigned long long) h->counts[i], 100.0 * h->counts[i] / total);
+  }
+}
@@ -0,0 +1,246 @@
+#include "skat/null_solver.h"
+#include <stdint.h>
+#include <string.h>
+
+#define NULL_OWNER_ALLEINSPIELER (1)
+#define NULL_OWNER_LEFT          (2)
+#define NULL_OWNER_RIGHT         (3)
+
+#define NULL_SAFE       (0b001u)
+#define NULL_LOST_LEFT  (0b010u)
+#define NULL_LOST_RIGHT (0b100u)
+
+#define NULL_STATES (1u << 16u)
+#define NULL_NONE   (-1)
+
+// Lane bits in Null rank order, lowest first: 7 8 9 10 B D K A
+static const uint8_t null_rank_bit[8] = {0, 1, 2, 5, 7, 3, 4, 6};
+
+// Lane byte -> 0b01 at bits 2 * rank for every card of the lane
+static uint16_t null_spread[256];
+static uint8_t null_table[NULL_STATES];
+
+// Only used while building the tables
+static int8_t null_memo_safe[NULL_STATES];
+static int8_t null_memo_lost[2][NULL_STATES];
+
+static int
+null_owner(const uint16_t st, const int rank) {
+  return (st >> (2 * rank)) & 0b11u;
+}
+
+static uint16_t
+null_remove(const uint16_t st, const int rank) {
+  return rank == NULL_NONE ? st : st & ~(0b11u << (2 * rank));
+}
+
+static int
+null_has(const uint16_t st, const int owner) {
+  for (int rank = 0; rank < 8; rank++)
+	if (null_owner(st, rank) == owner)
+	  return 1;
+  return 0;
+}
+
+static int
+null_max(const int a, const int b) {
+  return a > b ? a : b;
+}
+
+static int
+null_safe(uint16_t st);
+
+// The alleinspieler, holding the suit, answers a stich led by the left
+// opponent: a and b are on the table
+static int
+null_safe_answer(const uint16_t st, const int high) {
+  for (int d = 0; d < high; d++)
+	if (null_owner(st, d) == NULL_OWNER_ALLEINSPIELER
+		&& null_safe(null_remove(st, d)))
+	  return 1;
+  return 0;
+}
+
+static int
+null_safe(const uint16_t st) {
+  if (null_memo_safe[st] >= 0)
+	return null_memo_safe[st];
+
+  int result = 1;
+  if (!null_has(st, NULL_OWNER_ALLEINSPIELER))
+	goto done;
+
+  // free discards
+  for (int j = 0; j < 8; j++) {
+	int o = null_owner(st, j);
+	if ((o == NULL_OWNER_LEFT || o == NULL_OWNER_RIGHT)
+		&& !null_safe(null_remove(st, j))) {
+	  result = 0;
+	  goto done;
+	}
+  }
+
+  // left leads, right follows, the alleinspieler plays last
+  for (int a = 0; a < 8; a++) {
+	if (null_owner(st, a) != NULL_OWNER_LEFT)
+	  continue;
+	uint16_t s1 = null_remove(st, a);
+	int right_has = null_has(s1, NULL_OWNER_RIGHT);
+	for (int b = right_has ? 0 : NULL_NONE; b < 8; b++) {
+	  if (b != NULL_NONE && null_owner(s1, b) != NULL_OWNER_RIGHT)
+		continue;
+	  if (!null_safe_answer(null_remove(s1, b), null_max(a, b))) {
+		result = 0;
+		goto done;
+	  }
+	  if (b == NULL_NONE)
+		break;
+	}
+  }
+
+  // right leads, the alleinspieler follows, left plays last
+  for (int a = 0; a < 8; a++) {
+	if (null_owner(st, a) != NULL_OWNER_RIGHT)
+	  continue;
+	uint16_t s1 = null_remove(st, a);
+	int answered = 0;
+	for (int d = 0; d < 8 && !answered; d++) {
+	  if (null_owner(s1, d) != NULL_OWNER_ALLEINSPIELER)
+		continue;
+	  uint16_t s2 = null_remove(s1, d);
+	  int left_has = null_has(s2, NULL_OWNER_LEFT);
+	  answered = 1;
+	  for (int b = left_has ? 0 : NULL_NONE; b < 8; b++) {
+		if (b != NULL_NONE && null_owner(s2, b) != NULL_OWNER_LEFT)
+		  continue;
+		if (d > null_max(a, b) || !null_safe(null_remove(s2, b))) {
+		  answered = 0;
+		  break;
+		}
+		if (b == NULL_NONE)
+		  break;
+	  }
+	}
+	if (!answered) {
+	  result = 0;
+	  goto done;
+	}
+  }
+
+done:
+  null_memo_safe[st] = (int8_t) result;
+  return result;
+}
+
+static int
+null_lost(const uint16_t st, const int leader) {
+  int8_t *memo = &null_memo_lost[leader - NULL_OWNER_LEFT][st];
+  if (*memo >= 0)
+	return *memo;
+
+  int result = 0;
+  if (!null_has(st, NULL_OWNER_ALLEINSPIELER) || !null_has(st, leader))
+	goto done;
+
+  if (leader == NULL_OWNER_LEFT) {
+	// left leads, right follows, the alleinspieler plays last
+	for (int a = 0; a < 8 && !result; a++) {
+	  if (null_owner(st, a) != NULL_OWNER_LEFT)
+		continue;
+	  uint16_t s1 = null_remove(st, a);
+	  int right_has = null_has(s1, NULL_OWNER_RIGHT);
+	  for (int b = right_has ? 0 : NULL_NONE; b < 8 && !result; b++) {
+		if (b != NULL_NONE && null_owner(s1, b) != NULL_OWNER_RIGHT)
+		  continue;
+		uint16_t s2 = null_remove(s1, b);
+		int winner = a > b ? NULL_OWNER_LEFT : NULL_OWNER_RIGHT;
+		int forced = 1;
+		for (int d = 0; d < 8 && forced; d++)
+		  if (null_owner(s2, d) == NULL_OWNER_ALLEINSPIELER
+			  && d < null_max(a, b))
+			forced = null_lost(null_remove(s2, d), winner);
+		result = forced;
+		if (b == NULL_NONE)
+		  break;
+	  }
+	}
+  } else {
+	// right leads, the alleinspieler follows, left plays last
+	for (int a = 0; a < 8 && !result; a++) {
+	  if (null_owner(st, a) != NULL_OWNER_RIGHT)
+		continue;
+	  uint16_t s1 = null_remove(st, a);
+	  int forced = 1;
+	  for (int d = 0; d < 8 && forced; d++) {
+		if (null_owner(s1, d) != NULL_OWNER_ALLEINSPIELER)
+		  continue;
+		uint16_t s2 = null_remove(s1, d);
+		int left_has = null_has(s2, NULL_OWNER_LEFT);
+		int answer = 0;
+		for (int b = left_has ? 0 : NULL_NONE; b < 8 && !answer; b++) {
+		  if (b != NULL_NONE && null_owner(s2, b) != NULL_OWNER_LEFT)
+			continue;
+		  answer = d > null_max(a, b)
+				   || null_lost(null_remove(s2, b),
+								a > b ? NULL_OWNER_RIGHT : NULL_OWNER_LEFT);
+		  if (b == NULL_NONE)
+			break;
+		}
+		forced = answer;
+	  }
+	  result = forced;
+	}
+  }
+
+done:
+  *memo = (int8_t) result;
+  return result;
+}
+
+__attribute__((constructor)) static void
+null_solver_init_tables(void) {
+  for (unsigned lane = 0; lane < 256; lane++)
+	for (int rank = 0; rank < 8; rank++)
+	  if ((lane >> null_rank_bit[rank]) & 0b1u)
+		null_spread[lane] |= 0b01u << (2 * rank);
+
+  memset(null_memo_safe, -1, sizeof(null_memo_safe));
+  memset(null_memo_lost, -1, sizeof(null_memo_lost));
+  for (unsigned st = 0; st < NULL_STATES; st++)
+	null_table[st] = (null_safe(st) ? NULL_SAFE : 0)
+					 | (null_lost(st, NULL_OWNER_LEFT) ? NULL_LOST_LEFT : 0)
+					 | (null_lost(st, NULL_OWNER_RIGHT) ? NULL_LOST_RIGHT : 0);
+}
+
+int
+null_solver_decide(const card_collection hands[3], int alleinspieler,
+				   int leader, int *alleinspieler_takes) {
+  if (leader == alleinspieler)
+	return 1;
+
+  const card_collection as = hands[alleinspieler];
+  const card_collection left = hands[(alleinspieler + 1) % 3];
+  const card_collection right = hands[(alleinspieler + 2) % 3];
+  const uint8_t lost = leader == (alleinspieler + 1) % 3 ? NULL_LOST_LEFT
+														  : NULL_LOST_RIGHT;
+  uint8_t safe = NULL_SAFE;
+
+  for (int lane = 0; lane < 4; lane++) {
+	int shift = 8 * lane;
+	uint16_t st = null_spread[(as >> shift) & 0xffu]
+				  + 2 * null_spread[(left >> shift) & 0xffu]
+				  + 3 * null_spread[(right >> shift) & 0xffu];
+	uint8_t t = null_table[st];
+	if (t & lost) {
+	  *alleinspieler_takes = 1;
+	  return 0;
+	}
+	safe &= t;
+  }
+
+  if (safe) {
+	*alleinspieler_takes = 0;
+	return 0;
+  }
+  return 1;
+}
@@ -11,11 +11,19 @@ player_equals_by_name(const player *const p1, const player *const p2) {
 
 player *
 create_player(int gupid, int ap, const char *const name) {
-  size_t name_length = strlen(name);
+  return create_player_n(gupid, ap, name, strlen(name));
+}
+
+player *
+create_player_n(int gupid, int ap, const char *const name,
+				size_t name_length) {
   player *pl = malloc(sizeof(player) + name_length + 1);
-  pl->gupid = gupid;
-  pl->ap = ap;
-  pl->name_length = name_length;
-  memcpy(pl->name, name, name_length + 1);
+  char *copy = (char *) (pl + 1);
+  memcpy(copy, name, name_length);
+  copy[name_length] = '\0';
+  *pl = (player){.gupid = gupid,
+				 .ap = ap,
+				 .name_length = name_length,
+				 .name = copy};
   return pl;
 }
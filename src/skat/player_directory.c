@@ -0,0 +1,219 @@
+#include "skat/player_directory.h"
+#include "skat/util.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint32_t
+player_directory_hash(const char *name, size_t name_length) {
+  uint32_t h = 0x811c9dc5u;
+  for (size_t i = 0; i < name_length; i++)
+	h = (h ^ (uint8_t) name[i]) * 0x01000193u;
+  return h;
+}
+
+static size_t
+player_directory_size(uint32_t capacity) {
+  return sizeof(player_directory_header)
+		 + (size_t) capacity
+				   * (sizeof(player_directory_entry) + sizeof(uint32_t));
+}
+
+static int
+player_directory_map(player_directory *d, uint32_t capacity) {
+  size_t size = player_directory_size(capacity);
+  void *p;
+
+  if (d->fd < 0)
+	p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+			 -1, 0);
+  else
+	p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, d->fd, 0);
+  if (p == MAP_FAILED)
+	return 1;
+  d->header = p;
+  d->entries = (player_directory_entry *) (d->header + 1);
+  d->slots = (uint32_t *) (d->entries + capacity);
+  d->size = size;
+  return 0;
+}
+
+// Every id unused, in order
+static void
+player_directory_create(player_directory *d, uint32_t capacity) {
+  *d->header = (player_directory_header){.magic = PLAYER_DIRECTORY_MAGIC,
+										 .version = PLAYER_DIRECTORY_VERSION,
+										 .capacity = capacity,
+										 .free_id = 1};
+  for (uint32_t i = 0; i < capacity; i++)
+	d->slots[i] = PLAYER_DIRECTORY_FREE_ID | (i + 1 < capacity ? i + 2 : 0);
+}
+
+int
+player_directory_open(player_directory *d, const char *path,
+					  uint32_t capacity) {
+  player_directory_header h;
+  struct stat st;
+
+  memset(d, '\0', sizeof(*d));
+  d->fd = -1;
+  if (capacity < 2 || capacity & (capacity - 1)
+	  || capacity >= PLAYER_DIRECTORY_FREE_ID)
+	return 1;
+
+  if (!path) {
+	if (player_directory_map(d, capacity))
+	  return 2;
+	player_directory_create(d, capacity);
+	return 0;
+  }
+
+  if ((d->fd = open(path, O_RDWR | O_CREAT, 0644)) < 0
+	  || fstat(d->fd, &st)) {
+	player_directory_close(d);
+	return 2;
+  }
+
+  if (!st.st_size) {
+	if (ftruncate(d->fd, (off_t) player_directory_size(capacity))
+		|| player_directory_map(d, capacity)) {
+	  player_directory_close(d);
+	  return 2;
+	}
+	player_directory_create(d, capacity);
+	return 0;
+  }
+
+  // An existing file keeps its capacity
+  if ((size_t) st.st_size < sizeof(h)
+	  || pread(d->fd, &h, sizeof(h), 0) != sizeof(h)
+	  || h.magic != PLAYER_DIRECTORY_MAGIC
+	  || h.version != PLAYER_DIRECTORY_VERSION || h.capacity < 2
+	  || h.capacity & (h.capacity - 1) || h.capacity >= PLAYER_DIRECTORY_FREE_ID
+	  || (size_t) st.st_size != player_directory_size(h.capacity)
+	  || player_directory_map(d, h.capacity)) {
+	DERROR_PRINTF("'%s' is no player directory", path);
+	player_directory_close(d);
+	return 3;
+  }
+  for (uint32_t i = 0; i < h.capacity; i++)
+	if (d->entries[i].id)
+	  d->entries[i].gupid = -1;
+  return 0;
+}
+
+void
+player_directory_close(player_directory *d) {
+  if (d->header)
+	munmap(d->header, d->size);
+  if (d->fd >= 0)
+	close(d->fd);
+  d->header = NULL;
+  d->entries = NULL;
+  d->slots = NULL;
+  d->fd = -1;
+}
+
+player_directory_entry *
+player_directory_find(const player_directory *d, const char *name,
+					  size_t name_length) {
+  const uint32_t mask = d->header->capacity - 1;
+  const uint32_t hash = player_directory_hash(name, name_length);
+  player_directory_entry *e;
+
+  for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+	e = &d->entries[slot];
+	if (!e->id)
+	  return NULL;
+	if (e->hash == hash && e->name_length == name_length
+		&& !memcmp(e->name, name, name_length))
+	  return e;
+  }
+}
+
+// Backward shift deletion, the entries after the slot move up unless that
+// would put them before their home slot, so no probe crosses a free slot.
+// The ids go with the entries.
+static void
+player_directory_remove(player_directory *d, uint32_t slot) {
+  const uint32_t mask = d->header->capacity - 1;
+  const uint32_t id = d->entries[slot].id;
+  uint32_t home;
+
+  for (uint32_t next = (slot + 1) & mask; d->entries[next].id;
+	   next = (next + 1) & mask) {
+	home = d->entries[next].hash & mask;
+	if (((next - home) & mask) < ((next - slot) & mask))
+	  continue;
+	d->entries[slot] = d->entries[next];
+	d->slots[d->entries[slot].id - 1] = slot;
+	slot = next;
+  }
+  d->slots[id - 1] = PLAYER_DIRECTORY_FREE_ID | d->header->free_id;
+  d->header->free_id = id;
+  memset(&d->entries[slot], '\0', sizeof(d->entries[slot]));
+  d->header->count--;
+}
+
+static int
+player_directory_evict(player_directory *d) {
+  const uint32_t mask = d->header->capacity - 1;
+  uint32_t slot = d->evict_next, victim = UINT32_MAX, seen = 0;
+  player_directory_entry *e;
+
+  for (uint32_t i = 0; i <= mask && seen < PLAYER_DIRECTORY_EVICT_SAMPLES;
+	   i++, slot = (slot + 1) & mask) {
+	e = &d->entries[slot];
+	if (!e->id || e->gupid >= 0)
+	  continue;
+	if (!seen++ || e->last_seen < d->entries[victim].last_seen)
+	  victim = slot;
+  }
+  if (!seen)
+	return 1;
+  d->evict_next = slot;
+  player_directory_remove(d, victim);
+  return 0;
+}
+
+int
+player_directory_intern(player_directory *d, const char *name,
+						size_t name_length, player_directory_entry **e) {
+  const uint32_t mask = d->header->capacity - 1;
+  const uint32_t hash = player_directory_hash(name, name_length);
+  uint32_t slot, id;
+
+  if ((*e = player_directory_find(d, name, name_length)))
+	return 0;
+  if (name_length >= PLAYER_MAX_NAME_LENGTH
+	  || (d->header->count >= d->header->capacity / 4 * 3
+		  && player_directory_evict(d)))
+	return 1;
+
+  for (slot = hash & mask; d->entries[slot].id; slot = (slot + 1) & mask)
+	;
+  *e = &d->entries[slot];
+  memset(*e, '\0', sizeof(**e));
+  memcpy((*e)->name, name, name_length);
+  (*e)->name_length = (uint32_t) name_length;
+  (*e)->hash = hash;
+  (*e)->gupid = -1;
+  // Below three quarters full there is always an unused id
+  id = d->header->free_id;
+  d->header->free_id = d->slots[id - 1] & ~PLAYER_DIRECTORY_FREE_ID;
+  d->slots[id - 1] = slot;
+  // Set last, a slot with an id is taken
+  (*e)->id = id;
+  d->header->count++;
+  return 0;
+}
+
+player_directory_entry *
+player_directory_get(const player_directory *d, uint32_t id) {
+  if (!id || id > d->header->capacity
+	  || d->slots[id - 1] & PLAYER_DIRECTORY_FREE_ID)
+	return NULL;
+  return &d->entries[d->slots[id - 1]];
+}
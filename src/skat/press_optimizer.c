@@ -0,0 +1,300 @@
+#include "skat/press_optimizer.h"
+#include "skat/hand_eval.h"
+#include "skat/reizen.h"
+#include "skat/sampler.h"
+#include "skat/util.h"
+#include <string.h>
+#include <time.h>
+
+#define PRESS_OPTIMIZER_PRESSES     (66)// C(12, 2)
+#define PRESS_OPTIMIZER_BATCH       (4)// deals per round
+#define PRESS_OPTIMIZER_MIN_SAMPLES (4)// before an option may be dropped
+#define PRESS_OPTIMIZER_UNFINISHED  (2)
+
+typedef struct press_search {
+  const press_query *q;
+  press_option *options;
+  solver_position positions[PRESS_OPTIMIZER_OPTIONS];
+  size_t active[PRESS_OPTIMIZER_OPTIONS];
+  size_t active_length;
+  deal deals[PRESS_OPTIMIZER_BATCH];
+  uint8_t won[PRESS_OPTIMIZER_OPTIONS][PRESS_OPTIMIZER_BATCH];
+  uint32_t next_job;
+  struct timespec deadline;
+} press_search;
+
+typedef struct press_worker {
+  press_search *ps;
+  solver *sv;
+} press_worker;
+
+// One job is one active option on one deal of the round
+static void
+press_worker_run(void *args) {
+  press_worker *w = args;
+  press_search *ps = w->ps;
+  const int as = ps->q->alleinspieler;
+  const uint32_t jobs = ps->active_length * PRESS_OPTIMIZER_BATCH;
+  solver_position pos;
+  int won, complete;
+  int64_t left;
+
+  for (;;) {
+	uint32_t j = __atomic_fetch_add(&ps->next_job, 1, __ATOMIC_RELAXED);
+	if (j >= jobs || (left = deadline_millis_left(&ps->deadline)) <= 0)
+	  return;
+	size_t o = ps->active[j % ps->active_length];
+	uint32_t d = j / ps->active_length;
+
+	pos = ps->positions[o];
+	for (int p = 0; p < 3; p++)
+	  if (p != as)
+		pos.hands[p] = ps->deals[d].hands[p];
+	solver_limits limits = {.threads = 1,
+							.max_millis = left,
+							.eval_stiche = ps->q->eval_stiche,
+							.eval = ps->q->eval};
+	if (solver_reaches_limited(w->sv, &pos, 61, &limits, &won, &complete)) {
+	  DERROR_PRINTF("Solver rejected a sampled position");
+	  return;
+	}
+	if (complete)
+	  ps->won[o][d] = won;
+  }
+}
+
+// Win rate with one won and one lost game added, so unsampled options sit
+// in the middle
+static int
+press_option_better(const press_option *const a, const press_option *const b) {
+  return (uint64_t) (a->wins + 1) * (b->samples + 2)
+		 > (uint64_t) (b->wins + 1) * (a->samples + 2);
+}
+
+// Options with few samples do not get past the fallback
+static int
+press_option_ranked(const press_option *const o) {
+  return o->fallback || o->samples >= PRESS_OPTIMIZER_MIN_RANKED;
+}
+
+static int
+press_option_compare(const void *va, const void *vb) {
+  const press_option *a = va, *b = vb;
+  if (press_option_ranked(a) != press_option_ranked(b))
+	return press_option_ranked(b) - press_option_ranked(a);
+  if (press_option_better(a, b))
+	return -1;
+  if (press_option_better(b, a))
+	return 1;
+  if (a->fallback != b->fallback)
+	return b->fallback - a->fallback;
+  if (a->samples != b->samples)
+	return (int) b->samples - (int) a->samples;
+  return b->margin - a->margin;
+}
+
+// Drops options whose win rate is more than two standard errors below the
+// best one
+static void
+press_prune(press_search *const ps) {
+  const press_option *best = NULL, *o;
+  double p_best = 0, var_best = 0, p, var, diff;
+  size_t kept = 0;
+
+  for (size_t i = 0; i < ps->active_length; i++) {
+	o = &ps->options[ps->active[i]];
+	if (o->samples >= PRESS_OPTIMIZER_MIN_SAMPLES
+		&& (!best || press_option_better(o, best)))
+	  best = o;
+  }
+  if (!best)
+	return;
+  p_best = (best->wins + 1.0) / (best->samples + 2.0);
+  var_best = p_best * (1 - p_best) / best->samples;
+
+  for (size_t i = 0; i < ps->active_length; i++) {
+	o = &ps->options[ps->active[i]];
+	if (o->samples >= PRESS_OPTIMIZER_MIN_SAMPLES) {
+	  p = (o->wins + 1.0) / (o->samples + 2.0);
+	  var = p * (1 - p) / o->samples;
+	  diff = p_best - p;
+	  if (diff > 0 && diff * diff > 4 * (var_best + var))
+		continue;
+	}
+	ps->active[kept++] = ps->active[i];
+  }
+  ps->active_length = kept;
+}
+
+// The hand_eval press of gr first, then the presses that leave the best
+// rest of the hand, more points in the skat first
+static size_t
+press_shortlist(const card_collection cards, const game_rules *const gr,
+				card_collection presses[PRESS_OPTIMIZER_SHORTLIST],
+				int margins[PRESS_OPTIMIZER_SHORTLIST]) {
+  card_collection candidates[PRESS_OPTIMIZER_PRESSES];
+  card_collection rests[PRESS_OPTIMIZER_PRESSES];
+  int candidate_margins[PRESS_OPTIMIZER_PRESSES];
+  unsigned int points[PRESS_OPTIMIZER_SHORTLIST], p;
+  size_t n = 0, length = 1, i;
+
+  for (card_collection a = cards; a; a &= a - 1) {
+	for (card_collection b = a & (a - 1); b; b &= b - 1) {
+	  candidates[n] = (a & -a) | (b & -b);
+	  rests[n] = cards & ~candidates[n];
+	  n++;
+	}
+  }
+  if (hand_eval_margins(gr, rests, n, candidate_margins))
+	return 0;
+
+  presses[0] = hand_eval_press(cards, gr);
+  margins[0] = hand_eval_margin(cards & ~presses[0], gr);
+  points[0] = 0;
+
+  for (size_t c = 0; c < n; c++) {
+	if (candidates[c] == presses[0])
+	  continue;
+	p = 0;
+	if (gr->type != GAME_TYPE_NULL)
+	  card_collection_get_score(&candidates[c], &p);
+
+	for (i = length; i > 1; i--) {
+	  if (margins[i - 1] > candidate_margins[c]
+		  || (margins[i - 1] == candidate_margins[c] && points[i - 1] >= p))
+		break;
+	  if (i < PRESS_OPTIMIZER_SHORTLIST) {
+		presses[i] = presses[i - 1];
+		margins[i] = margins[i - 1];
+		points[i] = points[i - 1];
+	  }
+	}
+	if (i < PRESS_OPTIMIZER_SHORTLIST) {
+	  presses[i] = candidates[c];
+	  margins[i] = candidate_margins[c];
+	  points[i] = p;
+	  if (length < PRESS_OPTIMIZER_SHORTLIST)
+		length++;
+	}
+  }
+  return length;
+}
+
+static void
+press_search_init(press_search *const ps, const press_query *const q,
+				  press_option *const options, size_t *const length) {
+  card_collection presses[PRESS_OPTIMIZER_SHORTLIST], fallback_press;
+  int margins[PRESS_OPTIMIZER_SHORTLIST];
+  game_rules fallback;
+  unsigned int points;
+  size_t n;
+
+  hand_eval_choose_game(q->cards, 1, 0, q->reizwert, &fallback,
+						&fallback_press);
+
+  *length = 0;
+  for (int pass = 0; pass < 2 && !*length; pass++) {
+	for (int g = 0; g < PRESS_OPTIMIZER_GAMES; g++) {
+	  const game_rules *gr = &hand_eval_games[g];
+	  // Overbid games are lost anyway, unless every game is overbid
+	  if (!pass && reizen_get_min_game_value(gr, q->cards) < q->reizwert)
+		continue;
+
+	  n = press_shortlist(q->cards, gr, presses, margins);
+	  for (size_t i = 0; i < n; i++) {
+		press_option *o = &options[*length];
+		solver_position *pos = &ps->positions[*length];
+		memset(o, '\0', sizeof(*o));
+		o->press = presses[i];
+		o->gr = *gr;
+		o->margin = margins[i];
+		o->fallback = gr->type == fallback.type
+					  && gr->trumpf == fallback.trumpf
+					  && o->press == fallback_press;
+
+		memset(pos, '\0', sizeof(*pos));
+		pos->gr = *gr;
+		pos->alleinspieler = q->alleinspieler;
+		pos->hands[q->alleinspieler] = q->cards & ~o->press;
+		pos->curr_stich =
+				(stich){.played_cards = 0, .vorhand = 0, .winner = -1};
+		card_collection_get_score(&o->press, &points);
+		pos->alleinspieler_points = gr->type == GAME_TYPE_NULL ? 0 : points;
+
+		ps->active[*length] = *length;
+		(*length)++;
+	  }
+	}
+  }
+  ps->active_length = *length;
+}
+
+int
+press_optimize(thread_pool *tp, solver *solvers, rng *r, const press_query *q,
+			   press_option options[PRESS_OPTIMIZER_OPTIONS], size_t *length) {
+  press_worker workers[THREAD_POOL_MAX_THREADS];
+  press_search *ps;
+  sampler s;
+  card_collection skat;
+  uint32_t rounds = 0;
+
+  if (__builtin_popcount(q->cards) != 12 || q->alleinspieler < 0
+	  || q->alleinspieler > 2 || !q->millis)
+	return 1;
+
+  // Which two cards are in the skat does not change the other two hands
+  skat = q->cards & -q->cards;
+  skat |= (q->cards & ~skat) & -(q->cards & ~skat);
+  sampler_init(&s);
+  if (sampler_set_known(&s, q->alleinspieler, q->cards & ~skat)
+	  || sampler_set_known(&s, SAMPLER_SKAT, skat) || sampler_prepare(&s)) {
+	sampler_free(&s);
+	return 1;
+  }
+
+  ps = malloc(sizeof(*ps));
+  if (!ps) {
+	sampler_free(&s);
+	return 2;
+  }
+  ps->q = q;
+  ps->options = options;
+  press_search_init(ps, q, options, length);
+
+  deadline_after_millis(&ps->deadline, q->millis);
+
+  while (ps->active_length > 1 && deadline_millis_left(&ps->deadline) > 0
+		 && (!q->max_samples
+			 || rounds * PRESS_OPTIMIZER_BATCH < q->max_samples)) {
+	for (int d = 0; d < PRESS_OPTIMIZER_BATCH; d++)
+	  sampler_draw(&s, r, &ps->deals[d]);
+	memset(ps->won, PRESS_OPTIMIZER_UNFINISHED, sizeof(ps->won));
+	ps->next_job = 0;
+
+	for (int t = 0; t < tp->thread_count; t++) {
+	  workers[t] = (press_worker){.ps = ps, .sv = &solvers[t]};
+	  thread_pool_submit(tp, &(async_callback){.do_stuff = press_worker_run,
+											   .data = &workers[t]});
+	}
+	thread_pool_wait(tp);
+
+	for (size_t i = 0; i < ps->active_length; i++) {
+	  press_option *o = &options[ps->active[i]];
+	  for (int d = 0; d < PRESS_OPTIMIZER_BATCH; d++) {
+		if (ps->won[ps->active[i]][d] == PRESS_OPTIMIZER_UNFINISHED)
+		  continue;
+		o->samples++;
+		o->wins += ps->won[ps->active[i]][d];
+	  }
+	}
+	press_prune(ps);
+	rounds++;
+  }
+
+  DEBUG_PRINTF("Ranked %zu presses after %u rounds, %zu left undecided",
+			   *length, rounds, ps->active_length);
+  qsort(options, *length, sizeof(*options), press_option_compare);
+  free(ps);
+  sampler_free(&s);
+  return 0;
+}
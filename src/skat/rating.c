@@ -0,0 +1,418 @@
+#include "skat/rating.h"
+#include "skat/thread_pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RATING_BATCH_ROUNDS (4096)// parsed at once by the recompute threads
+
+typedef struct rating_batch_round {
+  archive_round ar;
+  int won;
+  int valid;
+} rating_batch_round;
+
+typedef struct rating_batch {
+  char **lines;
+  rating_batch_round *rounds;
+  uint32_t length;
+  uint32_t next;
+} rating_batch;
+
+static uint64_t
+rating_hash(const char *name) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (; *name; name++)
+	h = (h ^ (uint8_t) *name) * 0x100000001b3ull;
+  return h;
+}
+
+static uint16_t
+rating_bin(double rating) {
+  if (rating < 0)
+	return 0;
+  if (rating >= RATING_BINS - 1)
+	return RATING_BINS - 1;
+  return (uint16_t) rating;
+}
+
+// Fenwick positions count from the best bin
+static void
+rating_tree_add(rating_table *t, uint16_t bin, int32_t delta) {
+  for (uint32_t i = RATING_BINS - bin; i <= RATING_BINS; i += i & -i)
+	t->tree[i] += delta;
+}
+
+// Players in bins above bin
+static uint32_t
+rating_tree_above(const rating_table *t, uint16_t bin) {
+  uint32_t sum = 0;
+  for (uint32_t i = RATING_BINS - 1 - bin; i; i -= i & -i)
+	sum += t->tree[i];
+  return sum;
+}
+
+// The bin of the player with rank + 1, counting from the best
+static uint16_t
+rating_tree_find(const rating_table *t, uint32_t rank) {
+  uint32_t pos = 0;
+  for (uint32_t step = RATING_BINS; step; step >>= 1)
+	if (pos + step <= RATING_BINS && t->tree[pos + step] <= rank) {
+	  pos += step;
+	  rank -= t->tree[pos];
+	}
+  return (uint16_t) (RATING_BINS - 1 - pos);
+}
+
+// Bins are kept sorted, best first
+static void
+rating_bin_insert(rating_table *t, uint32_t index) {
+  rating_player *p = &t->players[index];
+  uint32_t prev = RATING_NONE, next;
+
+  p->bin = rating_bin(p->rating);
+  for (next = t->head[p->bin];
+	   next != RATING_NONE && t->players[next].rating > p->rating;
+	   next = t->players[next].next)
+	prev = next;
+  p->prev = prev;
+  p->next = next;
+  if (next != RATING_NONE)
+	t->players[next].prev = index;
+  if (prev != RATING_NONE)
+	t->players[prev].next = index;
+  else
+	t->head[p->bin] = index;
+  rating_tree_add(t, p->bin, 1);
+}
+
+static void
+rating_bin_remove(rating_table *t, uint32_t index) {
+  rating_player *p = &t->players[index];
+  if (p->prev != RATING_NONE)
+	t->players[p->prev].next = p->next;
+  else
+	t->head[p->bin] = p->next;
+  if (p->next != RATING_NONE)
+	t->players[p->next].prev = p->prev;
+  rating_tree_add(t, p->bin, -1);
+}
+
+static void
+rating_set(rating_table *t, uint32_t index, double rating) {
+  rating_player *p = &t->players[index];
+  p->rating = rating;
+  if (rating_bin(rating) == p->bin
+	  && (p->prev == RATING_NONE || t->players[p->prev].rating >= rating)
+	  && (p->next == RATING_NONE || t->players[p->next].rating <= rating))
+	return;
+  rating_bin_remove(t, index);
+  rating_bin_insert(t, index);
+}
+
+static int
+rating_grow(rating_table *t) {
+  uint32_t capacity = t->capacity ? 2 * t->capacity : 64, *index;
+  rating_player *players;
+
+  if (!(players = realloc(t->players, capacity * sizeof(*players))))
+	return 1;
+  t->players = players;
+  // Twice as many slots as players
+  if (!(index = malloc(2 * capacity * sizeof(*index))))
+	return 1;
+  memset(index, 0xff, 2 * capacity * sizeof(*index));
+  free(t->index);
+  t->index = index;
+  t->index_mask = 2 * capacity - 1;
+  t->capacity = capacity;
+
+  for (uint32_t i = 0; i < t->count; i++) {
+	uint32_t slot = rating_hash(t->players[i].name) & t->index_mask;
+	while (t->index[slot] != RATING_NONE)
+	  slot = (slot + 1) & t->index_mask;
+	t->index[slot] = i;
+  }
+  return 0;
+}
+
+int
+rating_init(rating_table *t) {
+  memset(t, '\0', sizeof(*t));
+  memset(t->head, 0xff, sizeof(t->head));
+  return rating_grow(t);
+}
+
+void
+rating_free(rating_table *t) {
+  free(t->players);
+  free(t->index);
+  memset(t, '\0', sizeof(*t));
+}
+
+uint32_t
+rating_find(const rating_table *t, const char *name) {
+  uint32_t slot = rating_hash(name) & t->index_mask;
+  for (; t->index[slot] != RATING_NONE; slot = (slot + 1) & t->index_mask)
+	if (!strcmp(t->players[t->index[slot]].name, name))
+	  return t->index[slot];
+  return RATING_NONE;
+}
+
+int
+rating_find_or_add(rating_table *t, const char *name, uint32_t *index) {
+  rating_player *p;
+  uint32_t slot;
+
+  if ((*index = rating_find(t, name)) != RATING_NONE)
+	return 0;
+  if (strlen(name) > PLAYER_MAX_NAME_LENGTH
+	  || (t->count == t->capacity && rating_grow(t)))
+	return 1;
+
+  *index = t->count++;
+  p = &t->players[*index];
+  memset(p, '\0', sizeof(*p));
+  strcpy(p->name, name);
+  p->rating = RATING_INITIAL;
+  rating_bin_insert(t, *index);
+
+  slot = rating_hash(name) & t->index_mask;
+  while (t->index[slot] != RATING_NONE)
+	slot = (slot + 1) & t->index_mask;
+  t->index[slot] = *index;
+  return 0;
+}
+
+static double
+rating_k(const rating_player *p) {
+  return p->games < RATING_NEW_GAMES ? RATING_K_NEW : RATING_K;
+}
+
+int
+rating_update(rating_table *t, const char *const names[3], int alleinspieler,
+			  int won) {
+  uint32_t idx[3];
+  double against = 0, expected, delta;
+  rating_player *as;
+
+  if (alleinspieler < 0 || alleinspieler > 2)
+	return 1;
+  for (int ap = 0; ap < 3; ap++)
+	if (rating_find_or_add(t, names[ap], &idx[ap]))
+	  return 1;
+  // Somebody playing under two seats only counts once
+  if (idx[0] == idx[1] || idx[0] == idx[2] || idx[1] == idx[2])
+	return 1;
+
+  for (int ap = 0; ap < 3; ap++)
+	if (ap != alleinspieler)
+	  against += t->players[idx[ap]].rating / 2;
+  as = &t->players[idx[alleinspieler]];
+  expected = 1 / (1 + pow(10, (against - as->rating) / 400));
+  delta = (won ? 1 : 0) - expected;
+
+  for (int ap = 0; ap < 3; ap++) {
+	rating_player *p = &t->players[idx[ap]];
+	if (ap == alleinspieler)
+	  rating_set(t, idx[ap], p->rating + rating_k(p) * delta);
+	else
+	  rating_set(t, idx[ap], p->rating - rating_k(p) * delta / 2);
+	p->games++;
+  }
+  if (won)
+	as->won++;
+  else
+	as->lost++;
+  return 0;
+}
+
+int
+rating_update_round(rating_table *t, const archive_round *ar) {
+  const char *names[3] = {ar->names[0], ar->names[1], ar->names[2]};
+  int won;
+
+  if (archive_round_won(ar, &won))
+	return 1;
+  return rating_update(t, names, ar->alleinspieler, won);
+}
+
+uint32_t
+rating_rank(const rating_table *t, uint32_t index) {
+  const rating_player *p = &t->players[index];
+  uint32_t rank = rating_tree_above(t, p->bin) + 1;
+
+  // Only the better players of its bin come before it
+  for (uint32_t i = t->head[p->bin];
+	   i != RATING_NONE && t->players[i].rating > p->rating;
+	   i = t->players[i].next)
+	rank++;
+  return rank;
+}
+
+uint32_t
+rating_top(const rating_table *t, uint32_t k, uint32_t *indices) {
+  uint32_t n = 0;
+
+  if (k > t->count)
+	k = t->count;
+  while (n < k)
+	for (uint32_t i = t->head[rating_tree_find(t, n)];
+		 i != RATING_NONE && n < k; i = t->players[i].next)
+	  indices[n++] = i;
+  return n;
+}
+
+static void
+rating_batch_run(void *args) {
+  rating_batch *b = args;
+  uint32_t i;
+
+  while ((i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED)) < b->length) {
+	rating_batch_round *r = &b->rounds[i];
+	r->valid = !archive_parse(b->lines[i], &r->ar)
+			   && (r->ar.alleinspieler < 0
+				   || !archive_round_won(&r->ar, &r->won));
+  }
+}
+
+int
+rating_recompute(rating_table *t, FILE *archive, int threads,
+				 uint64_t *skipped) {
+  rating_batch b = {.length = 0};
+  thread_pool tp;
+  char *line = NULL;
+  size_t line_size = 0;
+  int done = 0, error = 0;
+
+  *skipped = 0;
+  if (threads < 1 || threads > THREAD_POOL_MAX_THREADS)
+	return 1;
+  b.lines = calloc(RATING_BATCH_ROUNDS, sizeof(*b.lines));
+  b.rounds = malloc(RATING_BATCH_ROUNDS * sizeof(*b.rounds));
+  if (!b.lines || !b.rounds) {
+	free(b.lines);
+	free(b.rounds);
+	return 2;
+  }
+
+  rating_free(t);
+  if (rating_init(t) || thread_pool_init(&tp, threads, "ratings")) {
+	free(b.lines);
+	free(b.rounds);
+	return 2;
+  }
+
+  while (!done && !error) {
+	for (b.length = 0; b.length < RATING_BATCH_ROUNDS;) {
+	  if (getline(&line, &line_size, archive) == -1) {
+		done = 1;
+		break;
+	  }
+	  if (line[0] == '\n' || line[0] == '#')
+		continue;
+	  free(b.lines[b.length]);
+	  if (!(b.lines[b.length++] = strdup(line))) {
+		error = 2;
+		break;
+	  }
+	}
+	if (error || !b.length)
+	  break;
+
+	b.next = 0;
+	for (int i = 0; i < threads; i++)
+	  thread_pool_submit(&tp, &(async_callback){.do_stuff = rating_batch_run,
+												.data = &b});
+	thread_pool_wait(&tp);
+
+	// Ratings depend on the order of the games
+	for (uint32_t i = 0; i < b.length; i++) {
+	  if (!b.rounds[i].valid) {
+		++*skipped;
+		continue;
+	  }
+	  if (b.rounds[i].ar.alleinspieler < 0)
+		continue;
+	  const char *names[3] = {b.rounds[i].ar.names[0], b.rounds[i].ar.names[1],
+							  b.rounds[i].ar.names[2]};
+	  if (rating_update(t, names, b.rounds[i].ar.alleinspieler,
+						b.rounds[i].won))
+		++*skipped;
+	}
+  }
+  thread_pool_free(&tp);
+
+  for (uint32_t i = 0; i < RATING_BATCH_ROUNDS; i++)
+	free(b.lines[i]);
+  free(b.lines);
+  free(b.rounds);
+  free(line);
+  return error || ferror(archive);
+}
+
+int
+rating_write_players(const rating_player *players, uint32_t count,
+					 const char *path) {
+  char tmp[4096];
+  FILE *f;
+  int error;
+
+  if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int) sizeof(tmp)
+	  || !(f = fopen(tmp, "w")))
+	return 1;
+  fprintf(f, "# name\trating\tgames\twon\tlost\n");
+  for (uint32_t i = 0; i < count; i++)
+	fprintf(f, "%s\t%.3f\t%u\t%u\t%u\n", players[i].name, players[i].rating,
+			players[i].games, players[i].won, players[i].lost);
+  error = ferror(f);
+  error |= fclose(f);
+  if (error || rename(tmp, path)) {
+	remove(tmp);
+	return 1;
+  }
+  return 0;
+}
+
+int
+rating_write_file(const rating_table *t, const char *path) {
+  return rating_write_players(t->players, t->count, path);
+}
+
+int
+rating_read_file(rating_table *t, const char *path) {
+  char *line = NULL, *rest, *fields[5], *end;
+  size_t line_size = 0;
+  uint32_t index;
+  rating_player *p;
+  FILE *f;
+  int error = 0;
+
+  if (!(f = fopen(path, "r")))
+	return 1;
+  while (!error && getline(&line, &line_size, f) != -1) {
+	if (line[0] == '\n' || line[0] == '#')
+	  continue;
+	line[strcspn(line, "\r\n")] = '\0';
+	rest = line;
+	for (int i = 0; i < 5 && !error; i++)
+	  error = !(fields[i] = strsep(&rest, "\t"));
+	if (error || rest || rating_find_or_add(t, fields[0], &index)) {
+	  error = 1;
+	  break;
+	}
+
+	p = &t->players[index];
+	rating_set(t, index, strtod(fields[1], &end));
+	error = *end != '\0';
+	p->games = strtoul(fields[2], &end, 10);
+	error |= *end != '\0';
+	p->won = strtoul(fields[3], &end, 10);
+	error |= *end != '\0';
+	p->lost = strtoul(fields[4], &end, 10);
+	error |= *end != '\0';
+  }
+  free(line);
+  fclose(f);
+  return error;
+}
@@ -107,6 +107,26 @@ reizen_get_grundwert(game_rules const *gr) {
 									 : grundwerte_color[gr->trumpf - 1];
 }
 
+// Value of gr won without schneider or schwarz beyond the announced ones,
+// cards are the hand with the skat
+uint16_t
+reizen_get_min_game_value(const game_rules *gr, card_collection cards) {
+  if (gr->type == GAME_TYPE_NULL) {
+	if (gr->hand)
+	  return gr->ouvert ? spielwert_null_hand_ouvert : spielwert_null_hand;
+	return gr->ouvert ? spielwert_null_ouvert : spielwert_null;
+  }
+  if (gr->type != GAME_TYPE_COLOR && gr->type != GAME_TYPE_GRAND)
+	return 0;
+
+  int8_t spitzen = reizen_count_spitzen(gr, &cards);
+  if (spitzen < 0)
+	spitzen = -spitzen;
+  return (spitzen + 1 + gr->hand + gr->schneider_angesagt
+		  + gr->schwarz_angesagt + gr->ouvert)
+		 * reizen_get_grundwert(gr);
+}
+
 // Do NOT use for ramschen
 uint16_t
 reizen_get_game_value(skat_server_state *ss, int won, int schneider,
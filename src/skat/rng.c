@@ -0,0 +1,145 @@
+#include "skat/rng.h"
+#include "skat/util.h"
+#include <string.h>
+#include <sys/random.h>
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define CHACHA_QUARTER_ROUND(x, a, b, c, d) \
+  do { \
+	x[a] += x[b]; \
+	x[d] = ROTL32(x[d] ^ x[a], 16); \
+	x[c] += x[d]; \
+	x[b] = ROTL32(x[b] ^ x[c], 12); \
+	x[a] += x[b]; \
+	x[d] = ROTL32(x[d] ^ x[a], 8); \
+	x[c] += x[d]; \
+	x[b] = ROTL32(x[b] ^ x[c], 7); \
+  } while (0)
+
+static void
+rng_refill(rng *r) {
+  uint32_t x[16];
+  memcpy(x, r->state, sizeof(x));
+
+  for (int i = 0; i < 10; i++) {
+	CHACHA_QUARTER_ROUND(x, 0, 4, 8, 12);
+	CHACHA_QUARTER_ROUND(x, 1, 5, 9, 13);
+	CHACHA_QUARTER_ROUND(x, 2, 6, 10, 14);
+	CHACHA_QUARTER_ROUND(x, 3, 7, 11, 15);
+	CHACHA_QUARTER_ROUND(x, 0, 5, 10, 15);
+	CHACHA_QUARTER_ROUND(x, 1, 6, 11, 12);
+	CHACHA_QUARTER_ROUND(x, 2, 7, 8, 13);
+	CHACHA_QUARTER_ROUND(x, 3, 4, 9, 14);
+  }
+
+  for (int i = 0; i < 16; i++)
+	r->buf[i] = x[i] + r->state[i];
+
+  // 64 bit block counter
+  if (!++r->state[12])
+	r->state[13]++;
+
+  r->buf_pos = 0;
+}
+
+static void
+rng_init_key(rng *r, const uint32_t key[8]) {
+  r->state[0] = 0x61707865;// "expand 32-byte k"
+  r->state[1] = 0x3320646e;
+  r->state[2] = 0x79622d32;
+  r->state[3] = 0x6b206574;
+  memcpy(&r->state[4], key, 8 * sizeof(uint32_t));
+  r->state[12] = r->state[13] = 0;// counter
+  r->state[14] = r->state[15] = 0;// nonce
+  r->buf_pos = 16;
+}
+
+// splitmix64, only used to spread small seeds over the whole key
+static uint64_t
+rng_splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15u);
+  z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9u;
+  z = (z ^ (z >> 27u)) * 0x94d049bb133111ebu;
+  return z ^ (z >> 31u);
+}
+
+void
+rng_seed(rng *r, uint64_t seed) {
+  uint32_t key[8];
+  for (int i = 0; i < 8; i += 2) {
+	uint64_t k = rng_splitmix64(&seed);
+	key[i] = (uint32_t) k;
+	key[i + 1] = (uint32_t) (k >> 32u);
+  }
+  rng_init_key(r, key);
+}
+
+int
+rng_seed_random(rng *r) {
+  uint32_t key[8];
+  ssize_t res = getrandom(key, sizeof(key), 0);
+  if (res < 0 || (size_t) res != sizeof(key)) {
+	DERROR_PRINTF("Could not seed random number generator from getrandom");
+	return 1;
+  }
+  rng_init_key(r, key);
+  return 0;
+}
+
+rng *
+rng_thread(void) {
+  static __thread rng thread_rng;
+  static __thread int seeded = 0;
+
+  if (!seeded) {
+	if (rng_seed_random(&thread_rng)) {
+	  perror("Error while seeding thread local random number generator");
+	  exit(EXIT_FAILURE);
+	}
+	seeded = 1;
+  }
+
+  return &thread_rng;
+}
+
+uint32_t
+rng_next_u32(rng *r) {
+  if (r->buf_pos >= 16)
+	rng_refill(r);
+  return r->buf[r->buf_pos++];
+}
+
+uint64_t
+rng_next_u64(rng *r) {
+  uint64_t lo = rng_next_u32(r);
+  return lo | ((uint64_t) rng_next_u32(r) << 32u);
+}
+
+// Lemire's nearly divisionless method, unbiased in [0, bound)
+uint32_t
+rng_bounded_u32(rng *r, uint32_t bound) {
+  uint64_t m = (uint64_t) rng_next_u32(r) * bound;
+  uint32_t l = (uint32_t) m;
+  if (l < bound) {
+	uint32_t threshold = -bound % bound;
+	while (l < threshold) {
+	  m = (uint64_t) rng_next_u32(r) * bound;
+	  l = (uint32_t) m;
+	}
+  }
+  return m >> 32u;
+}
+
+uint64_t
+rng_bounded_u64(rng *r, uint64_t bound) {
+  if (bound <= UINT32_MAX)
+	return rng_bounded_u32(r, (uint32_t) bound);
+
+  uint64_t threshold = -bound % bound;
+  uint64_t x;
+  do {
+	x = rng_next_u64(r);
+  } while (x < threshold);
+  return x % bound;
+}
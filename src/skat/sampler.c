@@ -0,0 +1,213 @@
+#include "skat/sampler.h"
+#include "skat/util.h"
+#include <stdlib.h>
+#include <string.h>
+
+void
+sampler_init(sampler *s) {
+  memset(s, '\0', sizeof(*s));
+  for (int p = 0; p < 3; p++)
+	s->size[p] = 10;
+  s->size[SAMPLER_SKAT] = 2;
+}
+
+void
+sampler_free(sampler *s) {
+  free(s->splits);
+  s->splits = NULL;
+  s->split_count = s->split_capacity = 0;
+}
+
+int
+sampler_set_known(sampler *s, int place, card_collection cards) {
+  if (place < 0 || place >= SAMPLER_PLACES || (cards & s->played))
+	return 1;
+  for (int p = 0; p < SAMPLER_PLACES; p++)
+	if (p != place && (cards & s->known[p]))
+	  return 1;
+  s->known[place] |= cards;
+  return 0;
+}
+
+int
+sampler_set_played(sampler *s, int place, card_collection cards) {
+  cards &= ~s->played;
+  if (place < 0 || place >= SAMPLER_SKAT
+	  || __builtin_popcount(cards) > s->size[place])
+	return 1;
+  for (int p = 0; p < SAMPLER_PLACES; p++)
+	s->known[p] &= ~cards;
+  s->size[place] -= __builtin_popcount(cards);
+  s->played |= cards;
+  return 0;
+}
+
+int
+sampler_set_void(sampler *s, int place, card_collection cards) {
+  if (place < 0 || place >= SAMPLER_SKAT)
+	return 1;
+  s->excluded[place] |= cards;
+  return 0;
+}
+
+typedef struct sampler_enum {
+  sampler *s;
+  uint8_t room[SAMPLER_PLACES];
+  // cards of the classes from an index on which may go to a place
+  uint8_t avail[SAMPLER_CLASSES + 1][SAMPLER_PLACES];
+  sampler_split curr;
+} sampler_enum;
+
+static int sampler_enum_class(sampler_enum *e, int c, uint64_t deals);
+
+static int
+sampler_push_split(sampler_enum *e, uint64_t deals) {
+  sampler *s = e->s;
+  if (s->split_count == s->split_capacity) {
+	size_t capacity = s->split_capacity ? 2 * s->split_capacity : 64;
+	sampler_split *splits = realloc(s->splits, capacity * sizeof(*splits));
+	if (!splits)
+	  return 1;
+	s->splits = splits;
+	s->split_capacity = capacity;
+  }
+  s->deals += deals;
+  e->curr.deals_end = s->deals;
+  s->splits[s->split_count++] = e->curr;
+  return 0;
+}
+
+// Splits left cards of class c over its places from place p on
+static int
+sampler_enum_place(sampler_enum *e, int c, int p, int left, uint64_t deals) {
+  const uint8_t places = e->s->class_places[c];
+  int last = 31 - __builtin_clz(places);
+
+  while (p < last && !((places >> p) & 0b1u))
+	p++;
+  if (p == last) {
+	if (left > e->room[p])
+	  return 0;
+	e->curr.counts[c][p] = left;
+	e->room[p] -= left;
+	int err = sampler_enum_class(e, c + 1, deals);
+	e->room[p] += left;
+	return err;
+  }
+
+  for (int k = 0; k <= left && k <= e->room[p]; k++) {
+	e->curr.counts[c][p] = k;
+	e->room[p] -= k;
+	int err = sampler_enum_place(e, c, p + 1, left - k,
+								 deals * deal_binomial(left, k));
+	e->room[p] += k;
+	if (err)
+	  return err;
+  }
+  e->curr.counts[c][p] = 0;
+  return 0;
+}
+
+static int
+sampler_enum_class(sampler_enum *e, int c, uint64_t deals) {
+  for (int p = 0; p < SAMPLER_PLACES; p++)
+	if (e->room[p] > e->avail[c][p])
+	  return 0;
+  if (c == e->s->class_count)
+	return sampler_push_split(e, deals);
+  return sampler_enum_place(e, c, 0, e->s->class_size[c], deals);
+}
+
+int
+sampler_prepare(sampler *s) {
+  card_collection seen = s->played, candidates[SAMPLER_PLACES];
+  int8_t class_index[SAMPLER_CLASSES];
+  sampler_enum e;
+  int hidden = 0, room = 0;
+
+  memset(&e, '\0', sizeof(e));
+  e.s = s;
+  for (int p = 0; p < SAMPLER_PLACES; p++)
+	seen |= s->known[p];
+  for (int p = 0; p < SAMPLER_PLACES; p++) {
+	int known = __builtin_popcount(s->known[p]);
+	if (known > s->size[p])
+	  return 1;
+	e.room[p] = s->size[p] - known;
+	room += e.room[p];
+	candidates[p] = e.room[p] ? ~(seen | s->excluded[p]) : 0;
+  }
+
+  memset(class_index, -1, sizeof(class_index));
+  s->class_count = 0;
+  for (card_collection m = ~seen; m; m &= m - 1, hidden++) {
+	uint8_t i = __builtin_ctz(m), places = 0;
+	for (int p = 0; p < SAMPLER_PLACES; p++)
+	  places |= ((candidates[p] >> i) & 0b1u) << p;
+	if (!places) {
+	  DERROR_PRINTF("Card %u cannot be in any place", i);
+	  return 1;
+	}
+	if (class_index[places] < 0) {
+	  class_index[places] = s->class_count;
+	  s->class_places[s->class_count] = places;
+	  s->class_size[s->class_count++] = 0;
+	}
+	int c = class_index[places];
+	s->class_cards[c][s->class_size[c]++] = i;
+  }
+  if (hidden != room)
+	return 1;
+
+  for (int c = s->class_count - 1; c >= 0; c--)
+	for (int p = 0; p < SAMPLER_PLACES; p++)
+	  e.avail[c][p] = e.avail[c + 1][p]
+					  + ((s->class_places[c] >> p) & 0b1u) * s->class_size[c];
+
+  s->split_count = 0;
+  s->deals = 0;
+  if (sampler_enum_class(&e, 0, 1))
+	return 2;
+  return !s->deals;
+}
+
+int
+sampler_draw(const sampler *s, rng *r, deal *d) {
+  card_collection places[SAMPLER_PLACES];
+  uint8_t cards[32];
+  size_t lo = 0, hi = s->split_count - 1;
+
+  if (!s->deals)
+	return 1;
+
+  uint64_t x = rng_bounded_u64(r, s->deals);
+  while (lo < hi) {
+	size_t mid = (lo + hi) / 2;
+	if (s->splits[mid].deals_end > x)
+	  hi = mid;
+	else
+	  lo = mid + 1;
+  }
+  const sampler_split *split = &s->splits[lo];
+
+  memcpy(places, s->known, sizeof(places));
+  for (int c = 0; c < s->class_count; c++) {
+	uint8_t n = s->class_size[c], t = 0;
+	memcpy(cards, s->class_cards[c], n);
+	for (int p = 0; p < SAMPLER_PLACES; p++) {
+	  for (uint8_t k = split->counts[c][p]; k; k--, t++) {
+		uint8_t j = t + rng_bounded_u32(r, n - t);
+		uint8_t tmp = cards[j];
+		cards[j] = cards[t];
+		cards[t] = tmp;
+		places[p] |= 0b1u << tmp;
+	  }
+	}
+  }
+
+  d->hands[0] = places[0];
+  d->hands[1] = places[1];
+  d->hands[2] = places[2];
+  d->skat = places[SAMPLER_SKAT];
+  return 0;
+}
@@ -7,6 +7,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #define FOR_EACH_ACTIVE(s, var, block) \
@@ -24,6 +25,8 @@ server_close_all_connections(server *s) {
   DEBUG_PRINTF(
 		  "Closing open connection sockets to clients and listener socket");
   FOR_EACH_ACTIVE(s, i, {
+	if (!s->conns[i].c.active)
+	  continue;
 	DEBUG_PRINTF("Closing connection socket with id %d", i);
 	if (close(s->conns[i].c.fd) == -1)
 	  DERROR_PRINTF("Error while closing connection socket to client %d: %s", i,
@@ -46,19 +49,21 @@ server_is_player_active(server *s, int gupid) {
   return (s->playermask >> gupid) & 1;
 }
 
+// Seated players keep their seat after a disconnect, otherwise we can't
+// recover connections
 int
 server_has_player_name(server *s, char *pname) {
-  for (int i = 0; i < 4; i++)// otherwise we can't recover connections
-	if (s->pls[i] != NULL
-		&& !strncmp(s->pls[i]->name, pname, s->pls[i]->name_length))
-	  return 1;
-  return 0;
+  player_directory_entry *e =
+		  player_directory_find(&s->dir, pname, strlen(pname));
+  return e && e->gupid >= 0;
 }
 
 void
 server_send_event(server *s, event *e, player *pl) {
   connection_s2c *c = server_get_connection_by_gupid(s, pl->gupid);
-  if (c) {
+  if (server_bots_is_seat(s, pl->gupid)) {
+	server_bots_send_event(s, pl->gupid, e);
+  } else if (c) {
 	conn_enqueue_event(&c->c, e);
   }
 }
@@ -89,37 +94,79 @@ server_get_free_connection(server *s, int *n) {
   return &s->conns[i];
 }
 
-void
-server_add_player_for_connection(server *s, player *pl, int gupid) {
-  if (s->pls[gupid])
-	free(s->pls[gupid]);
-  s->pls[gupid] = pl;
-  pl->gupid = gupid;
+static player_directory_entry *
+server_seat_entry(server *s, int gupid) {
+  return player_directory_get(&s->dir, s->pls[gupid]->id);
+}
+
+int
+server_add_player_for_connection(server *s, const char *name, int gupid) {
+  player_directory_entry *e, *old = NULL;
+
+  // Whoever sat here before left and can no longer resume, so their entry
+  // may make room
+  if (s->pls[gupid] && (old = server_seat_entry(s, gupid)))
+	old->gupid = -1;
+  if (player_directory_intern(&s->dir, name, strlen(name), &e)) {
+	DERROR_PRINTF("No room for '%s' in the player directory", name);
+	// Nothing was evicted
+	if (old)
+	  old->gupid = gupid;
+	return 1;
+  }
+
+  e->gupid = gupid;
+  e->sessions++;
+  e->last_seen = time(NULL);
+  memcpy(s->seat_names[gupid], e->name, e->name_length);
+  s->seat_names[gupid][e->name_length] = '\0';
+  s->seats[gupid] = (player){.gupid = gupid,
+							 .ap = -1,
+							 .id = e->id,
+							 .name_length = e->name_length,
+							 .name = s->seat_names[gupid]};
+  s->pls[gupid] = &s->seats[gupid];
   s->ncons++;
   s->playermask |= 1 << gupid;
+  return 0;
 }
 
 void
 server_resume_player_for_connection(server *s, int gupid) {
+  player_directory_entry *e = server_seat_entry(s, gupid);
+
+  if (e) {
+	e->sessions++;
+	e->last_seen = time(NULL);
+  }
   s->ncons++;
   s->playermask |= 1 << gupid;
 }
 
 connection_s2c *
 server_get_connection_by_pname(server *s, char *pname, int *n) {
-  for (int i = 0; i < 4; i++) {
-	if (!s->pls[i])
-	  continue;
-	DEBUG_PRINTF("Comparing \"%s\" to \"%s\"", s->pls[i]->name, pname);
-	if (!strncmp(s->pls[i]->name, pname, s->pls[i]->name_length)) {
-	  if (n)
-		*n = i;
-	  DEBUG_PRINTF("Found 'em");
-	  return &s->conns[i];
-	}
-  };
-  DEBUG_PRINTF("Didn't find 'em");
-  return NULL;
+  player_directory_entry *e =
+		  player_directory_find(&s->dir, pname, strlen(pname));
+
+  if (!e || e->gupid < 0) {
+	DEBUG_PRINTF("No seat for \"%s\"", pname);
+	return NULL;
+  }
+  if (n)
+	*n = e->gupid;
+  return &s->conns[e->gupid];
+}
+
+int
+server_open_player_directory(server *s, const char *path) {
+  player_directory d;
+
+  if (s->playermask
+	  || player_directory_open(&d, path, SERVER_PLAYER_DIRECTORY_CAPACITY))
+	return 1;
+  player_directory_close(&s->dir);
+  s->dir = d;
+  return 0;
 }
 
 connection_s2c *
@@ -129,10 +176,13 @@ server_get_connection_by_gupid(server *s, int gupid) {
 
 void
 server_disconnect_connection(server *s, connection_s2c *c) {
+  player_directory_entry *e;
   player *pl;
   pl = s->pls[c->gupid];
 
   DEBUG_PRINTF("Lost connection to client %s (%d)", pl->name, c->gupid);
+  if ((e = server_seat_entry(s, c->gupid)))
+	e->last_seen = time(NULL);
 
   skat_state_notify_disconnect(&s->ss, pl, s);
   FOR_EACH_ACTIVE(s, i, {
@@ -218,11 +268,122 @@ server_resync_player(server *s, player *pl, payload_resync **pl_rs) {
   return payload_size;
 }
 
+// Must be called with the state lock held
+static void
+server_snapshot_begin(server *s) {
+  __atomic_store_n(&s->snap.generation, s->snap.generation + 1,
+				   __ATOMIC_RELAXED);
+}
+
+// Must be called with the state lock held and ends a server_snapshot_begin,
+// so the generation is even whenever no tick runs
+static void
+server_snapshot_publish(server *s) {
+  card_collection hand;
+
+  // release stores keep the odd generation ordered before the fields
+  __atomic_store_n(&s->snap.phase, s->ss.sgs.cgphase, __ATOMIC_RELEASE);
+  __atomic_store_n(&s->snap.reizwert, s->ss.sgs.rs.reizwert, __ATOMIC_RELEASE);
+  for (int i = 0; i < 4; i++) {
+	if (s->pls[i] && s->pls[i]->ap >= 0)
+	  hand = s->ss.player_hands[s->pls[i]->ap];
+	else
+	  card_collection_empty(&hand);
+	__atomic_store_n(&s->snap.hands[i], hand, __ATOMIC_RELEASE);
+  }
+
+  __atomic_store_n(&s->snap.generation, s->snap.generation + 1,
+				   __ATOMIC_RELEASE);
+}
+
+// Cheap check on the connection thread, before the action is queued.
+// Returns 1 if the action can never be applied. Actions are only rejected
+// against a consistent snapshot, which lags behind the real state only while
+// no events of the newer state have reached the clients yet.
+int
+server_prefilter_action(server *s, int gupid, const action *a) {
+  uint32_t gen;
+  game_phase phase;
+  uint16_t reizwert;
+  card_collection hand;
+  int contained;
+
+  if (a->type <= ACTION_INVALID || a->type >= ACTION_TYPE_COUNT)
+	return 1;
+
+  gen = __atomic_load_n(&s->snap.generation, __ATOMIC_ACQUIRE);
+  if (gen & 1)
+	return 0;
+
+  // acquire loads keep the fields ordered before the generation re-check
+  phase = __atomic_load_n(&s->snap.phase, __ATOMIC_ACQUIRE);
+  reizwert = __atomic_load_n(&s->snap.reizwert, __ATOMIC_ACQUIRE);
+  hand = __atomic_load_n(&s->snap.hands[gupid], __ATOMIC_ACQUIRE);
+
+  if (__atomic_load_n(&s->snap.generation, __ATOMIC_ACQUIRE) != gen)
+	return 0;// torn read, leave it to server_tick
+
+  if (!skat_transition_exists(phase, a->type))
+	return 1;
+
+  switch (a->type) {
+	case ACTION_REIZEN_NUMBER:
+	  return a->reizwert < REIZWERT_MIN || a->reizwert > REIZWERT_MAX
+			 || a->reizwert <= reizwert;
+	case ACTION_PLAY_CARD:
+	  return card_collection_contains(&hand, &a->card, &contained)
+			 || !contained;
+	case ACTION_SKAT_PRESS:
+	  for (int i = 0; i < 2; i++)
+		if (card_collection_contains(&hand, &a->skat_press_cards[i],
+									 &contained)
+			|| !contained)
+		  return 1;
+	  return 0;
+	default:
+	  return 0;
+  }
+}
+
+// Copies the players under the state lock and writes them without it, so
+// rounds go on while the file is written
+static void
+server_flush_ratings(server *s) {
+  rating_player *players = NULL;
+  const char *path;
+  uint32_t count = 0;
+
+  pthread_mutex_lock(&s->ratings_lock);
+  server_acquire_state_lock(s);
+  path = s->ss.ratings_path;
+  if (s->ss.ratings_dirty && path) {
+	count = s->ss.ratings->count;
+	if ((players = malloc(count * sizeof(*players)))) {
+	  memcpy(players, s->ss.ratings->players, count * sizeof(*players));
+	  s->ss.ratings_dirty = 0;
+	} else
+	  DERROR_PRINTF("Could not copy the ratings");
+  }
+  server_release_state_lock(s);
+
+  if (players && rating_write_players(players, count, path)) {
+	DERROR_PRINTF("Could not write the ratings to '%s'", path);
+	server_acquire_state_lock(s);
+	s->ss.ratings_dirty = 1;
+	server_release_state_lock(s);
+  }
+  free(players);
+  pthread_mutex_unlock(&s->ratings_lock);
+}
+
 void
 server_tick(server *s) {
+  int flush;
+
   DPRINTF_COND(DEBUG_TICK, "Server tick");
 
   server_acquire_state_lock(s);
+  server_snapshot_begin(s);
 
   if (!s->exit) {
 	action a;
@@ -244,9 +405,19 @@ server_tick(server *s) {
 	  }
 	  skat_server_state_tick(&s->ss, s);
 	});
+	server_bots_tick(s);
   }
 
+  // The bot thread ticks too, so count time instead of ticks
+  flush = deadline_millis_left(&s->ratings_due) <= 0;
+  if (flush)
+	deadline_after_millis(&s->ratings_due,
+						  SERVER_RATINGS_FLUSH_SECONDS * 1000);
+  server_snapshot_publish(s);
   server_release_state_lock(s);
+
+  if (flush)
+	server_flush_ratings(s);
 }
 
 void
@@ -398,6 +569,7 @@ server_signal_handler(void *args) {
   DEBUG_PRINTF("Received signal %s (%d)", strsignal(sig), sig);
 
   server_prepare_exit(s);
+  server_flush_ratings(s);
 
   DEBUG_PRINTF("Exiting...");
   exit(128 + sig);
@@ -427,12 +599,42 @@ server_init(server *s, int port) {
   DEBUG_PRINTF("Initializing server on port '%d'", port);
   memset(s, '\0', sizeof(server));
   pthread_mutex_init(&s->lock, NULL);
+  pthread_mutex_init(&s->ratings_lock, NULL);
   s->port = port;
+  deadline_after_millis(&s->ratings_due, SERVER_RATINGS_FLUSH_SECONDS * 1000);
   thread_set_name_self("sv_main");
+  if (player_directory_open(&s->dir, NULL, SERVER_PLAYER_DIRECTORY_CAPACITY))
+	exit(EXIT_FAILURE);
   server_skat_state_init(&s->ss);
+  server_snapshot_begin(s);
+  server_snapshot_publish(s);
   server_start_interrupt_handler_thread(s);
 }
 
+void
+server_init_headless(server *s) {
+  memset(s, '\0', sizeof(server));
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_mutex_init(&s->ratings_lock, NULL);
+  s->port = -1;
+  deadline_after_millis(&s->ratings_due, SERVER_RATINGS_FLUSH_SECONDS * 1000);
+  if (player_directory_open(&s->dir, NULL, SERVER_PLAYER_DIRECTORY_CAPACITY))
+	exit(EXIT_FAILURE);
+  server_skat_state_init(&s->ss);
+  server_snapshot_begin(s);
+  server_snapshot_publish(s);
+}
+
+void
+server_free_headless(server *s) {
+  for (int i = 0; i < 4; i++)
+	s->pls[i] = NULL;
+  player_directory_close(&s->dir);
+  server_skat_state_free(&s->ss);
+  pthread_mutex_destroy(&s->lock);
+  pthread_mutex_destroy(&s->ratings_lock);
+}
+
 static void
 server_tick_wrap(void *s) {
   server_tick(s);
@@ -0,0 +1,200 @@
+#include "skat/server_bots.h"
+#include "conf.h"
+#include "skat/server.h"
+#include "skat/util.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  server *s;
+  int gupid;
+  skat_client_state cs;
+} server_bots_job;
+
+_Noreturn static void *
+server_bots_decider(void *args) {
+  server_bots *sb = args;
+
+  async_callback acb;
+  for (;;) {
+	dequeue_async_callback_blocking(&sb->acq, &acb);
+	acb.do_stuff(acb.data);
+  }
+}
+
+int
+server_bots_init(server *s, const bot_config *conf) {
+  server_bots *sb = &s->bots;
+
+  if (sb->started)
+	return 1;
+  if (conf->threads < 1 || conf->threads > THREAD_POOL_MAX_THREADS
+	  || !conf->move_millis)
+	return 2;
+  sb->conf = *conf;
+  init_async_callback_queue(&sb->acq);
+  pthread_create(&sb->decider, NULL, server_bots_decider, sb);
+  thread_set_name(sb->decider, "sv_bots");
+  sb->started = 1;
+  return 0;
+}
+
+// The bot of a seat is kept once started, for the next bot on that seat
+static int
+server_bots_init_seat(server_bots *const sb, const int gupid) {
+  bot_config conf = sb->conf;
+
+  if (!sb->started || (sb->botmask >> gupid) & 1)
+	return 0;
+  // Seeded bots must not all draw the same deals
+  if (conf.seed)
+	conf.seed += gupid;
+  if (bot_init(&sb->bots[gupid], &conf))
+	return 1;
+  sb->botmask |= 1 << gupid;
+  return 0;
+}
+
+int
+server_bots_add(server *s, const char *name) {
+  server_bots *sb = &s->bots;
+  int gupid;
+
+  server_acquire_state_lock(s);
+  if (server_has_player_name(s, (char *) name)
+	  || !server_get_free_connection(s, &gupid) || gupid > 3
+	  || server_bots_init_seat(sb, gupid)
+	  || server_add_player_for_connection(s, name, gupid)) {
+	server_release_state_lock(s);
+	return 2;
+  }
+
+  memset(&sb->seats[gupid], '\0', sizeof(sb->seats[gupid]));
+  client_skat_state_init(&sb->seats[gupid].cs);
+  sb->seats[gupid].cs.my_gupid = gupid;
+  sb->seatmask |= 1 << gupid;
+
+  server_notify_join(s, gupid);
+  server_release_state_lock(s);
+  return 0;
+}
+
+int
+server_bots_is_seat(const server *s, int gupid) {
+  return (s->bots.seatmask >> gupid) & 1;
+}
+
+void
+server_bots_send_event(server *s, int gupid, event *e) {
+  server_bot_seat *seat = &s->bots.seats[gupid];
+
+  if (!skat_client_state_apply(&seat->cs, e, NULL))
+	DERROR_PRINTF("Bot seat %d could not apply event %s", gupid,
+				  event_name_table[e->type]);
+}
+
+// Runs on the decider thread, the state lock is only taken to hand over
+// the action. The tick right after applies it, so a table of bots does not
+// move at the pace of the timer.
+static void
+server_bots_decide(void *v) {
+  server_bots_job *job = v;
+  server *s = job->s;
+  server_bot_seat *seat = &s->bots.seats[job->gupid];
+  action a;
+  int error;
+
+  memset(&a, '\0', sizeof(a));
+  error = bot_decide(&s->bots.bots[job->gupid], &job->cs, &a);
+
+  server_acquire_state_lock(s);
+  if (error) {
+	seat->busy = 0;
+  } else {
+	a.id = -1;
+	seat->pending = a;
+	seat->has_action = 1;
+  }
+  server_release_state_lock(s);
+  free(job);
+  if (!error)
+	server_tick(s);
+}
+
+void
+server_bots_tick(server *s) {
+  server_bots *sb = &s->bots;
+  server_bots_job *job;
+  int act;
+
+  if (!sb->started)
+	return;
+
+  for (int i = 0; i < 4; i++) {
+	server_bot_seat *seat = &sb->seats[i];
+	if (!server_bots_is_seat(s, i))
+	  continue;
+
+	if (seat->has_action) {
+	  seat->has_action = 0;
+	  seat->busy = 0;
+	  if (!skat_server_state_apply(&s->ss, &seat->pending, s->pls[i], s)) {
+		DEBUG_PRINTF("Illegal action of type %s from bot seat %d, retrying "
+					 "later",
+					 action_name_table[seat->pending.type], i);
+		seat->wait_ticks = SERVER_REFRESH_RATE;
+	  }
+	}
+
+	if (seat->busy)
+	  continue;
+	if (seat->wait_ticks > 0) {
+	  seat->wait_ticks--;
+	  continue;
+	}
+	if (bot_wants_to_act(&seat->cs, &act) || !act)
+	  continue;
+	// Humans say when to go on, otherwise one ready is enough once the
+	// table is full
+	if ((seat->cs.sgs.cgphase == GAME_PHASE_SETUP
+		 || seat->cs.sgs.cgphase == GAME_PHASE_BETWEEN_ROUNDS)
+		&& (s->playermask & ~sb->seatmask || i != __builtin_ctz(sb->seatmask)
+			|| s->ncons < 3))
+	  continue;
+
+	if (!(job = malloc(sizeof(*job)))) {
+	  DERROR_PRINTF("Could not hand bot seat %d to the decider", i);
+	  seat->wait_ticks = SERVER_REFRESH_RATE;
+	  continue;
+	}
+	*job = (server_bots_job){.s = s, .gupid = i, .cs = seat->cs};
+	seat->busy = 1;
+	exec_async(&sb->acq,
+			   &(async_callback){.do_stuff = server_bots_decide, .data = job});
+  }
+}
+
+int
+server_bots_step(server *s, bot *const bots[4]) {
+  server_bots *sb = &s->bots;
+  action a;
+  int act;
+
+  for (int i = 0; i < 4; i++) {
+	server_bot_seat *seat = &sb->seats[i];
+	if (!server_bots_is_seat(s, i) || bot_wants_to_act(&seat->cs, &act)
+		|| !act)
+	  continue;
+	memset(&a, '\0', sizeof(a));
+	if (bot_decide(bots[i], &seat->cs, &a))
+	  return 2;
+	a.id = -1;
+	if (!skat_server_state_apply(&s->ss, &a, s->pls[i], s)) {
+	  DERROR_PRINTF("Illegal action of type %s from bot seat %d",
+					action_name_table[a.type], i);
+	  return 2;
+	}
+	return 0;
+  }
+  return 1;
+}
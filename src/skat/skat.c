@@ -1,11 +1,15 @@
 #include "skat/skat.h"
+#include "conf.h"
 #include "skat/card_collection.h"
+#include "skat/claim.h"
 #include "skat/client.h"
 #include "skat/game_rules.h"
 #include "skat/server.h"
+#include "skat/solver.h"
 #include "skat/util.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #undef SKAT_HDR
@@ -129,75 +133,23 @@ get_player_hand(skat_server_state *ss, player *pl, card_collection *col) {
   card_collection_empty(col);
 }
 
-#define RANDOM_CARD_DISTRIBUTE(draw_pile, player_hand) \
-  do { \
-	card_id cid_; \
-	int error_; \
-\
-	error_ = card_collection_draw_random(draw_pile, &cid_); \
-	if (error_) { \
-	  DERROR_PRINTF("Error %d while drawing random card from draw pile %#x", \
-					error_, *(draw_pile)); \
-	} \
-\
-	error_ = card_collection_add_card(player_hand, &cid_); \
-	if (error_) { \
-	  DERROR_PRINTF("Error %d while adding card %u to collection %#x", error_, \
-					cid_, *(draw_pile)); \
-	} \
-\
-	error_ = card_collection_remove_card(draw_pile, &cid_); \
-	if (error_) { \
-	  DERROR_PRINTF("Error %d while removing card %u from collection %#x", \
-					error_, cid_, *(draw_pile)); \
-	} \
-\
-  } while (0)
-
 // Conforming to the rules. Poggers.
 static int
 distribute_cards(skat_server_state *ss) {
-  card_collection draw_pile;
-  card_collection_fill(&draw_pile);
-
-  for (int i = 0; i < 3; i++) {
-	for (int j = 0; j < 3; j++) {
-	  RANDOM_CARD_DISTRIBUTE(&draw_pile, &ss->player_hands[i]);
-	}
-  }
-
-  for (int i = 0; i < 2; i++) {
-	card_id cid_;
-	int error_;
+  deal d;
+  if (ss->fixed_deals_next < ss->fixed_deals_length)
+	d = ss->fixed_deals[ss->fixed_deals_next++];
+  else if (deal_random(&d, &ss->deal_rng))
+	return 1;
 
-	error_ = card_collection_draw_random(&draw_pile, &cid_);
-	if (error_) {
-	  DERROR_PRINTF("Error %d while drawing random card from draw pile %#x",
-					error_, draw_pile);
-	}
+  char deal_text[DEAL_TEXT_LENGTH + 1];
+  if (!deal_to_text(&d, deal_text))
+	DEBUG_PRINTF("Dealing %s", deal_text);
 
-	ss->skat[i] = cid_;
+  for (int i = 0; i < 3; i++)
+	ss->player_hands[i] = d.hands[i];
 
-	error_ = card_collection_remove_card(&draw_pile, &cid_);
-	if (error_) {
-	  DERROR_PRINTF("Error %d while removing card %u from draw pile %#x",
-					error_, cid_, draw_pile);
-	}
-  }
-
-  for (int i = 0; i < 3; i++) {
-	for (int j = 0; j < 4; j++) {
-	  RANDOM_CARD_DISTRIBUTE(&draw_pile, &ss->player_hands[i]);
-	}
-  }
-
-  for (int i = 0; i < 3; i++) {
-	for (int j = 0; j < 3; j++) {
-	  RANDOM_CARD_DISTRIBUTE(&draw_pile, &ss->player_hands[i]);
-	}
-  }
-
-  return 0;
+  return deal_get_skat(&d, ss->skat);
 }
 
 #if defined(DISTRIBUTE_SORTED_CARDS) && DISTRIBUTE_SORTED_CARDS
@@ -248,137 +200,173 @@ debug_distribute_cards(skat_server_state *ss) {
 }
 #endif
 
+typedef bool (*transition_guard)(skat_server_state *ss, action *a, player *pl,
+								 server *s);
+typedef game_phase (*transition_handler)(skat_server_state *ss, action *a,
+										 player *pl, server *s);
+
+typedef struct {
+  transition_guard guard;
+  transition_handler handler;
+} game_transition;
+
+static int
+next_active_player(int player, int off) {
+  return (player + off) % 3;
+}
+
+static bool
+guard_enough_players(skat_server_state *ss, action *a, player *pl, server *s) {
+  if (s->ncons < 3) {
+	DEBUG_PRINTF("Rejecting action %s with id %ld by player %s "
+				 "because s->ncons = %d < 3",
+				 action_name_table[a->type], a->id, pl->name, s->ncons);
+	return false;
+  }
+
+  return true;
+}
+
+static bool
+guard_reizen_running(skat_server_state *ss, action *a, player *pl, server *s) {
+  if (ss->sgs.rs.rphase == REIZ_PHASE_INVALID
+	  || ss->sgs.rs.rphase == REIZ_PHASE_DONE) {
+	DEBUG_PRINTF("Invalid reiz phase %s",
+				 reiz_phase_name_table[ss->sgs.rs.rphase]);
+	return false;
+  }
+
+  return true;
+}
+
+static bool
+guard_alleinspieler(skat_server_state *ss, action *a, player *pl, server *s) {
+  if (ss->sgs.alleinspieler == -1 || ss->sgs.alleinspieler != pl->ap) {
+	DEBUG_PRINTF("Invalid %s actor", game_phase_name_table[ss->sgs.cgphase]);
+	return false;
+  }
+
+  return true;
+}
+
+static bool
+guard_players_turn(skat_server_state *ss, action *a, player *pl, server *s) {
+  int ind = ss->sgs.cgphase - GAME_PHASE_PLAY_STICH_C1;
+  int curr = next_active_player(ss->sgs.curr_stich.vorhand, ind);
+  int expected_player_gupid = ss->sgs.active_players[curr];
+  player *expected_player = s->pls[expected_player_gupid];
+  if (pl->gupid != expected_player_gupid) {
+	DEBUG_PRINTF("Wrong player trying to play card: Expected player %s "
+				 "(gupid: %d), but got %s (gupid %d) instead",
+				 expected_player->name, expected_player_gupid, pl->name,
+				 pl->gupid);
+	return false;
+  }
+
+  return true;
+}
+
 static game_phase
-apply_action_setup(skat_server_state *ss, action *a, player *pl, server *s) {
+apply_setup_ready(skat_server_state *ss, action *a, player *pl, server *s) {
   event e;
   e.answer_to = a->id;
   e.acting_player = pl->gupid;
-  switch (a->type) {
-	case ACTION_READY:
-	  if (s->ncons < 3) {
-		DEBUG_PRINTF("Rejecting action ACTION_READY with id %ld by player %s "
-					 "because s->ncons = %d < 3",
-					 a->id, pl->name, s->ncons);
-		return GAME_PHASE_INVALID;
-	  }
+  e.type = EVENT_START_GAME;
+  server_distribute_event(s, &e, NULL);
 
-	  e.type = EVENT_START_GAME;
-	  server_distribute_event(s, &e, NULL);
-
-	  return GAME_PHASE_BETWEEN_ROUNDS;
-	default:
-
-	  DEBUG_PRINTF("Trying to use undefined action %s in state %s",
-				   action_name_table[a->type],
-				   game_phase_name_table[ss->sgs.cgphase]);
-	  return GAME_PHASE_INVALID;
-  }
+  return GAME_PHASE_BETWEEN_ROUNDS;
 }
 
 static game_phase
-apply_action_between_rounds(skat_server_state *ss, action *a, player *pl,
-							server *s) {
+apply_between_rounds_ready(skat_server_state *ss, action *a, player *pl,
+						   server *s) {
   int pm, ix;
   event e;
   e.answer_to = a->id;
   e.acting_player = pl->gupid;
-  switch (a->type) {
-	case ACTION_READY:
-	  if (s->ncons < 3) {
-		DEBUG_PRINTF("Rejecting action ACTION_READY with id %ld by player %s "
-					 "because s->ncons = %d < 3",
-					 a->id, pl->name, s->ncons);
-
-		return GAME_PHASE_INVALID;
-	  }
+  e.type = EVENT_START_ROUND;
+
+  if (ss->sgs.active_players[0] == -1) {
+	for (int i = 0, j = 0; i < 4; i++)
+	  if (server_is_player_active(s, i))
+		ss->sgs.active_players[j++] = s->pls[i]->gupid;
+  } else if (s->ncons == 3) {// we don't have a spectator
+	perm(ss->sgs.active_players, 3, 0x12);
+  } else {
+	pm = 0;
+	for (int i = 0; i < 3; i++)
+	  pm |= 1 << ss->sgs.active_players[i];
+	ix = __builtin_ctz(~pm);
+	perm(ss->sgs.active_players, 3, 0x12);
+	ss->sgs.active_players[2] = s->pls[ix]->gupid;
+  }
 
-	  e.answer_to = a->id;
-	  e.acting_player = pl->gupid;
-	  e.type = EVENT_START_ROUND;
+  for (int gupid = 0; gupid < 4; gupid++) {
+	if (s->pls[gupid])
+	  s->pls[gupid]->ap = -1;
+  }
 
-	  if (ss->sgs.active_players[0] == -1) {
-		for (int i = 0, j = 0; i < 4; i++)
-		  if (server_is_player_active(s, i))
-			ss->sgs.active_players[j++] = s->pls[i]->gupid;
-	  } else if (s->ncons == 3) {// we don't have a spectator
-		perm(ss->sgs.active_players, 3, 0x12);
-	  } else {
-		pm = 0;
-		for (int i = 0; i < 3; i++)
-		  pm |= 1 << ss->sgs.active_players[i];
-		ix = __builtin_ctz(~pm);
-		perm(ss->sgs.active_players, 3, 0x12);
-		ss->sgs.active_players[2] = s->pls[ix]->gupid;
-	  }
+  for (int ap = 0; ap < 3; ap++) {
+	s->pls[ss->sgs.active_players[ap]]->ap = ap;
+  }
 
-	  for (int gupid = 0; gupid < 4; gupid++) {
-		if (s->pls[gupid])
-		  s->pls[gupid]->ap = -1;
-	  }
+  memcpy(e.current_active_players, ss->sgs.active_players,
+		 sizeof(e.current_active_players));
 
-	  for (int ap = 0; ap < 3; ap++) {
-		s->pls[ss->sgs.active_players[ap]]->ap = ap;
-	  }
+  server_distribute_event(s, &e, NULL);
 
-	  memcpy(e.current_active_players, ss->sgs.active_players,
-			 sizeof(e.current_active_players));
+  ss->sgs.curr_stich = (stich){.played_cards = 0, .vorhand = 0, .winner = -1};
+  ss->sgs.last_stich = (stich){.played_cards = 0, .vorhand = -1, .winner = -1};
+  ss->sgs.stich_num = 0;
+  ss->sgs.alleinspieler = -1;
+  memset(&ss->sgs.gr, '\0', sizeof(ss->sgs.gr));
+  ss->sgs.rs.rphase = REIZ_PHASE_INVALID;
+  ss->sgs.rs.waiting_teller = -1;
+  ss->sgs.rs.reizwert = 0;
+  ss->sgs.rs.winner = -1;
+  memset(ss->stiche, '\0', 3 * sizeof(ss->stiche[0]));
+  card_collection_empty(&ss->stiche_buf[0]);
+  card_collection_empty(&ss->stiche_buf[1]);
+  card_collection_empty(&ss->stiche_buf[2]);
 
-	  server_distribute_event(s, &e, NULL);
+  card_collection_empty(&ss->player_hands[0]);
+  card_collection_empty(&ss->player_hands[1]);
+  card_collection_empty(&ss->player_hands[2]);
 
-	  ss->sgs.curr_stich =
-			  (stich){.played_cards = 0, .vorhand = 0, .winner = -1};
-	  ss->sgs.last_stich =
-			  (stich){.played_cards = 0, .vorhand = -1, .winner = -1};
-	  ss->sgs.stich_num = 0;
-	  ss->sgs.alleinspieler = -1;
-	  ss->sgs.rs.rphase = REIZ_PHASE_INVALID;
-	  ss->sgs.rs.waiting_teller = -1;
-	  ss->sgs.rs.reizwert = 0;
-	  ss->sgs.rs.winner = -1;
-	  memset(ss->stiche, '\0', 3 * sizeof(ss->stiche[0]));
-	  card_collection_empty(&ss->stiche_buf[0]);
-	  card_collection_empty(&ss->stiche_buf[1]);
-	  card_collection_empty(&ss->stiche_buf[2]);
-
-	  card_collection_empty(&ss->player_hands[0]);
-	  card_collection_empty(&ss->player_hands[1]);
-	  card_collection_empty(&ss->player_hands[2]);
-
-	  card_collection_empty(&ss->initial_alleinspieler_hand);
+  card_collection_empty(&ss->initial_alleinspieler_hand);
 
 #if defined(DISTRIBUTE_SORTED_CARDS) && (DISTRIBUTE_SORTED_CARDS)
-	  // distributing manually for debugging:
-	  debug_distribute_cards(ss);
+  // distributing manually for debugging:
+  debug_distribute_cards(ss);
 #else
-	  distribute_cards(ss);
+  distribute_cards(ss);
 #endif
 
-	  DEBUG_PRINTF("Player hands: %#x, %#x, %#x", ss->player_hands[0],
-				   ss->player_hands[1], ss->player_hands[2]);
-	  DEBUG_PRINTF("Skat: %u & %u", ss->skat[0], ss->skat[1]);
+  memset(&ss->round, '\0', sizeof(ss->round));
+  memcpy(ss->round.d.hands, ss->player_hands, sizeof(ss->round.d.hands));
+  card_collection_add_card_array(&ss->round.d.skat, ss->skat, 2);
+  ss->round.skat = ss->round.d.skat;
 
-	  e.type = EVENT_DISTRIBUTE_CARDS;
-	  e.answer_to = -1;
-	  e.acting_player = -1;
+  DEBUG_PRINTF("Player hands: %#x, %#x, %#x", ss->player_hands[0],
+			   ss->player_hands[1], ss->player_hands[2]);
+  DEBUG_PRINTF("Skat: %u & %u", ss->skat[0], ss->skat[1]);
 
-	  void mask_hands(event * ev, player * pl) {
-		get_player_hand(ss, pl, &ev->hand);
-	  }
+  e.type = EVENT_DISTRIBUTE_CARDS;
+  e.answer_to = -1;
+  e.acting_player = -1;
 
-	  server_distribute_event(s, &e, mask_hands);
+  void mask_hands(event * ev, player * pl) {
+	get_player_hand(ss, pl, &ev->hand);
+  }
 
-	  ss->sgs.rs.rphase = REIZ_PHASE_MITTELHAND_TO_VORHAND;
-	  ss->sgs.rs.waiting_teller = 1;
-	  ss->sgs.rs.reizwert = 0;
-	  ss->sgs.rs.winner = -1;
+  server_distribute_event(s, &e, mask_hands);
 
-	  return GAME_PHASE_REIZEN;
-	default:
-	  DEBUG_PRINTF("Trying to use undefined action %s in state %s",
-				   action_name_table[a->type],
-				   game_phase_name_table[ss->sgs.cgphase]);
-	  return GAME_PHASE_INVALID;
-  }
+  ss->sgs.rs.rphase = REIZ_PHASE_MITTELHAND_TO_VORHAND;
+  ss->sgs.rs.waiting_teller = 1;
+  ss->sgs.rs.reizwert = 0;
+  ss->sgs.rs.winner = -1;
+
+  return GAME_PHASE_REIZEN;
 }
 
 static const uint8_t skat_stiche_buf_lookup[3][3] = {{0, 1, 1},
@@ -433,434 +421,483 @@ finish_reizen(skat_server_state *ss, server *s, event *e) {
 }
 
 static game_phase
-apply_action_reizen(skat_server_state *ss, action *a, player *pl, server *s) {
-  if (ss->sgs.rs.rphase == REIZ_PHASE_INVALID
-	  || ss->sgs.rs.rphase == REIZ_PHASE_DONE) {
-	DEBUG_PRINTF("Invalid reiz phase %s",
-				 reiz_phase_name_table[ss->sgs.rs.rphase]);
+apply_reizen_number(skat_server_state *ss, action *a, player *pl, server *s) {
+  if (!ss->sgs.rs.waiting_teller) {
+	DEBUG_PRINTF("Not waiting for teller");
 	return GAME_PHASE_INVALID;
   }
 
-  event e;
-  e.answer_to = a->id;
-  e.acting_player = pl->gupid;
-  e.reizwert = 0;
-  switch (a->type) {
-	case ACTION_REIZEN_NUMBER:
-	  if (!ss->sgs.rs.waiting_teller) {
-		DEBUG_PRINTF("Not waiting for teller");
-		return GAME_PHASE_INVALID;
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND && pl->ap != 1) {
+	DEBUG_PRINTF("Wrong player trying reizen number: expected 1 but got %d",
+				 pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND
-		  && pl->ap != 1) {
-		DEBUG_PRINTF("Wrong player trying reizen number: expected 1 but got %d",
-					 pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER && pl->ap != 2) {
+	DEBUG_PRINTF("Wrong player trying reizen number: expected 2 but got %d",
+				 pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER && pl->ap != 2) {
-		DEBUG_PRINTF("Wrong player trying reizen number: expected 2 but got %d",
-					 pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_WINNER && pl->ap != ss->sgs.rs.winner) {
+	DEBUG_PRINTF("Wrong player trying reizen number: expected %d but got %d",
+				 ss->sgs.rs.winner, pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_WINNER
-		  && pl->ap != ss->sgs.rs.winner) {
-		DEBUG_PRINTF(
-				"Wrong player trying reizen number: expected %d but got %d",
-				ss->sgs.rs.winner, pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  if (a->reizwert < 18 || a->reizwert <= ss->sgs.rs.reizwert) {
+	DEBUG_PRINTF("Invalid reizwert %u for current reizwert %u", a->reizwert,
+				 ss->sgs.rs.reizwert);
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (a->reizwert < 18 || a->reizwert <= ss->sgs.rs.reizwert) {
-		DEBUG_PRINTF("Invalid reizwert %u for current reizwert %u", a->reizwert,
-					 ss->sgs.rs.reizwert);
-		return GAME_PHASE_INVALID;
-	  }
+  ss->sgs.rs.reizwert = a->reizwert;
+  ss->sgs.rs.waiting_teller = 0;
 
-	  ss->sgs.rs.reizwert = a->reizwert;
-	  ss->sgs.rs.waiting_teller = 0;
+  event e;
+  e.answer_to = a->id;
+  e.acting_player = pl->gupid;
+  e.type = EVENT_REIZEN_NUMBER;
+  e.reizwert = ss->sgs.rs.reizwert;
 
-	  e.type = EVENT_REIZEN_NUMBER;
-	  e.reizwert = ss->sgs.rs.reizwert;
+  server_distribute_event(s, &e, NULL);
 
-	  server_distribute_event(s, &e, NULL);
+  if (ss->sgs.rs.rphase == REIZ_PHASE_WINNER)
+	return finish_reizen(ss, s, &e);
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_WINNER)
-		return finish_reizen(ss, s, &e);
+  return GAME_PHASE_REIZEN;
+}
 
-	  return GAME_PHASE_REIZEN;
-	case ACTION_REIZEN_CONFIRM:
-	  if ((ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND
-		   || ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER)
-		  && ss->sgs.rs.waiting_teller) {
-		DEBUG_PRINTF("Only the listener may confirm now");
-		return GAME_PHASE_INVALID;
-	  }
+static game_phase
+apply_reizen_confirm(skat_server_state *ss, action *a, player *pl, server *s) {
+  if ((ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND
+	   || ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER)
+	  && ss->sgs.rs.waiting_teller) {
+	DEBUG_PRINTF("Only the listener may confirm now");
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND
-		  && pl->ap != 0) {
-		DEBUG_PRINTF(
-				"Wrong player trying reizen confirm: expected 0 but got %d",
-				pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND && pl->ap != 0) {
+	DEBUG_PRINTF("Wrong player trying reizen confirm: expected 0 but got %d",
+				 pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER
-		  && pl->ap != ss->sgs.rs.winner) {
-		DEBUG_PRINTF(
-				"Wrong player trying reizen confirm: expected %d but got %d",
-				ss->sgs.rs.winner, pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER
+	  && pl->ap != ss->sgs.rs.winner) {
+	DEBUG_PRINTF("Wrong player trying reizen confirm: expected %d but got %d",
+				 ss->sgs.rs.winner, pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  ss->sgs.rs.waiting_teller = 1;
+  ss->sgs.rs.waiting_teller = 1;
 
-	  e.type = EVENT_REIZEN_CONFIRM;
+  event e;
+  e.answer_to = a->id;
+  e.acting_player = pl->gupid;
+  e.reizwert = 0;
+  e.type = EVENT_REIZEN_CONFIRM;
 
-	  server_distribute_event(s, &e, NULL);
+  server_distribute_event(s, &e, NULL);
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_WINNER) {
-		if (ss->sgs.rs.reizwert < 18)
-		  ss->sgs.rs.reizwert = 18;
-		return finish_reizen(ss, s, &e);
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_WINNER) {
+	if (ss->sgs.rs.reizwert < 18)
+	  ss->sgs.rs.reizwert = 18;
+	return finish_reizen(ss, s, &e);
+  }
 
-	  return GAME_PHASE_REIZEN;
-	case ACTION_REIZEN_PASSE:
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND && pl->ap != 1
-		  && ss->sgs.rs.waiting_teller) {
-		DEBUG_PRINTF("Wrong player trying reizen passe: expected 1 but got %d",
-					 pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  return GAME_PHASE_REIZEN;
+}
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND && pl->ap != 0
-		  && !ss->sgs.rs.waiting_teller) {
-		DEBUG_PRINTF("Wrong player trying reizen passe: expected 0 but got %d",
-					 pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+static game_phase
+apply_reizen_passe(skat_server_state *ss, action *a, player *pl, server *s) {
+  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND && pl->ap != 1
+	  && ss->sgs.rs.waiting_teller) {
+	DEBUG_PRINTF("Wrong player trying reizen passe: expected 1 but got %d",
+				 pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER && pl->ap != 2
-		  && ss->sgs.rs.waiting_teller) {
-		DEBUG_PRINTF("Wrong player trying reizen passe: expected 2 but got %d",
-					 pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND && pl->ap != 0
+	  && !ss->sgs.rs.waiting_teller) {
+	DEBUG_PRINTF("Wrong player trying reizen passe: expected 0 but got %d",
+				 pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER
-		  && pl->ap != ss->sgs.rs.winner && !ss->sgs.rs.waiting_teller) {
-		DEBUG_PRINTF("Wrong player trying reizen passe: expected %d but got %d",
-					 ss->sgs.rs.winner, pl->ap);
-		return GAME_PHASE_INVALID;
-	  }
+  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER && pl->ap != 2
+	  && ss->sgs.rs.waiting_teller) {
+	DEBUG_PRINTF("Wrong player trying reizen passe: expected 2 but got %d",
+				 pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  e.type = EVENT_REIZEN_PASSE;
+  if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER
+	  && pl->ap != ss->sgs.rs.winner && !ss->sgs.rs.waiting_teller) {
+	DEBUG_PRINTF("Wrong player trying reizen passe: expected %d but got %d",
+				 ss->sgs.rs.winner, pl->ap);
+	return GAME_PHASE_INVALID;
+  }
 
-	  server_distribute_event(s, &e, NULL);
+  event e;
+  e.answer_to = a->id;
+  e.acting_player = pl->gupid;
+  e.reizwert = 0;
+  e.type = EVENT_REIZEN_PASSE;
 
-	  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND) {
-		ss->sgs.rs.rphase = REIZ_PHASE_HINTERHAND_TO_WINNER;
-		ss->sgs.rs.winner = !ss->sgs.rs.waiting_teller;
-		ss->sgs.rs.waiting_teller = 1;
-		return GAME_PHASE_REIZEN;
-	  } else if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER) {
-		if (!ss->sgs.rs.waiting_teller)
-		  ss->sgs.rs.winner = 2;
-		ss->sgs.rs.waiting_teller = 1;
+  server_distribute_event(s, &e, NULL);
 
-		if (ss->sgs.rs.reizwert >= 18)
-		  return finish_reizen(ss, s, &e);
+  if (ss->sgs.rs.rphase == REIZ_PHASE_MITTELHAND_TO_VORHAND) {
+	ss->sgs.rs.rphase = REIZ_PHASE_HINTERHAND_TO_WINNER;
+	ss->sgs.rs.winner = !ss->sgs.rs.waiting_teller;
+	ss->sgs.rs.waiting_teller = 1;
+	return GAME_PHASE_REIZEN;
+  } else if (ss->sgs.rs.rphase == REIZ_PHASE_HINTERHAND_TO_WINNER) {
+	if (!ss->sgs.rs.waiting_teller)
+	  ss->sgs.rs.winner = 2;
+	ss->sgs.rs.waiting_teller = 1;
 
-		ss->sgs.rs.rphase = REIZ_PHASE_WINNER;
-		return GAME_PHASE_REIZEN;
-	  }
-	  // REIZ_PHASE_WINNER
+	if (ss->sgs.rs.reizwert >= 18)
 	  return finish_reizen(ss, s, &e);
-	default:
-	  DEBUG_PRINTF("Trying to use undefined action %s in state %s",
-				   action_name_table[a->type],
-				   game_phase_name_table[ss->sgs.cgphase]);
-	  return GAME_PHASE_INVALID;
+
+	ss->sgs.rs.rphase = REIZ_PHASE_WINNER;
+	return GAME_PHASE_REIZEN;
   }
+  // REIZ_PHASE_WINNER
+  return finish_reizen(ss, s, &e);
 }
 
 static game_phase
-apply_action_skat_aufnehmen(skat_server_state *ss, action *a, player *pl,
-							server *s) {
-  if (ss->sgs.alleinspieler == -1 || ss->sgs.alleinspieler != pl->ap) {
-	DEBUG_PRINTF("Invalid skat actor");
-	return GAME_PHASE_INVALID;
+apply_skat_take(skat_server_state *ss, action *a, player *pl, server *s) {
+  event e;
+  e.answer_to = a->id;
+  e.acting_player = pl->gupid;
+
+  ss->sgs.took_skat = 1;
+  card_collection_add_card_array(&ss->player_hands[ss->sgs.alleinspieler],
+								 ss->skat, 2);
+
+  e.type = EVENT_SKAT_TAKE;
+  memset(e.skat, '\0', sizeof(e.skat));
+
+  void mask_skat(event * ev, player * pl) {
+	if (ss->sgs.alleinspieler == pl->ap)
+	  memcpy(ev->skat, ss->skat, sizeof(ev->skat));
   }
 
+  server_distribute_event(s, &e, mask_skat);
+
+  return GAME_PHASE_SKAT_AUFNEHMEN;
+}
+
+static game_phase
+apply_skat_leave(skat_server_state *ss, action *a, player *pl, server *s) {
   event e;
   e.answer_to = a->id;
   e.acting_player = pl->gupid;
-  switch (a->type) {
-	case ACTION_SKAT_TAKE:
-	  ss->sgs.took_skat = 1;
-	  card_collection_add_card_array(&ss->player_hands[ss->sgs.alleinspieler],
-									 ss->skat, 2);
-
-	  e.type = EVENT_SKAT_TAKE;
-	  memset(e.skat, '\0', sizeof(e.skat));
-
-	  void mask_skat(event * ev, player * pl) {
-		if (ss->sgs.alleinspieler == pl->ap)
-		  memcpy(ev->skat, ss->skat, sizeof(ev->skat));
-	  }
 
-	  server_distribute_event(s, &e, mask_skat);
+  ss->sgs.took_skat = 0;
+  card_collection_add_card_array(&ss->stiche_buf[ss->sgs.alleinspieler],
+								 ss->skat, 2);
 
-	  return GAME_PHASE_SKAT_AUFNEHMEN;
-	case ACTION_SKAT_LEAVE:
-	  ss->sgs.took_skat = 0;
-	  card_collection_add_card_array(&ss->stiche_buf[ss->sgs.alleinspieler],
-									 ss->skat, 2);
+  e.type = EVENT_SKAT_LEAVE;
 
-	  e.type = EVENT_SKAT_LEAVE;
+  server_distribute_event(s, &e, NULL);
 
-	  server_distribute_event(s, &e, NULL);
+  return GAME_PHASE_SPIELANSAGE;
+}
 
-	  return GAME_PHASE_SPIELANSAGE;
-	case ACTION_SKAT_PRESS:
-	  (void) 0;// label hack to create a local variable
-	  card_collection tmp = ss->player_hands[ss->sgs.alleinspieler];
-	  if (card_collection_remove_card_array(&tmp, a->skat_press_cards, 2)) {
-		DEBUG_PRINTF("Cannot press cards %d & %d", a->skat_press_cards[0],
-					 a->skat_press_cards[1]);
-		return GAME_PHASE_INVALID;
-	  }
+static game_phase
+apply_skat_press(skat_server_state *ss, action *a, player *pl, server *s) {
+  card_collection tmp = ss->player_hands[ss->sgs.alleinspieler];
+  if (card_collection_remove_card_array(&tmp, a->skat_press_cards, 2)) {
+	DEBUG_PRINTF("Cannot press cards %d & %d", a->skat_press_cards[0],
+				 a->skat_press_cards[1]);
+	return GAME_PHASE_INVALID;
+  }
 
-	  card_collection_add_card_array(&ss->stiche_buf[ss->sgs.alleinspieler],
-									 a->skat_press_cards, 2);
+  card_collection_add_card_array(&ss->stiche_buf[ss->sgs.alleinspieler],
+								 a->skat_press_cards, 2);
 
-	  ss->player_hands[ss->sgs.alleinspieler] = tmp;
+  ss->player_hands[ss->sgs.alleinspieler] = tmp;
+  card_collection_empty(&ss->round.skat);
+  card_collection_add_card_array(&ss->round.skat, a->skat_press_cards, 2);
 
-	  e.type = EVENT_SKAT_PRESS;
+  event e;
+  e.answer_to = a->id;
+  e.acting_player = pl->gupid;
+  e.type = EVENT_SKAT_PRESS;
 
-	  memset(e.skat, '\0', sizeof(e.skat_press_cards));
+  memset(e.skat, '\0', sizeof(e.skat_press_cards));
 
-	  void mask_skat_press_cards(event * ev, player * pl) {
-		if (ss->sgs.alleinspieler == pl->ap)
-		  memcpy(ev->skat_press_cards, a->skat_press_cards,
-				 sizeof(ev->skat_press_cards));
-	  }
+  void mask_skat_press_cards(event * ev, player * pl) {
+	if (ss->sgs.alleinspieler == pl->ap)
+	  memcpy(ev->skat_press_cards, a->skat_press_cards,
+			 sizeof(ev->skat_press_cards));
+  }
 
-	  server_distribute_event(s, &e, mask_skat_press_cards);
+  server_distribute_event(s, &e, mask_skat_press_cards);
 
-	  return GAME_PHASE_SPIELANSAGE;
-	default:
-	  DEBUG_PRINTF("Trying to use undefined action %s in state %s",
-				   action_name_table[a->type],
-				   game_phase_name_table[ss->sgs.cgphase]);
-	  return GAME_PHASE_INVALID;
-  }
+  return GAME_PHASE_SPIELANSAGE;
 }
 
 static game_phase
-apply_action_spielansage(skat_server_state *ss, action *a, player *pl,
-						 server *s) {
+apply_call_game(skat_server_state *ss, action *a, player *pl, server *s) {
   event e;
   int tmp;
   card_color col;
 
-  if (ss->sgs.alleinspieler == -1 || ss->sgs.alleinspieler != pl->ap) {
-	DEBUG_PRINTF("Invalid spielansagen actor");
+  if (ss->sgs.took_skat && a->gr.hand) {
+	DEBUG_PRINTF("WOW, stupid idiot, you can't play hand if you already "
+				 "took the skat. Bonk.");
 	return GAME_PHASE_INVALID;
   }
 
-  e.answer_to = a->id;
-  e.acting_player = pl->gupid;
+  if (a->gr.type == GAME_TYPE_INVALID) {
+	DERROR_PRINTF("Received GAME_PHASE_INVALID");
+	return GAME_PHASE_INVALID;
+  }
 
-  switch (a->type) {
-	case ACTION_CALL_GAME:
-	  if (ss->sgs.took_skat && a->gr.hand) {
-		DEBUG_PRINTF("WOW, stupid idiot, you can't play hand if you already "
-					 "took the skat. Bonk.");
+  switch (a->gr.type) {
+	case GAME_TYPE_GRAND:
+	  if (a->gr.trumpf != COLOR_INVALID)
 		return GAME_PHASE_INVALID;
-	  }
+	  goto skip_color_check;
+	case GAME_TYPE_COLOR:
+	  col = a->gr.trumpf;
+	  if (col != COLOR_KREUZ && col != COLOR_PIK && col != COLOR_HERZ
+		  && col != COLOR_KARO)
+		return GAME_PHASE_INVALID;
+
+	skip_color_check:
+	  tmp = a->gr.hand | (a->gr.schneider_angesagt << 1)
+			| (a->gr.schwarz_angesagt << 2) | (a->gr.ouvert << 3);
 
-	  if (a->gr.type == GAME_TYPE_INVALID) {
-		DERROR_PRINTF("Received GAME_PHASE_INVALID");
+	  if (tmp & (tmp + 1))
 		return GAME_PHASE_INVALID;
-	  }
+	  break;
+	case GAME_TYPE_NULL:
+	  if (a->gr.trumpf != COLOR_INVALID)
+		return GAME_PHASE_INVALID;
+	  if (a->gr.schwarz_angesagt || a->gr.schneider_angesagt)
+		return GAME_PHASE_INVALID;
+	  break;
+	  // TODO: GAME_TYPE_RAMSCH
+	default:
+	  return GAME_PHASE_INVALID;
+  }
 
-	  switch (a->gr.type) {
-		case GAME_TYPE_GRAND:
-		  if (a->gr.trumpf != COLOR_INVALID)
-			return GAME_PHASE_INVALID;
-		  goto skip_color_check;
-		case GAME_TYPE_COLOR:
-		  col = a->gr.trumpf;
-		  if (col != COLOR_KREUZ && col != COLOR_PIK && col != COLOR_HERZ
-			  && col != COLOR_KARO)
-			return GAME_PHASE_INVALID;
-
-		skip_color_check:
-		  tmp = a->gr.hand | (a->gr.schneider_angesagt << 1)
-				| (a->gr.schwarz_angesagt << 2) | (a->gr.ouvert << 3);
-
-		  if (tmp & (tmp + 1))
-			return GAME_PHASE_INVALID;
-		  break;
-		case GAME_TYPE_NULL:
-		  if (a->gr.trumpf != COLOR_INVALID)
-			return GAME_PHASE_INVALID;
-		  if (a->gr.schwarz_angesagt || a->gr.schneider_angesagt)
-			return GAME_PHASE_INVALID;
-		  break;
-		  // TODO: GAME_TYPE_RAMSCH
-		default:
-		  return GAME_PHASE_INVALID;
-	  }
+  ss->sgs.gr = a->gr;
 
-	  ss->sgs.gr = a->gr;
+  e.answer_to = a->id;
+  e.acting_player = pl->gupid;
+  e.type = EVENT_GAME_CALLED;
+  e.gr = a->gr;
+  server_distribute_event(s, &e, NULL);
 
-	  e.type = EVENT_GAME_CALLED;
-	  e.gr = a->gr;
-	  server_distribute_event(s, &e, NULL);
+  return GAME_PHASE_PLAY_STICH_C1;
+}
 
-	  return GAME_PHASE_PLAY_STICH_C1;
-	default:
-	  DEBUG_PRINTF("Trying to use undefined action %s in state %s",
-				   action_name_table[a->type],
-				   game_phase_name_table[ss->sgs.cgphase]);
-	  return GAME_PHASE_INVALID;
+static void
+archive_finished_round(skat_server_state *ss, server *s) {
+  archive_round *ar = &ss->round;
+  player *pl;
+
+  ar->gr = ss->sgs.gr;
+  ar->alleinspieler = ss->sgs.alleinspieler;
+  ar->reizwert = ss->sgs.rs.reizwert;
+  for (int ap = 0; ap < 3; ap++) {
+	pl = s->pls[ss->sgs.active_players[ap]];
+	snprintf(ar->names[ap], sizeof(ar->names[ap]), "%s", pl ? pl->name : "");
   }
+
+  if (ss->archive
+	  && (archive_write(ss->archive, ar) || fflush(ss->archive)))
+	DERROR_PRINTF("Could not archive the round");
+
+  // From the archived round, so recomputing from the archive agrees
+  if (!ss->ratings || ar->alleinspieler < 0)
+	return;
+  if (rating_update_round(ss->ratings, ar))
+	DERROR_PRINTF("Could not rate the round");
+  else
+	ss->ratings_dirty = 1;
 }
 
-static int
-next_active_player(int player, int off) {
-  return (player + off) % 3;
+// Plays the rest of the round with the first legal card of every hand, once
+// the outcome is decided any line ends the same
+static void
+play_out_round(skat_server_state *ss) {
+  stich *st = &ss->sgs.curr_stich;
+  card_id cid = 0;
+  int curr, legal, winnerv;
+
+  for (; ss->sgs.stich_num < 10; ss->sgs.stich_num++) {
+	for (int i = 0; i < 3; i++) {
+	  curr = next_active_player(st->vorhand, i);
+	  for (uint8_t j = 0;
+		   !card_collection_get_card(&ss->player_hands[curr], &j, &cid); j++)
+		if (!stich_card_legal(&ss->sgs.gr, st, &cid, &ss->player_hands[curr],
+							  &legal)
+			&& legal)
+		  break;
+	  card_collection_remove_card(&ss->player_hands[curr], &cid);
+	  st->cs[i] = cid;
+	  st->played_cards = i + 1;
+	}
+
+	stich_get_winner(&ss->sgs.gr, st, &winnerv);
+	st->winner = next_active_player(st->vorhand, winnerv);
+	card_collection_add_card_array(ss->stiche[st->winner], st->cs, 3);
+
+	ss->sgs.last_stich = *st;
+	*st = (stich){.vorhand = ss->sgs.last_stich.winner, .winner = -1};
+  }
+}
+
+// Ends the round without playing it out if nothing can change its outcome
+// any more
+static bool
+claim_round(skat_server_state *ss, server *s) {
+  solver_position pos;
+  event e;
+  int fixed;
+
+  if (!ss->claim_solver || ss->sgs.gr.type == GAME_TYPE_RAMSCH
+	  || solver_position_from_state(ss, &pos)
+	  || claim_outcome_fixed(ss->claim_solver, &pos, SERVER_CLAIM_MAX_NODES,
+							 &fixed)
+	  || !fixed)
+	return false;
+
+  DEBUG_PRINTF("Outcome decided after %d stiche, claiming the round",
+			   ss->sgs.stich_num);
+  play_out_round(ss);
+
+  e.type = EVENT_ROUND_CLAIMED;
+  e.answer_to = -1;
+  e.acting_player = -1;
+  server_distribute_event(s, &e, NULL);
+  return true;
 }
 
 static game_phase
-apply_action_stich(skat_server_state *ss, action *a, player *pl, server *s,
-				   int ind) {
+apply_play_card(skat_server_state *ss, action *a, player *pl, server *s) {
   event e;
-  player *expected_player;
-  int expected_player_gupid;
+  int ind = ss->sgs.cgphase - GAME_PHASE_PLAY_STICH_C1;
   int curr, result;
   int winnerv;// indexed by vorhand + ap
   int winner; // indexed by ap
 
-  switch (a->type) {
-	case ACTION_PLAY_CARD:
-	  curr = next_active_player(ss->sgs.curr_stich.vorhand, ind);
-	  expected_player_gupid = ss->sgs.active_players[curr];
-	  expected_player = s->pls[expected_player_gupid];
-	  if (pl->gupid != expected_player_gupid) {
-		DEBUG_PRINTF("Wrong player trying to play card: Expected player %s "
-					 "(gupid: %d), but got %s (gupid %d) instead",
-					 expected_player->name, expected_player_gupid, pl->name,
-					 pl->gupid);
+  curr = next_active_player(ss->sgs.curr_stich.vorhand, ind);
+  if (stich_card_legal(&ss->sgs.gr, &ss->sgs.curr_stich, &a->card,
+					   &ss->player_hands[curr], &result)
+	  || !result) {
+	char buf[4];
+	card_get_name(&a->card, buf);
+	DEBUG_PRINTF("Trying to play illegal card %s", buf);
+	return GAME_PHASE_INVALID;
+  }
 
-		return GAME_PHASE_INVALID;
-	  }
-	  if (stich_card_legal(&ss->sgs.gr, &ss->sgs.curr_stich, &a->card,
-						   &ss->player_hands[curr], &result)
-		  || !result) {
-		char buf[4];
-		card_get_name(&a->card, buf);
-		DEBUG_PRINTF("Trying to play illegal card %s", buf);
-		return GAME_PHASE_INVALID;
-	  }
+  e.type = EVENT_PLAY_CARD;
+  e.answer_to = a->id;
+  e.acting_player = pl->gupid;
+  e.card = a->card;
+  server_distribute_event(s, &e, NULL);
 
-	  e.type = EVENT_PLAY_CARD;
-	  e.answer_to = a->id;
-	  e.acting_player = pl->gupid;
-	  e.card = a->card;
-	  server_distribute_event(s, &e, NULL);
-
-	  card_collection_remove_card(&ss->player_hands[curr], &a->card);
-
-	  if (!ind) {
-		ss->sgs.curr_stich.cs[0] = a->card;
-		ss->sgs.curr_stich.played_cards = 1;
-		return GAME_PHASE_PLAY_STICH_C2;
-	  } else if (ind == 1) {
-		ss->sgs.curr_stich.cs[1] = a->card;
-		ss->sgs.curr_stich.played_cards = 2;
-		return GAME_PHASE_PLAY_STICH_C3;
-	  } else {// ind == 2
-		ss->sgs.curr_stich.cs[2] = a->card;
-		ss->sgs.curr_stich.played_cards = 3;
-	  }
+  card_collection_remove_card(&ss->player_hands[curr], &a->card);
+  if (ss->round.length < ARCHIVE_CARDS)
+	ss->round.cards[ss->round.length++] = a->card;
 
-	  stich_get_winner(&ss->sgs.gr, &ss->sgs.curr_stich,
-					   &winnerv);// Sue me for discarding the return value
+  ss->sgs.curr_stich.cs[ind] = a->card;
+  ss->sgs.curr_stich.played_cards = ind + 1;
+  if (ind < 2)
+	return GAME_PHASE_PLAY_STICH_C2 + ind;
 
-	  winner = next_active_player(ss->sgs.curr_stich.vorhand, winnerv);
-	  ss->sgs.curr_stich.winner = winner;
+  stich_get_winner(&ss->sgs.gr, &ss->sgs.curr_stich,
+				   &winnerv);// Sue me for discarding the return value
 
-	  card_collection_add_card_array(ss->stiche[winner], ss->sgs.curr_stich.cs,
-									 3);
+  winner = next_active_player(ss->sgs.curr_stich.vorhand, winnerv);
+  ss->sgs.curr_stich.winner = winner;
 
-	  e.type = EVENT_STICH_DONE;
-	  e.answer_to = -1;
-	  e.acting_player = -1;
-	  e.stich_winner = ss->sgs.active_players[winner];
-	  server_distribute_event(s, &e, NULL);
+  card_collection_add_card_array(ss->stiche[winner], ss->sgs.curr_stich.cs, 3);
 
-	  ss->sgs.last_stich = ss->sgs.curr_stich;
-	  ss->sgs.curr_stich =
-			  (stich){.vorhand = ss->sgs.last_stich.winner, .winner = -1};
+  e.type = EVENT_STICH_DONE;
+  e.answer_to = -1;
+  e.acting_player = -1;
+  e.stich_winner = ss->sgs.active_players[winner];
+  server_distribute_event(s, &e, NULL);
 
-	  if (ss->sgs.stich_num++ < 9)
-		return GAME_PHASE_PLAY_STICH_C1;
+  ss->sgs.last_stich = ss->sgs.curr_stich;
+  ss->sgs.curr_stich =
+		  (stich){.vorhand = ss->sgs.last_stich.winner, .winner = -1};
 
-	  skat_calculate_game_result(ss, &e.rr);
+  if (ss->sgs.stich_num++ < 9 && !claim_round(ss, s))
+	return GAME_PHASE_PLAY_STICH_C1;
 
-	  e.answer_to = -1;
-	  e.type = EVENT_ANNOUNCE_SCORES;
-	  server_distribute_event(s, &e, NULL);
+  skat_calculate_game_result(ss, &e.rr);
+  ss->result = e.rr;
+  ss->rounds_finished++;
 
-	  for (int i = 0; i < 3; i++)
-		ss->sgs.score[ss->sgs.active_players[i]] += e.rr.round_score[i];
+  e.answer_to = -1;
+  e.type = EVENT_ANNOUNCE_SCORES;
+  server_distribute_event(s, &e, NULL);
 
-	  memcpy(e.score_total, ss->sgs.score, sizeof ss->sgs.score);
-	  e.answer_to = -1;
-	  e.type = EVENT_ROUND_DONE;
-	  server_distribute_event(s, &e, NULL);
+  for (int i = 0; i < 3; i++)
+	ss->sgs.score[ss->sgs.active_players[i]] += e.rr.round_score[i];
 
-	  return GAME_PHASE_BETWEEN_ROUNDS;
-	default:
-	  DEBUG_PRINTF("Trying to use undefined action %s in state %s",
-				   action_name_table[a->type],
-				   game_phase_name_table[ss->sgs.cgphase]);
-	  return GAME_PHASE_INVALID;
-  }
+  memcpy(e.score_total, ss->sgs.score, sizeof ss->sgs.score);
+  e.answer_to = -1;
+  e.type = EVENT_ROUND_DONE;
+  server_distribute_event(s, &e, NULL);
+
+  if (ss->archive || ss->ratings)
+	archive_finished_round(ss, s);
+
+  return GAME_PHASE_BETWEEN_ROUNDS;
+}
+
+// Dense (phase, action) jump table, generated from game_transitions.def
+static const game_transition game_transitions[GAME_PHASE_COUNT]
+											 [ACTION_TYPE_COUNT] = {
+#define GAME_TRANSITION(PHASE, ACTION, HANDLER, GUARD)                         \
+  [GAME_PHASE_##PHASE][ACTION_##ACTION] = {.guard = GUARD, .handler = HANDLER},
+#include "game_transitions.def"
+};
+
+int
+skat_transition_exists(game_phase phase, action_type type) {
+  if ((unsigned) phase >= GAME_PHASE_COUNT
+	  || (unsigned) type >= ACTION_TYPE_COUNT)
+	return 0;
+  return game_transitions[phase][type].handler != NULL;
 }
 
 static game_phase
 apply_action(skat_server_state *ss, action *a, player *pl, server *s) {
+  const game_transition *t;
+
+  if ((unsigned) a->type >= ACTION_TYPE_COUNT) {
+	DEBUG_PRINTF("Received unknown action type %d", a->type);
+	return GAME_PHASE_INVALID;
+  }
+
   DEBUG_PRINTF("Applying action %s in skat state %s",
 			   action_name_table[a->type],
 			   game_phase_name_table[ss->sgs.cgphase]);
-  switch (ss->sgs.cgphase) {
-	case GAME_PHASE_SETUP:
-	  return apply_action_setup(ss, a, pl, s);
-	case GAME_PHASE_BETWEEN_ROUNDS:
-	  return apply_action_between_rounds(ss, a, pl, s);
-	case GAME_PHASE_REIZEN:
-	  return apply_action_reizen(ss, a, pl, s);
-	case GAME_PHASE_SKAT_AUFNEHMEN:
-	  return apply_action_skat_aufnehmen(ss, a, pl, s);
-	case GAME_PHASE_SPIELANSAGE:
-	  return apply_action_spielansage(ss, a, pl, s);
-	case GAME_PHASE_PLAY_STICH_C1:
-	  return apply_action_stich(ss, a, pl, s, 0);
-	case GAME_PHASE_PLAY_STICH_C2:
-	  return apply_action_stich(ss, a, pl, s, 1);
-	case GAME_PHASE_PLAY_STICH_C3:
-	  return apply_action_stich(ss, a, pl, s, 2);
-	default:
-	  DERROR_PRINTF("Undefined Gamestate encountered!");
-	  return GAME_PHASE_INVALID;
+
+  if (!skat_transition_exists(ss->sgs.cgphase, a->type)) {
+	DEBUG_PRINTF("Trying to use undefined action %s in state %s",
+				 action_name_table[a->type],
+				 game_phase_name_table[ss->sgs.cgphase]);
+	return GAME_PHASE_INVALID;
   }
+
+  t = &game_transitions[ss->sgs.cgphase][a->type];
+  if (t->guard && !t->guard(ss, a, pl, s))
+	return GAME_PHASE_INVALID;
+
+  return t->handler(ss, a, pl, s);
 }
 
 int
@@ -1015,8 +1052,8 @@ skat_client_handle_skat_events(skat_client_state *cs, event *e, client *c) {
   }
 }
 
-int
-skat_client_state_apply(skat_client_state *cs, event *e, client *c) {
+static int
+skat_client_state_apply_event(skat_client_state *cs, event *e, client *c) {
   DTODO_PRINTF("Insert sanity checks.");
   char card_name_buf[4];
   switch (e->type) {
@@ -1031,22 +1068,32 @@ skat_client_state_apply(skat_client_state *cs, event *e, client *c) {
 	  memcpy(cs->sgs.active_players, e->current_active_players,
 			 sizeof(cs->sgs.active_players));
 
-	  for (int gupid = 0; gupid < 4; gupid++) {
-		if (c->pls[gupid])
-		  c->pls[gupid]->ap = -1;
+	  // Without a client (bot seats of the server) there are no players to
+	  // keep up to date
+	  if (c) {
+		for (int gupid = 0; gupid < 4; gupid++) {
+		  if (c->pls[gupid])
+			c->pls[gupid]->ap = -1;
+		}
+
+		for (int ap = 0; ap < 3; ap++) {
+		  c->pls[cs->sgs.active_players[ap]]->ap = ap;
+		}
 	  }
 
+	  cs->my_active_player_index = -1;
 	  for (int ap = 0; ap < 3; ap++) {
-		c->pls[c->cs.sgs.active_players[ap]]->ap = ap;
+		if (cs->sgs.active_players[ap] == cs->my_gupid)
+		  cs->my_active_player_index = ap;
 	  }
 
-	  cs->my_active_player_index = c->pls[c->cs.my_gupid]->ap;
-
 	  return 1;
 	case EVENT_DISTRIBUTE_CARDS:
 	  DEBUG_PRINTF("Distributing cards");
 
 	  cs->my_hand = e->hand;
+	  // A Ramsch of the last round would make everyone alleinspieler
+	  memset(&cs->sgs.gr, '\0', sizeof(cs->sgs.gr));
 
 	  cs->sgs.curr_stich =
 			  (stich){.played_cards = 0, .vorhand = 0, .winner = -1};
@@ -1080,9 +1127,10 @@ skat_client_state_apply(skat_client_state *cs, event *e, client *c) {
 	  return 1;
 	case EVENT_PLAY_CARD:
 	  card_get_name(&e->card, card_name_buf);
-	  DEBUG_PRINTF("%s (%d) played card %s", c->pls[e->acting_player]->name,
+	  DEBUG_PRINTF("%s (%d) played card %s",
+				   c ? c->pls[e->acting_player]->name : "Player",
 				   e->acting_player, card_name_buf);
-	  if (c->cs.my_gupid == e->acting_player) {
+	  if (cs->my_gupid == e->acting_player) {
 		card_collection_remove_card(&cs->my_hand, &e->card);
 	  }
 
@@ -1135,6 +1183,21 @@ skat_client_state_apply(skat_client_state *cs, event *e, client *c) {
 	  cs->sgs.curr_stich =
 			  (stich){.vorhand = cs->sgs.last_stich.winner, .winner = -1};
 
+	  return 1;
+	case EVENT_ROUND_CLAIMED:
+	  DEBUG_PRINTF("Round claimed");
+
+	  if (cs->sgs.cgphase != GAME_PHASE_PLAY_STICH_C1) {
+		DERROR_PRINTF("Invalid game phase %s for ROUND_CLAIMED",
+					  game_phase_name_table[cs->sgs.cgphase]);
+		return 0;
+	  }
+
+	  // The server plays the rest, the hand is of no use any more
+	  card_collection_empty(&cs->my_hand);
+	  cs->sgs.stich_num = 10;
+	  cs->sgs.cgphase = GAME_PHASE_CLIENT_WAIT_ANNOUNCE_SCORES;
+
 	  return 1;
 	case EVENT_ANNOUNCE_SCORES:
 	  DEBUG_PRINTF("Scores are being announced, everyone is shivering with "
@@ -1171,9 +1234,81 @@ skat_client_state_apply(skat_client_state *cs, event *e, client *c) {
   }
 }
 
+int
+skat_client_state_apply(skat_client_state *cs, event *e, client *c) {
+  if (!skat_client_state_apply_event(cs, e, c))
+	return 0;
+  if (card_tracker_observe(&cs->tracker, cs, e))
+	DERROR_PRINTF("Could not track the cards of event %s",
+				  event_name_table[e->type]);
+  return 1;
+}
+
 void
 skat_client_state_tick(skat_client_state *cs, client *c) {}
 
+// Feeds the tracker the events of the round so far as the seat saw them,
+// so it ends up as if the seat had never been away. cs must be resynced
+// otherwise.
+static void
+resync_tracker(const skat_server_state *ss, skat_client_state *cs) {
+  const archive_round *ar = &ss->round;
+  const int me = cs->my_active_player_index, as = ss->sgs.alleinspieler;
+  skat_client_state replay = *cs;
+  stich *st = &replay.sgs.curr_stich;
+  int winner, error = 0;
+  event e;
+
+  card_tracker_reset(&cs->tracker, me, cs->my_hand);
+  if (ss->sgs.cgphase == GAME_PHASE_SETUP
+	  || ss->sgs.cgphase == GAME_PHASE_BETWEEN_ROUNDS)
+	return;
+
+  memset(&e, '\0', sizeof(e));
+  e.type = EVENT_DISTRIBUTE_CARDS;
+  replay.my_hand = me < 0 ? 0 : ar->d.hands[me];
+  error |= card_tracker_observe(&replay.tracker, &replay, &e);
+
+  if (ss->sgs.took_skat && as >= 0) {
+	e.type = EVENT_SKAT_TAKE;
+	if (as == me)
+	  memcpy(e.skat, ss->skat, sizeof(e.skat));
+	error |= card_tracker_observe(&replay.tracker, &replay, &e);
+
+	if (ss->sgs.cgphase != GAME_PHASE_SKAT_AUFNEHMEN) {
+	  e.type = EVENT_SKAT_PRESS;
+	  if (as == me)
+		for (uint8_t i = 0; i < 2; i++)
+		  error |= card_collection_get_card(&ar->skat, &i,
+											&e.skat_press_cards[i]);
+	  error |= card_tracker_observe(&replay.tracker, &replay, &e);
+	}
+  }
+
+  *st = (stich){.vorhand = 0, .winner = -1};
+  for (uint8_t i = 0; i < ar->length; i++) {
+	e.type = EVENT_PLAY_CARD;
+	e.card = ar->cards[i];
+	st->cs[st->played_cards++] = e.card;
+	error |= card_tracker_observe(&replay.tracker, &replay, &e);
+	if (st->played_cards < 3)
+	  continue;
+
+	error |= stich_get_winner(&replay.sgs.gr, st, &winner);
+	st->winner = next_active_player(st->vorhand, winner);
+	replay.sgs.last_stich = *st;
+	e.type = EVENT_STICH_DONE;
+	error |= card_tracker_observe(&replay.tracker, &replay, &e);
+	*st = (stich){.vorhand = replay.sgs.last_stich.winner, .winner = -1};
+  }
+
+  if (error)
+	DERROR_PRINTF("Could not replay the round for the tracker of seat %d",
+				  cs->my_gupid);
+  else
+	cs->tracker = replay.tracker;
+}
+
 void
 skat_resync_player(skat_server_state *ss, skat_client_state *cs, player *pl) {
   memset(cs, '\0', sizeof(skat_client_state));
@@ -1184,6 +1319,7 @@ skat_resync_player(skat_server_state *ss, skat_client_state *cs, player *pl) {
 
   cs->my_gupid = pl->gupid;
   cs->my_active_player_index = pl->ap;
+  resync_tracker(ss, cs);
 
   if (cs->my_active_player_index == -1) {
 	cs->ist_alleinspieler = -1;
@@ -1213,7 +1349,50 @@ void
 server_skat_state_init(skat_server_state *ss) {
   ss->sgs.cgphase = GAME_PHASE_SETUP;
   memset(ss->sgs.score, 0, sizeof(ss->sgs.score));
+  if (rng_seed_random(&ss->deal_rng))
+	exit(EXIT_FAILURE);
   memset(ss->sgs.active_players, -1, sizeof(ss->sgs.active_players));
+
+  ss->claim_solver = malloc(sizeof(*ss->claim_solver));
+  if (ss->claim_solver && solver_init(ss->claim_solver, SERVER_CLAIM_TT_BITS)) {
+	free(ss->claim_solver);
+	ss->claim_solver = NULL;
+  }
+  if (!ss->claim_solver)
+	DERROR_PRINTF("Could not set up claiming, rounds are played out");
+}
+
+void
+server_skat_state_free(skat_server_state *ss) {
+  if (ss->claim_solver) {
+	solver_free(ss->claim_solver);
+	free(ss->claim_solver);
+	ss->claim_solver = NULL;
+  }
+}
+
+void
+server_skat_state_seed_deals(skat_server_state *ss, uint64_t seed) {
+  rng_seed(&ss->deal_rng, seed);
+}
+
+void
+server_skat_state_set_deals(skat_server_state *ss, deal *deals, size_t length) {
+  ss->fixed_deals = deals;
+  ss->fixed_deals_length = length;
+  ss->fixed_deals_next = 0;
+}
+
+void
+server_skat_state_set_archive(skat_server_state *ss, FILE *archive) {
+  ss->archive = archive;
+}
+
+void
+server_skat_state_set_ratings(skat_server_state *ss, rating_table *ratings,
+							  const char *path) {
+  ss->ratings = ratings;
+  ss->ratings_path = path;
 }
 
 void
@@ -1223,6 +1402,7 @@ client_skat_state_init(skat_client_state *cs) {
   memset(cs->sgs.active_players, -1, sizeof(cs->sgs.active_players));
 
   cs->my_partner = cs->my_active_player_index = -1;
+  card_tracker_reset(&cs->tracker, -1, 0);
 }
 
 void
@@ -0,0 +1,978 @@
+#include "skat/solver.h"
+#include "skat/canonical.h"
+#include "skat/null_solver.h"
+#include "skat/rng.h"
+#include "skat/skat.h"
+#include "skat/util.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SOLVER_TRUMPF    (4)
+#define SOLVER_NO_CARD   (0xff)
+#define SOLVER_INFINITY  (1000)
+#define SOLVER_SLOT_NULL (5)
+#define SOLVER_POLL_MASK (1023)
+#define SOLVER_MAX_THREADS (64)
+
+typedef struct {
+  uint8_t suit[32];  // 0-3: color lanes, SOLVER_TRUMPF: trumpf
+  uint8_t rank[32];  // strength inside the suit
+  uint8_t points[32];
+  card_collection suit_mask[5];
+  uint8_t order[5][11];// strongest first
+  uint8_t order_length[5];
+  uint8_t slot;
+  int null;
+} solver_rules;
+
+// State shared by the threads of one limited solve
+typedef struct {
+  int stop;
+  uint64_t nodes;
+  uint64_t max_nodes;// 0: unlimited
+  struct timespec deadline;
+  int has_deadline;
+} solver_shared;
+
+typedef struct {
+  solver *sv;
+  const solver_rules *r;
+  const tablebase *tb;
+  game_rules gr;
+  card_collection hands[3];
+  int alleinspieler;
+  uint64_t key;// hands and game, the leader is added on lookup
+  canonical_perm perm;// hands are searched in canonical form
+  uint64_t nodes;
+  uint64_t nodes_flushed;
+  solver_shared *shared;// NULL for unlimited single threaded solves
+  int thread;           // lazy SMP helpers (> 0) perturb their move order
+  int everyone;// 0: minimax, > 0: all play for the alleinspieler, < 0: against
+  int eval_cards;// stich starts with this many cards per hand are estimated
+  eval_context ev;
+  int aborted;
+} solver_search;
+
+static uint64_t solver_zobrist_hand[3][32];
+static uint64_t solver_zobrist_leader[3];
+static uint64_t solver_zobrist_game[6][3];
+static uint64_t solver_zobrist_everyone[2];
+static uint64_t solver_zobrist_eval[10];// by the cards left at the cutoff
+
+// (a + b) % 3 for a, b < 3
+static const uint8_t solver_mod3[5] = {0, 1, 2, 0, 1};
+
+__attribute__((constructor)) static void
+solver_init_zobrist(void) {
+  rng r;
+  rng_seed(&r, 0x536b617453766c72ull);
+  for (int p = 0; p < 3; p++)
+	for (int i = 0; i < 32; i++)
+	  solver_zobrist_hand[p][i] = rng_next_u64(&r);
+  for (int p = 0; p < 3; p++)
+	solver_zobrist_leader[p] = rng_next_u64(&r);
+  for (int g = 0; g < 6; g++)
+	for (int p = 0; p < 3; p++)
+	  solver_zobrist_game[g][p] = rng_next_u64(&r);
+  for (int e = 0; e < 2; e++)
+	solver_zobrist_everyone[e] = rng_next_u64(&r);
+  for (int c = 0; c < 10; c++)
+	solver_zobrist_eval[c] = rng_next_u64(&r);
+}
+
+static solver_rules solver_rules_table[6];// color per trumpf, grand, null
+
+static int
+solver_rules_slot(const game_rules *const gr, uint8_t *const slot) {
+  switch (gr->type) {
+	case GAME_TYPE_COLOR:
+	  if (gr->trumpf < COLOR_KARO || gr->trumpf > COLOR_KREUZ)
+		return 1;
+	  *slot = gr->trumpf - COLOR_KARO;
+	  return 0;
+	case GAME_TYPE_GRAND:
+	  *slot = 4;
+	  return 0;
+	case GAME_TYPE_NULL:
+	  *slot = SOLVER_SLOT_NULL;
+	  return 0;
+	default:
+	  return 1;
+  }
+}
+
+static void
+solver_rules_build(const game_rules *const gr, solver_rules *const r) {
+  memset(r, '\0', sizeof(*r));
+  solver_rules_slot(gr, &r->slot);
+  r->null = gr->type == GAME_TYPE_NULL;
+
+  for (uint8_t i = 0; i < 32; i++) {
+	card_type ct = (i & 0b111u) + 1;
+	card_color cc = (i >> 3u) + 1;
+	int trumpf = !r->null
+				 && (ct == CARD_TYPE_B
+					 || (gr->type == GAME_TYPE_COLOR && cc == gr->trumpf));
+	card_id cid = card_collection_id_from_index(i);
+	card_get_score(&cid, &r->points[i]);
+	r->suit[i] = trumpf ? SOLVER_TRUMPF : i >> 3u;
+	r->suit_mask[r->suit[i]] |= 0b1u << i;
+  }
+
+  // Ranks as decided by stich_get_winner, so the rules live in one place
+  for (uint8_t i = 0; i < 32; i++) {
+	card_collection rest = r->suit_mask[r->suit[i]] & ~(0b1u << i);
+	stich st = {.played_cards = 3};
+	int winner;
+	st.cs[1] = st.cs[2] = card_collection_id_from_index(i);
+	for (; rest; rest &= rest - 1) {
+	  st.cs[0] = card_collection_id_from_index(__builtin_ctz(rest));
+	  if (!stich_get_winner(gr, &st, &winner) && winner)
+		r->rank[i]++;
+	}
+  }
+
+  for (uint8_t i = 0; i < 32; i++) {
+	uint8_t s = r->suit[i];
+	uint8_t n = __builtin_popcount(r->suit_mask[s]);
+	r->order[s][n - 1 - r->rank[i]] = i;
+	r->order_length[s] = n;
+  }
+}
+
+__attribute__((constructor)) static void
+solver_init_rules(void) {
+  for (card_color cc = COLOR_KARO; cc <= COLOR_KREUZ; cc++)
+	solver_rules_build(&(game_rules){.type = GAME_TYPE_COLOR, .trumpf = cc},
+					   &solver_rules_table[cc - COLOR_KARO]);
+  solver_rules_build(&(game_rules){.type = GAME_TYPE_GRAND},
+					 &solver_rules_table[4]);
+  solver_rules_build(&(game_rules){.type = GAME_TYPE_NULL},
+					 &solver_rules_table[SOLVER_SLOT_NULL]);
+}
+
+// Strength of a card inside a stich, 0 if it cannot win it
+static int
+solver_card_strength(const solver_rules *const r, const uint8_t c,
+					 const uint8_t lead) {
+  if (r->suit[c] == SOLVER_TRUMPF)
+	return 64 + r->rank[c];
+  if (r->suit[c] == lead)
+	return 32 + r->rank[c];
+  return 0;
+}
+
+// Index into the stich of its winner
+static int
+solver_stich_winner(const solver_rules *const r, const uint8_t *const stich,
+					const int played) {
+  uint8_t lead = r->suit[stich[0]];
+  int best = 0, best_strength = solver_card_strength(r, stich[0], lead);
+  for (int i = 1; i < played; i++) {
+	int strength = solver_card_strength(r, stich[i], lead);
+	if (strength > best_strength) {
+	  best = i;
+	  best_strength = strength;
+	}
+  }
+  return best;
+}
+
+// Value of a complete stich for the alleinspieler, sets its winner
+static int
+solver_stich_gain(const solver_search *const s, const int leader,
+				  const uint8_t *const stich, int *const winner) {
+  const solver_rules *r = s->r;
+  *winner = solver_mod3[leader + solver_stich_winner(r, stich, 3)];
+  if (*winner != s->alleinspieler)
+	return 0;
+  if (r->null)
+	return 1;
+  return r->points[stich[0]] + r->points[stich[1]] + r->points[stich[2]];
+}
+
+// Transposition table entries pack the bounds of the value of the remaining
+// stiche, the best card and the number of cards left:
+// lower (8) | upper (8) | best (8) | cards (8)
+#define SOLVER_TT_LOWER(d) ((int) ((d) & 0xffu))
+#define SOLVER_TT_UPPER(d) ((int) (((d) >> 8u) & 0xffu))
+#define SOLVER_TT_BEST(d)  ((uint8_t) (((d) >> 16u) & 0xffu))
+#define SOLVER_TT_CARDS(d) ((int) (((d) >> 24u) & 0xffu))
+#define SOLVER_TT_DATA(lower, upper, best, cards) \
+  ((uint64_t) (lower) | ((uint64_t) (upper) << 8u) \
+   | ((uint64_t) (best) << 16u) | ((uint64_t) (cards) << 24u))
+
+static int
+solver_tt_probe(const solver *const sv, const uint64_t key,
+				uint64_t *const data) {
+  const solver_tt_entry *bucket = &sv->tt[key & sv->tt_mask & ~1ull];
+  // Entries are written without locks by concurrent searches, a torn entry
+  // fails the check and reads as a miss
+  for (int i = 0; i < 2; i++) {
+	uint64_t d = __atomic_load_n(&bucket[i].data, __ATOMIC_RELAXED);
+	uint64_t check = __atomic_load_n(&bucket[i].check, __ATOMIC_RELAXED);
+	if ((check ^ d) == key) {
+	  *data = d;
+	  return 1;
+	}
+  }
+  return 0;
+}
+
+// First slot keeps the larger subtree, the second one is always replaced
+static void
+solver_tt_store(solver *const sv, const uint64_t key, int lower, int upper,
+				const uint8_t best, const int cards) {
+  solver_tt_entry *bucket = &sv->tt[key & sv->tt_mask & ~1ull];
+  uint64_t old, slot0;
+  solver_tt_entry *e;
+
+  if (solver_tt_probe(sv, key, &old)) {
+	if (SOLVER_TT_LOWER(old) > lower)
+	  lower = SOLVER_TT_LOWER(old);
+	if (SOLVER_TT_UPPER(old) < upper)
+	  upper = SOLVER_TT_UPPER(old);
+  }
+
+  slot0 = __atomic_load_n(&bucket[0].data, __ATOMIC_RELAXED);
+  if ((__atomic_load_n(&bucket[0].check, __ATOMIC_RELAXED) ^ slot0) == key
+	  || cards >= SOLVER_TT_CARDS(slot0))
+	e = &bucket[0];
+  else
+	e = &bucket[1];
+
+  uint64_t data = SOLVER_TT_DATA(lower, upper, best, cards);
+  __atomic_store_n(&e->data, data, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->check, key ^ data, __ATOMIC_RELAXED);
+}
+
+// Drops cards that are interchangeable with a stronger card of the same hand:
+// no live card lies between them and they score the same
+static card_collection
+solver_prune_equivalent(const solver_rules *const r, card_collection legal,
+						const card_collection live) {
+  for (uint8_t s = 0; s < 5; s++) {
+	card_collection mine = legal & r->suit_mask[s];
+	if (!(mine & (mine - 1)))
+	  continue;
+
+	int prev_mine = 0;
+	uint8_t prev_points = 0;
+	for (uint8_t i = 0; i < r->order_length[s]; i++) {
+	  uint8_t c = r->order[s][i];
+	  card_collection bit = 0b1u << c;
+	  if (!(live & bit))
+		continue;
+	  if (!(mine & bit)) {
+		prev_mine = 0;
+		continue;
+	  }
+	  if (prev_mine && r->points[c] == prev_points) {
+		legal &= ~bit;
+	  } else {
+		prev_mine = 1;
+		prev_points = r->points[c];
+	  }
+	}
+  }
+  return legal;
+}
+
+// Highest live card of a suit, SOLVER_NO_CARD if there is none
+static uint8_t
+solver_top_card(const solver_rules *const r, const uint8_t s,
+				const card_collection live) {
+  for (uint8_t i = 0; i < r->order_length[s]; i++)
+	if ((live >> r->order[s][i]) & 0b1u)
+	  return r->order[s][i];
+  return SOLVER_NO_CARD;
+}
+
+// Heuristic move ordering, higher scores are searched first
+static int
+solver_move_score(const solver_search *const s, const int p, const int leader,
+				  const int played, const uint8_t *const stich,
+				  const uint8_t c, const card_collection live) {
+  const solver_rules *r = s->r;
+  int declarer = p == s->alleinspieler;
+
+  if (!played) {
+	if (r->null)
+	  return -r->rank[c];
+	int score = solver_top_card(r, r->suit[c], live) == c
+						? 100 + r->points[c]
+						: 50 - r->points[c] - r->rank[c];
+	if (declarer && r->suit[c] == SOLVER_TRUMPF)
+	  score += 20;
+	return score;
+  }
+
+  uint8_t lead = r->suit[stich[0]];
+  int w = solver_stich_winner(r, stich, played);
+  int winner = solver_mod3[leader + w];
+  int beats = solver_card_strength(r, c, lead)
+			  > solver_card_strength(r, stich[w], lead);
+
+  if (r->null) {
+	if (declarer)
+	  return beats ? -r->rank[c] : 100 + r->rank[c];
+	return beats ? -r->rank[c] : 100 - r->rank[c];
+  }
+
+  if ((winner == s->alleinspieler) == declarer)// own side takes it so far
+	return beats ? 40 - r->points[c] : 60 + 2 * r->points[c];
+  if (beats)
+	return (played == 2 ? 150 : 100) + r->points[c] - r->rank[c];
+  return -r->points[c] - r->rank[c];
+}
+
+static void
+solver_poll(solver_search *const s) {
+  solver_shared *sh = s->shared;
+  uint64_t total = __atomic_add_fetch(&sh->nodes, s->nodes - s->nodes_flushed,
+									  __ATOMIC_RELAXED);
+  struct timespec now;
+
+  s->nodes_flushed = s->nodes;
+  if (sh->max_nodes && total >= sh->max_nodes)
+	__atomic_store_n(&sh->stop, 1, __ATOMIC_RELAXED);
+  if (sh->has_deadline) {
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec > sh->deadline.tv_sec
+		|| (now.tv_sec == sh->deadline.tv_sec
+			&& now.tv_nsec >= sh->deadline.tv_nsec))
+	  __atomic_store_n(&sh->stop, 1, __ATOMIC_RELAXED);
+  }
+  if (__atomic_load_n(&sh->stop, __ATOMIC_RELAXED))
+	s->aborted = 1;
+}
+
+static int
+solver_last_stich(const solver_search *const s, const int leader) {
+  uint8_t stich[3];
+  int winner;
+  for (int i = 0; i < 3; i++)
+	stich[i] = __builtin_ctz(s->hands[solver_mod3[leader + i]]);
+  return solver_stich_gain(s, leader, stich, &winner);
+}
+
+// Fail-soft alpha-beta over the value of the remaining stiche (including the
+// cards already lying in the current one). The alleinspieler maximizes card
+// points, in Null the opponents maximize "the alleinspieler takes a stich".
+// The root asks for its best card and never takes transposition cutoffs.
+// With s->everyone set all players pull the same way, which bounds every
+// possible line of play instead; tablebases only know the minimax values.
+static int
+solver_search_node(solver_search *const s, const int leader, const int played,
+				   uint8_t *stich, int alpha, int beta,
+				   uint8_t *const best_card) {
+  const solver_rules *r = s->r;
+  card_collection all, live, legal;
+  uint64_t key = 0, data;
+  int lower = 0, upper = SOLVER_INFINITY;
+  uint8_t tt_best = SOLVER_NO_CARD, own_stich[3];
+  uint8_t moves[10];
+  int scores[10], n = 0, tb_value;
+
+  if (!(++s->nodes & SOLVER_POLL_MASK) && s->shared)
+	solver_poll(s);
+  if (s->aborted)
+	return 0;
+
+  all = s->hands[0] | s->hands[1] | s->hands[2];
+
+  if (!played) {
+	if (!all)
+	  return 0;
+	upper = r->null ? 1 : card_collection_points(all);
+	if (!best_card) {
+	  if (upper <= alpha)
+		return upper;
+	  if (beta <= 0)
+		return 0;
+	  if (!(s->hands[leader] & (s->hands[leader] - 1)))
+		return solver_last_stich(s, leader);
+	  if (__builtin_popcount(s->hands[leader]) == s->eval_cards)
+		return eval_estimate(&s->ev, s->hands, leader);
+	  if (s->tb && !s->everyone
+		  && __builtin_popcount(s->hands[leader]) == s->tb->stiche
+		  && !tablebase_lookup(s->tb, &s->gr, s->hands, s->alleinspieler,
+							   leader, &tb_value))
+		return tb_value;
+	  if (r->null && !s->everyone
+		  && !null_solver_decide(s->hands, s->alleinspieler, leader, &tb_value))
+		return tb_value;
+	}
+
+	key = s->key ^ solver_zobrist_leader[leader];
+	if (solver_tt_probe(s->sv, key, &data)) {
+	  tt_best = SOLVER_TT_BEST(data);
+	  if (!best_card) {
+		lower = SOLVER_TT_LOWER(data);
+		upper = SOLVER_TT_UPPER(data);
+		if (lower >= beta)
+		  return lower;
+		if (upper <= alpha || lower == upper)
+		  return upper;
+		if (lower > alpha)
+		  alpha = lower;
+		if (upper < beta)
+		  beta = upper;
+	  }
+	}
+	stich = own_stich;
+  }
+
+  const int p = solver_mod3[leader + played];
+  const int maximize = (s->everyone ? s->everyone > 0 : p == s->alleinspieler)
+					   != r->null;
+  const int alpha0 = alpha, beta0 = beta;
+
+  live = all;
+  for (int i = 0; i < played; i++)
+	live |= 0b1u << stich[i];
+
+  legal = s->hands[p];
+  if (played) {
+	card_collection follow = legal & r->suit_mask[r->suit[stich[0]]];
+	if (follow)
+	  legal = follow;
+  }
+  legal = solver_prune_equivalent(r, legal, live);
+
+  for (card_collection m = legal; m; m &= m - 1) {
+	uint8_t c = __builtin_ctz(m);
+	int score = c == tt_best
+						? SOLVER_INFINITY
+						: solver_move_score(s, p, leader, played, stich, c, live);
+	if (s->thread && score != SOLVER_INFINITY)
+	  score += (solver_zobrist_hand[s->thread % 3][c] >> s->thread) & 0xfu;
+	int j = n++;
+	for (; j > 0 && scores[j - 1] < score; j--) {
+	  scores[j] = scores[j - 1];
+	  moves[j] = moves[j - 1];
+	}
+	scores[j] = score;
+	moves[j] = c;
+  }
+
+  int best_v = maximize ? -SOLVER_INFINITY : SOLVER_INFINITY;
+  uint8_t best = moves[0];
+  for (int i = 0; i < n; i++) {
+	uint8_t c = moves[i];
+	int v, winner, gain;
+
+	s->hands[p] ^= 0b1u << c;
+	s->key ^= solver_zobrist_hand[p][c];
+	stich[played] = c;
+
+	if (played < 2) {
+	  v = solver_search_node(s, leader, played + 1, stich, alpha, beta, NULL);
+	} else {
+	  gain = solver_stich_gain(s, leader, stich, &winner);
+	  if (r->null && gain)
+		v = 1;
+	  else
+		v = gain
+			+ solver_search_node(s, winner, 0, NULL, alpha - gain,
+								 beta - gain, NULL);
+	}
+
+	s->key ^= solver_zobrist_hand[p][c];
+	s->hands[p] ^= 0b1u << c;
+
+	if (s->aborted)
+	  return 0;
+
+	if (maximize ? v > best_v : v < best_v) {
+	  best_v = v;
+	  best = c;
+	}
+	if (maximize && v > alpha)
+	  alpha = v;
+	else if (!maximize && v < beta)
+	  beta = v;
+	if (alpha >= beta)
+	  break;
+  }
+
+  if (best_card)
+	*best_card = best;
+
+  if (!played) {
+	if (best_v <= alpha0) {
+	  if (best_v < upper)
+		upper = best_v;
+	} else if (best_v >= beta0) {
+	  if (best_v > lower)
+		lower = best_v;
+	} else {
+	  lower = upper = best_v;
+	}
+	solver_tt_store(s->sv, key, lower, upper, best, __builtin_popcount(all));
+  }
+
+  return best_v;
+}
+
+// MTD(f): zero window searches until the bounds meet. Stops early with the
+// bounds found so far if the search is aborted.
+static void
+solver_mtd(solver_search *const s, const int leader, const int played,
+		   uint8_t *const stich, int *const lower, int *const upper,
+		   const int guess, uint8_t *const best_card) {
+  const int p = solver_mod3[leader + played];
+  const int maximize = (p == s->alleinspieler) != s->r->null;
+  int g = guess, beta;
+  uint8_t candidate = SOLVER_NO_CARD, best = SOLVER_NO_CARD;
+
+  while (*lower < *upper) {
+	beta = g > *lower ? g : *lower + 1;
+	g = solver_search_node(s, leader, played, stich, beta - 1, beta,
+						   &candidate);
+	if (s->aborted)
+	  break;
+	if (g < beta) {
+	  *upper = g;
+	  if (!maximize)
+		best = candidate;
+	} else {
+	  *lower = g;
+	  if (maximize)
+		best = candidate;
+	}
+  }
+
+  if (best_card) {
+	if (candidate == SOLVER_NO_CARD && !s->aborted)// every card is best
+	  solver_search_node(s, leader, played, stich, *lower - 1, *lower,
+						 &candidate);
+	*best_card = best != SOLVER_NO_CARD ? best : candidate;
+  }
+}
+
+typedef struct {
+  solver_search s;
+  int leader, played;
+  uint8_t stich[3];
+  int lower, upper, guess;
+  pthread_t thread;
+} solver_worker;
+
+static void *
+solver_worker_run(void *args) {
+  solver_worker *w = args;
+  solver_mtd(&w->s, w->leader, w->played, w->stich, &w->lower, &w->upper,
+			 w->guess, NULL);
+  return NULL;
+}
+
+// Positions equal up to suit symmetry share their transposition table
+// entries, as the search runs on the canonical form
+static int
+solver_search_init(solver *const sv, const solver_position *const orig,
+				   solver_search *const s, int *const leader,
+				   int *const played, uint8_t *const stich) {
+  solver_position canon;
+  const solver_position *const pos = &canon;
+  uint8_t count[3];
+  card_collection seen = 0;
+
+  if (canonical_position(orig, &canon, &s->perm))
+	return 1;
+
+  uint8_t slot;
+  if (solver_rules_slot(&pos->gr, &slot))
+	return 1;
+  s->r = &solver_rules_table[slot];
+  s->tb = sv->tablebases[slot < 4 ? 0 : slot - 3];
+  s->gr = pos->gr;
+  if (pos->alleinspieler < 0 || pos->alleinspieler > 2)
+	return 1;
+  if (pos->curr_stich.played_cards < 0 || pos->curr_stich.played_cards > 2
+	  || pos->curr_stich.vorhand < 0 || pos->curr_stich.vorhand > 2)
+	return 1;
+
+  s->sv = sv;
+  s->alleinspieler = pos->alleinspieler;
+  s->nodes = 0;
+  s->nodes_flushed = 0;
+  s->shared = NULL;
+  s->thread = 0;
+  s->everyone = 0;
+  s->eval_cards = 0;
+  s->aborted = 0;
+  s->key = solver_zobrist_game[s->r->slot][s->alleinspieler];
+  *leader = pos->curr_stich.vorhand;
+  *played = pos->curr_stich.played_cards;
+
+  for (int p = 0; p < 3; p++) {
+	s->hands[p] = pos->hands[p];
+	if (seen & s->hands[p])
+	  return 1;
+	seen |= s->hands[p];
+	count[p] = __builtin_popcount(s->hands[p]);
+	for (card_collection m = s->hands[p]; m; m &= m - 1)
+	  s->key ^= solver_zobrist_hand[p][__builtin_ctz(m)];
+  }
+
+  for (int i = 0; i < *played; i++) {
+	if (card_collection_index_from_id(&pos->curr_stich.cs[i], &stich[i])
+		|| (seen >> stich[i]) & 0b1u)
+	  return 1;
+	seen |= 0b1u << stich[i];
+	count[solver_mod3[*leader + i]]++;
+  }
+
+  if (count[0] != count[1] || count[1] != count[2] || count[0] > 10)
+	return 1;
+
+  return 0;
+}
+
+static int
+solver_search_upper(const solver_search *const s, const int played,
+					const uint8_t *const stich) {
+  card_collection all = s->hands[0] | s->hands[1] | s->hands[2];
+  for (int i = 0; i < played; i++)
+	all |= 0b1u << stich[i];
+  if (s->r->null)
+	return all ? 1 : 0;
+  return card_collection_points(all);
+}
+
+int
+solver_init(solver *sv, uint8_t tt_bits) {
+  if (tt_bits < 1 || tt_bits > 32)
+	return 1;
+  sv->tt = calloc(1ull << tt_bits, sizeof(solver_tt_entry));
+  if (!sv->tt)
+	return 2;
+  sv->tt_mask = (1ull << tt_bits) - 1;
+  sv->nodes = 0;
+  memset(sv->tablebases, '\0', sizeof(sv->tablebases));
+  return 0;
+}
+
+void
+solver_free(solver *sv) {
+  free(sv->tt);
+  sv->tt = NULL;
+}
+
+void
+solver_clear(solver *sv) {
+  memset(sv->tt, '\0', (sv->tt_mask + 1) * sizeof(solver_tt_entry));
+}
+
+// Searches end at stich starts covered by the tablebase
+int
+solver_use_tablebase(solver *sv, const tablebase *tb) {
+  switch (tb->type) {
+	case GAME_TYPE_COLOR:
+	  sv->tablebases[0] = tb;
+	  return 0;
+	case GAME_TYPE_GRAND:
+	  sv->tablebases[1] = tb;
+	  return 0;
+	case GAME_TYPE_NULL:
+	  sv->tablebases[2] = tb;
+	  return 0;
+	default:
+	  return 1;
+  }
+}
+
+int
+solver_position_from_state(const skat_server_state *ss, solver_position *pos) {
+  int as = ss->sgs.alleinspieler;
+  unsigned int score;
+  uint8_t count;
+
+  if (as < 0 || as > 2 || !ss->stiche[as])
+	return 1;
+
+  memset(pos, '\0', sizeof(*pos));
+  pos->gr = ss->sgs.gr;
+  memcpy(pos->hands, ss->player_hands, sizeof(pos->hands));
+  pos->alleinspieler = as;
+  pos->curr_stich = ss->sgs.curr_stich;
+
+  // The alleinspieler's stiche also hold the skat
+  if (card_collection_get_score(ss->stiche[as], &score)
+	  || card_collection_get_card_count(ss->stiche[as], &count))
+	return 1;
+  pos->alleinspieler_points = score;
+  pos->alleinspieler_stiche = count / 3;
+  return 0;
+}
+
+int
+solver_position_player(const solver_position *pos, int *ap) {
+  if (pos->curr_stich.vorhand < 0 || pos->curr_stich.vorhand > 2
+	  || pos->curr_stich.played_cards < 0 || pos->curr_stich.played_cards > 2)
+	return 1;
+  *ap = solver_mod3[pos->curr_stich.vorhand + pos->curr_stich.played_cards];
+  return 0;
+}
+
+int
+solver_position_legal_moves(const solver_position *pos,
+							card_collection *moves) {
+  int ap, legal;
+  if (solver_position_player(pos, &ap))
+	return 1;
+
+  *moves = 0;
+  for (card_collection m = pos->hands[ap]; m; m &= m - 1) {
+	card_id cid = card_collection_id_from_index(__builtin_ctz(m));
+	if (stich_card_legal(&pos->gr, &pos->curr_stich, &cid, &pos->hands[ap],
+						 &legal))
+	  return 1;
+	if (legal)
+	  card_collection_add_card(moves, &cid);
+  }
+  return 0;
+}
+
+int
+solver_position_play(solver_position *pos, card_id cid) {
+  int ap, legal, winnerv, winner;
+  unsigned int score;
+
+  if (solver_position_player(pos, &ap)
+	  || stich_card_legal(&pos->gr, &pos->curr_stich, &cid, &pos->hands[ap],
+						  &legal))
+	return 1;
+  if (!legal)
+	return 2;
+
+  card_collection_remove_card(&pos->hands[ap], &cid);
+  pos->curr_stich.cs[pos->curr_stich.played_cards++] = cid;
+  if (pos->curr_stich.played_cards < 3)
+	return 0;
+
+  if (stich_get_winner(&pos->gr, &pos->curr_stich, &winnerv))
+	return 1;
+  winner = solver_mod3[pos->curr_stich.vorhand + winnerv];
+  if (winner == pos->alleinspieler) {
+	card_collection won = 0;
+	card_collection_add_card_array(&won, pos->curr_stich.cs, 3);
+	card_collection_get_score(&won, &score);
+	pos->alleinspieler_points += score;
+	pos->alleinspieler_stiche++;
+  }
+  pos->curr_stich =
+		  (stich){.played_cards = 0, .vorhand = winner, .winner = -1};
+  return 0;
+}
+
+static void
+solver_shared_init(solver_shared *const shared,
+				   const solver_limits *const limits) {
+  shared->max_nodes = limits->max_nodes;
+  if (limits->max_millis) {
+	deadline_after_millis(&shared->deadline, limits->max_millis);
+	shared->has_deadline = 1;
+  }
+}
+
+// Stich starts limits->eval_stiche stiche below the root are estimated. The
+// cutoff is part of the key, so the estimates never mix with exact values.
+static int
+solver_search_eval(solver_search *const s, const solver_limits *const limits) {
+  int cards;
+
+  if (!limits->eval_stiche || s->r->null)
+	return 0;
+  cards = __builtin_popcount(s->hands[0] | s->hands[1] | s->hands[2]) / 3
+		  - limits->eval_stiche;
+  // The last stich is played out anyway
+  if (cards < 2)
+	return 0;
+  if (eval_prepare(&s->ev, limits->eval ?: &eval_default_weights, &s->gr,
+				   s->alleinspieler))
+	return 1;
+  s->eval_cards = cards;
+  s->key ^= solver_zobrist_eval[cards];
+  return 0;
+}
+
+int
+solver_solve(solver *sv, const solver_position *pos, solver_result *res) {
+  return solver_solve_limited(sv, pos, NULL, res);
+}
+
+// Lazy SMP: helpers run the same MTD(f) with their own first guess and a
+// perturbed move order, only sharing the transposition table. The caller's
+// thread decides the result and stops the helpers once it is done.
+int
+solver_solve_limited(solver *sv, const solver_position *pos,
+					 const solver_limits *limits, solver_result *res) {
+  solver_worker w[SOLVER_MAX_THREADS];
+  solver_shared shared = {0};
+  int threads = 1, started = 1, lower, upper;
+  uint8_t best = SOLVER_NO_CARD;
+
+  if (solver_search_init(sv, pos, &w[0].s, &w[0].leader, &w[0].played,
+						 w[0].stich))
+	return 1;
+
+  if (limits) {
+	threads = limits->threads < 1 ? 1 : limits->threads;
+	if (threads > SOLVER_MAX_THREADS)
+	  threads = SOLVER_MAX_THREADS;
+	solver_shared_init(&shared, limits);
+	w[0].s.shared = &shared;
+	if (solver_search_eval(&w[0].s, limits))
+	  return 1;
+  }
+
+  lower = 0;
+  upper = solver_search_upper(&w[0].s, w[0].played, w[0].stich);
+
+  for (int t = 1; t < threads; t++) {
+	w[t] = w[0];
+	w[t].s.thread = t;
+	w[t].lower = lower;
+	w[t].upper = upper;
+	w[t].guess = lower + (upper - lower) * t / threads;
+	if (pthread_create(&w[t].thread, NULL, solver_worker_run, &w[t])) {
+	  DERROR_PRINTF("Could not start solver thread %d", t);
+	  break;
+	}
+	started++;
+  }
+
+  solver_mtd(&w[0].s, w[0].leader, w[0].played, w[0].stich, &lower, &upper,
+			 (lower + upper) / 2, &best);
+
+  __atomic_store_n(&shared.stop, 1, __ATOMIC_RELAXED);
+  res->nodes = w[0].s.nodes;
+  for (int t = 1; t < started; t++) {
+	pthread_join(w[t].thread, NULL);
+	res->nodes += w[t].s.nodes;
+  }
+
+  res->complete = lower >= upper;
+  if (w[0].s.r->null) {
+	res->alleinspieler_points = 0;
+	res->alleinspieler_wins = !pos->alleinspieler_stiche && !upper;
+  } else {
+	res->alleinspieler_points = pos->alleinspieler_points + lower;
+	res->alleinspieler_wins = res->alleinspieler_points > 60;
+  }
+  res->best_card = 0;
+  if (best != SOLVER_NO_CARD
+	  && canonical_revert_card(&w[0].s.perm,
+							   card_collection_id_from_index(best),
+							   &res->best_card))
+	return 1;
+  sv->nodes += res->nodes;
+  return 0;
+}
+
+// Whether the alleinspieler ends with at least points card points (or wins
+// the Null game), with one zero window search
+int
+solver_reaches(solver *sv, const solver_position *pos, int points,
+			   int *result) {
+  return solver_reaches_limited(sv, pos, points, NULL, result, NULL);
+}
+
+static int
+solver_reaches_search(solver *sv, const solver_position *pos, int points,
+					  int everyone, const solver_limits *limits, int *result,
+					  int *complete) {
+  solver_search s;
+  solver_shared shared = {0};
+  int leader, played, target, v;
+  uint8_t stich[3];
+
+  if (solver_search_init(sv, pos, &s, &leader, &played, stich))
+	return 1;
+  if (limits) {
+	solver_shared_init(&shared, limits);
+	s.shared = &shared;
+	if (!everyone && solver_search_eval(&s, limits))
+	  return 1;
+  }
+  if (everyone) {
+	s.everyone = everyone;
+	s.key ^= solver_zobrist_everyone[everyone > 0];
+  }
+
+  if (s.r->null) {
+	if (pos->alleinspieler_stiche) {
+	  *result = 0;
+	} else {
+	  v = solver_search_node(&s, leader, played, stich, 0, 1, NULL);
+	  *result = v < 1;
+	}
+  } else {
+	target = points - pos->alleinspieler_points;
+	if (target <= 0)
+	  *result = 1;
+	else if (target > solver_search_upper(&s, played, stich))
+	  *result = 0;
+	else
+	  *result = solver_search_node(&s, leader, played, stich, target - 1,
+								   target, NULL)
+				>= target;
+  }
+
+  if (complete)
+	*complete = !s.aborted;
+  sv->nodes += s.nodes;
+  return 0;
+}
+
+// Single threaded, limits->threads is ignored. *complete is cleared and
+// *result is meaningless if the limits were hit. With limits->eval_stiche
+// the result is an estimate as for solver_solve_limited.
+int
+solver_reaches_limited(solver *sv, const solver_position *pos, int points,
+					   const solver_limits *limits, int *result,
+					   int *complete) {
+  return solver_reaches_search(sv, pos, points, 0, limits, result, complete);
+}
+
+// As solver_reaches_limited, but for some (every == 0) or every (every != 0)
+// way the game can still be played, good or bad
+int
+solver_lines_reach_limited(solver *sv, const solver_position *pos, int points,
+						   int every, const solver_limits *limits, int *result,
+						   int *complete) {
+  return solver_reaches_search(sv, pos, points, every ? -1 : 1, limits, result,
+							   complete);
+}
+
+// Values (as in solver_result: points, or 1 for a won Null game) of every
+// legal card of the player to move
+int
+solver_evaluate_moves(solver *sv, const solver_position *pos, card_id *moves,
+					  int *values, uint8_t *length) {
+  card_collection legal;
+  solver_position next;
+  solver_result res;
+
+  if (solver_position_legal_moves(pos, &legal))
+	return 1;
+
+  *length = 0;
+  for (; legal; legal &= legal - 1) {
+	card_id cid = card_collection_id_from_index(__builtin_ctz(legal));
+	next = *pos;
+	if (solver_position_play(&next, cid))
+	  return 1;
+	if (solver_solve(sv, &next, &res))
+	  return 1;
+	moves[*length] = cid;
+	values[*length] = pos->gr.type == GAME_TYPE_NULL ? res.alleinspieler_wins
+													 : res.alleinspieler_points;
+	(*length)++;
+  }
+  return 0;
+}
@@ -102,6 +102,24 @@ stich_bekennt_any(const game_rules *const gr, const card_id *const first_id,
   return 0;
 }
 
+// Every card that bekennt if first_card was played first
+int
+stich_get_bekennen_mask(const game_rules *const gr,
+						const card_id *const first_card,
+						card_collection *const mask) {
+  card_id cid;
+  card_collection result = 0;
+  for (uint8_t i = 0; i < 32; i++) {
+	if (card_get_id(&(card){.ct = (i & 0b111u) + 1, .cc = (i >> 3u) + 1},
+					&cid))
+	  return 1;
+	if (stich_bekennt(gr, first_card, &cid))
+	  result |= 0b1u << i;
+  }
+  *mask = result;
+  return 0;
+}
+
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "bugprone-branch-clone"
 int
@@ -0,0 +1,647 @@
+#include "skat/tablebase.h"
+#include "skat/solver.h"
+#include "skat/util.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TABLEBASE_MAGIC       "SKATTB\0\2"
+#define TABLEBASE_HEADER_SIZE (64)
+#define TABLEBASE_TT_BITS     (12)
+#define TABLEBASE_MAX_LANES   (5)
+#define TABLEBASE_MAX_SLOTS   (8)
+#define TABLEBASE_NO_CODE     UINT16_MAX
+
+typedef struct {
+  char magic[8];
+  uint32_t type;
+  uint32_t stiche;
+  uint64_t entries;
+} tablebase_header;
+
+// The cards of a lane from the highest down, in runs of neighbours with
+// equal points. Only how many cards of a run are left and who holds them
+// matters, so a lane state packs them to the top of their run.
+typedef struct {
+  uint8_t slots;
+  uint8_t runs;
+  uint8_t run_length[TABLEBASE_MAX_SLOTS];
+} tablebase_lane_type;
+
+typedef struct {
+  const tablebase_lane_type *type;
+  uint8_t cards[TABLEBASE_MAX_SLOTS];// card index by slot
+} tablebase_lane;
+
+// The first fixed lanes keep their place, the others may be exchanged and
+// are ranked as a sorted sequence of their states
+typedef struct {
+  uint8_t fixed;
+  uint8_t lanes;
+  tablebase_lane lane[TABLEBASE_MAX_LANES];
+} tablebase_layout;
+
+static const tablebase_lane_type tablebase_buben = {4, 1, {4}};
+static const tablebase_lane_type tablebase_suit = {7, 5, {1, 1, 1, 1, 3}};
+static const tablebase_lane_type tablebase_null_suit = {8, 1, {8}};
+
+#define TABLEBASE_BUBEN {&tablebase_buben, {31, 23, 15, 7}}
+#define TABLEBASE_SUIT(l) \
+  {&tablebase_suit, \
+   {8 * (l) + 6, 8 * (l) + 5, 8 * (l) + 4, 8 * (l) + 3, 8 * (l) + 2, \
+	8 * (l) + 1, 8 * (l)}}
+#define TABLEBASE_NULL_SUIT(l) \
+  {&tablebase_null_suit, \
+   {8 * (l) + 6, 8 * (l) + 4, 8 * (l) + 3, 8 * (l) + 7, 8 * (l) + 5, \
+	8 * (l) + 2, 8 * (l) + 1, 8 * (l)}}
+
+// Color games are stored with Kreuz as trumpf
+static const tablebase_layout tablebase_layout_color = {
+		2,
+		5,
+		{TABLEBASE_BUBEN, TABLEBASE_SUIT(3), TABLEBASE_SUIT(0),
+		 TABLEBASE_SUIT(1), TABLEBASE_SUIT(2)}};
+static const tablebase_layout tablebase_layout_grand = {
+		1,
+		5,
+		{TABLEBASE_BUBEN, TABLEBASE_SUIT(0), TABLEBASE_SUIT(1),
+		 TABLEBASE_SUIT(2), TABLEBASE_SUIT(3)}};
+static const tablebase_layout tablebase_layout_null = {
+		0,
+		4,
+		{TABLEBASE_NULL_SUIT(0), TABLEBASE_NULL_SUIT(1),
+		 TABLEBASE_NULL_SUIT(2), TABLEBASE_NULL_SUIT(3)}};
+
+// A key has 2 bits per slot: 0 if the card is gone, else 1 + the hand
+// relative to the alleinspieler. Codes number the keys that are states.
+typedef struct {
+  uint16_t *code;      // by key, TABLEBASE_NO_CODE if no state
+  uint16_t *key;       // by code
+  uint8_t (*owners)[3];// cards of every hand by code
+  uint32_t *offset;    // by code, what it takes from a vector
+  uint32_t *bucket;    // codes ordered by their vector
+  uint32_t *bucket_start;
+  uint32_t count;
+} tablebase_states;
+
+// Vectors count the cards still to be spread per hand:
+// v = (a * (stiche + 1) + b) * (stiche + 1) + c
+struct tablebase_index {
+  const tablebase_layout *layout;
+  uint8_t stiche;
+  uint32_t vectors;
+  tablebase_states states[TABLEBASE_MAX_LANES];// by fixed lane, then the rest
+  // by lane, [code * vectors + v]: positions in which the lane takes a
+  // smaller code, with v cards to spread from it on
+  uint64_t *below[TABLEBASE_MAX_LANES];
+  uint64_t per_leader;
+};
+
+static int
+tablebase_value_bits(const game_type type) {
+  return type == GAME_TYPE_NULL ? 1 : 8;
+}
+
+static const tablebase_states *
+tablebase_lane_states(const tablebase_index *ix, uint8_t lane) {
+  return &ix->states[lane < ix->layout->fixed ? lane : ix->layout->fixed];
+}
+
+static int
+tablebase_vector_covers(const tablebase_index *ix, uint32_t v,
+						const uint8_t owners[3]) {
+  const uint32_t k = ix->stiche + 1;
+  return v / (k * k) >= owners[0] && v / k % k >= owners[1]
+		 && v % k >= owners[2];
+}
+
+static int
+tablebase_states_build(tablebase_states *st, const tablebase_lane_type *t,
+					   uint8_t stiche) {
+  const uint32_t keys = 1u << (2 * t->slots), k = stiche + 1;
+  const uint32_t vectors = k * k * k;
+  uint8_t owners[3], slot, digit;
+  int valid, gap;
+
+  memset(st, '\0', sizeof(*st));
+  st->code = malloc(keys * sizeof(*st->code));
+  st->key = malloc(keys * sizeof(*st->key));
+  st->owners = malloc(keys * sizeof(*st->owners));
+  st->offset = malloc(keys * sizeof(*st->offset));
+  st->bucket = malloc(keys * sizeof(*st->bucket));
+  st->bucket_start = calloc(vectors + 1, sizeof(*st->bucket_start));
+  if (!st->code || !st->key || !st->owners || !st->offset || !st->bucket
+	  || !st->bucket_start)
+	return 1;
+
+  for (uint32_t key = 0; key < keys; key++) {
+	memset(owners, '\0', sizeof(owners));
+	valid = 1;
+	slot = 0;
+	for (uint8_t r = 0; r < t->runs; r++) {
+	  gap = 0;
+	  for (uint8_t i = 0; i < t->run_length[r]; i++, slot++) {
+		digit = (key >> (2 * slot)) & 0b11u;
+		if (!digit)
+		  gap = 1;
+		else if (gap)
+		  valid = 0;
+		else
+		  owners[digit - 1]++;
+	  }
+	}
+	st->code[key] = TABLEBASE_NO_CODE;
+	if (!valid || owners[0] > stiche || owners[1] > stiche
+		|| owners[2] > stiche)
+	  continue;
+	st->code[key] = st->count;
+	st->key[st->count] = key;
+	memcpy(st->owners[st->count], owners, sizeof(owners));
+	st->offset[st->count] = (owners[0] * k + owners[1]) * k + owners[2];
+	st->count++;
+  }
+
+  for (uint32_t v = 0, n = 0; v < vectors; v++) {
+	st->bucket_start[v] = n;
+	for (uint32_t c = 0; c < st->count; c++)
+	  if (st->offset[c] == v)
+		st->bucket[n++] = c;
+	st->bucket_start[v + 1] = n;
+  }
+  return 0;
+}
+
+static void
+tablebase_states_free(tablebase_states *st) {
+  free(st->code);
+  free(st->key);
+  free(st->owners);
+  free(st->offset);
+  free(st->bucket);
+  free(st->bucket_start);
+}
+
+static void
+tablebase_index_free(tablebase_index *ix) {
+  if (!ix)
+	return;
+  for (int i = 0; i < TABLEBASE_MAX_LANES; i++) {
+	tablebase_states_free(&ix->states[i]);
+	free(ix->below[i]);
+  }
+  free(ix);
+}
+
+// Positions from lane on, with every code allowed in it
+static uint64_t
+tablebase_rest(const tablebase_index *ix, uint8_t lane, uint32_t v) {
+  if (lane == ix->layout->lanes)
+	return v == 0;
+  return ix->below[lane][tablebase_lane_states(ix, lane)->count * ix->vectors
+						 + v];
+}
+
+// The exchangeable lanes count sorted sequences: with f[c][v] the sequences
+// of the lanes after this one whose codes are all at least c,
+// below[c + 1][v] = below[c][v] + f[c][v - vector(c)].
+static int
+tablebase_index_build(game_type type, uint8_t stiche, tablebase_index **out) {
+  tablebase_index *ix;
+  const tablebase_layout *layout;
+  const tablebase_states *st;
+  uint64_t *f = NULL, *next = NULL, *tmp;
+  uint32_t k = stiche + 1, count;
+
+  switch (type) {
+	case GAME_TYPE_COLOR:
+	  layout = &tablebase_layout_color;
+	  break;
+	case GAME_TYPE_GRAND:
+	  layout = &tablebase_layout_grand;
+	  break;
+	case GAME_TYPE_NULL:
+	  layout = &tablebase_layout_null;
+	  break;
+	default:
+	  return 1;
+  }
+  if (stiche < 1 || stiche > TABLEBASE_MAX_STICHE
+	  || !(ix = calloc(1, sizeof(*ix))))
+	return 1;
+  ix->layout = layout;
+  ix->stiche = stiche;
+  ix->vectors = k * k * k;
+
+  for (uint8_t i = 0; i <= layout->fixed && i < layout->lanes; i++)
+	if (tablebase_states_build(&ix->states[i], layout->lane[i].type, stiche))
+	  goto fail;
+
+  count = ix->states[layout->fixed].count;
+  if (layout->fixed < layout->lanes
+	  && (!(f = malloc((count + 1) * ix->vectors * sizeof(*f)))
+		  || !(next = malloc((count + 1) * ix->vectors * sizeof(*next)))))
+	goto fail;
+  // Nothing left after the last lane
+  for (uint32_t c = 0; next && c <= count; c++)
+	for (uint32_t v = 0; v < ix->vectors; v++)
+	  next[c * ix->vectors + v] = v == 0;
+
+  for (uint8_t lane = layout->lanes; lane-- > 0;) {
+	st = tablebase_lane_states(ix, lane);
+	uint64_t *below = ix->below[lane] =
+			malloc((st->count + 1) * ix->vectors * sizeof(*below));
+	if (!below)
+	  goto fail;
+
+	for (uint32_t v = 0; v < ix->vectors; v++)
+	  below[v] = 0;
+	for (uint32_t c = 0; c < st->count; c++) {
+	  for (uint32_t v = 0; v < ix->vectors; v++) {
+		uint64_t n = 0;
+		if (tablebase_vector_covers(ix, v, st->owners[c])) {
+		  if (lane >= layout->fixed)
+			n = next[c * ix->vectors + v - st->offset[c]];
+		  else
+			n = tablebase_rest(ix, lane + 1, v - st->offset[c]);
+		}
+		below[(c + 1) * ix->vectors + v] = below[c * ix->vectors + v] + n;
+	  }
+	}
+
+	if (lane < layout->fixed)
+	  continue;
+	// f of this lane, for the one before it
+	for (uint32_t v = 0; v < ix->vectors; v++)
+	  f[count * ix->vectors + v] = 0;
+	for (uint32_t c = count; c-- > 0;)
+	  for (uint32_t v = 0; v < ix->vectors; v++)
+		f[c * ix->vectors + v] = f[(c + 1) * ix->vectors + v]
+								 + below[(c + 1) * ix->vectors + v]
+								 - below[c * ix->vectors + v];
+	tmp = next;
+	next = f;
+	f = tmp;
+  }
+
+  ix->per_leader = tablebase_rest(ix, 0, ix->vectors - 1);
+  free(f);
+  free(next);
+  *out = ix;
+  return 0;
+
+fail:
+  free(f);
+  free(next);
+  tablebase_index_free(ix);
+  return 2;
+}
+
+static uint16_t
+tablebase_lane_key(const tablebase_lane *l, const card_collection rel[3]) {
+  uint16_t key = 0, digit;
+  uint8_t slot = 0, top;
+
+  for (uint8_t r = 0; r < l->type->runs; r++) {
+	top = slot;
+	for (uint8_t i = 0; i < l->type->run_length[r]; i++, slot++) {
+	  card_collection bit = 0b1u << l->cards[slot];
+	  digit = rel[0] & bit ? 1 : rel[1] & bit ? 2 : rel[2] & bit ? 3 : 0;
+	  if (digit)
+		key |= digit << (2 * top++);
+	}
+  }
+  return key;
+}
+
+// hands relative to the alleinspieler, stiche cards each
+static int
+tablebase_rank(const tablebase_index *ix, const card_collection rel[3],
+			   int leader, uint64_t *index) {
+  const tablebase_layout *layout = ix->layout;
+  uint16_t codes[TABLEBASE_MAX_LANES], code;
+  uint32_t v = ix->vectors - 1, prev = 0;
+
+  for (uint8_t lane = 0; lane < layout->lanes; lane++) {
+	code = tablebase_lane_states(ix, lane)
+				   ->code[tablebase_lane_key(&layout->lane[lane], rel)];
+	if (code == TABLEBASE_NO_CODE)
+	  return 1;
+	// Exchangeable lanes in ascending order
+	uint8_t i = lane;
+	for (; i > layout->fixed && codes[i - 1] > code; i--)
+	  codes[i] = codes[i - 1];
+	codes[i] = code;
+  }
+
+  *index = leader * ix->per_leader;
+  for (uint8_t lane = 0; lane < layout->lanes; lane++) {
+	const tablebase_states *st = tablebase_lane_states(ix, lane);
+	*index += ix->below[lane][codes[lane] * ix->vectors + v];
+	if (lane >= layout->fixed) {
+	  *index -= ix->below[lane][prev * ix->vectors + v];
+	  prev = codes[lane];
+	}
+	v -= st->offset[codes[lane]];
+  }
+  return 0;
+}
+
+int
+tablebase_entries(game_type type, uint8_t stiche, uint64_t *entries) {
+  tablebase_index *ix;
+  if (tablebase_index_build(type, stiche, &ix))
+	return 1;
+  *entries = 3 * ix->per_leader;
+  tablebase_index_free(ix);
+  return 0;
+}
+
+typedef struct {
+  const tablebase_index *ix;
+  game_type type;
+  uint8_t *values;
+  uint32_t *next_job;
+  uint32_t first_codes;
+  uint64_t solved;
+  int error;
+  pthread_t thread;
+} tablebase_job;
+
+typedef struct {
+  tablebase_job *job;
+  solver sv;
+  solver_position pos;
+} tablebase_walk;
+
+static void
+tablebase_solve(tablebase_walk *w) {
+  tablebase_job *job = w->job;
+  solver_result res;
+  uint64_t i;
+
+  if (tablebase_rank(job->ix, w->pos.hands, w->pos.curr_stich.vorhand, &i)
+	  || solver_solve(&w->sv, &w->pos, &res)) {
+	job->error = 1;
+	return;
+  }
+  if (job->type == GAME_TYPE_NULL) {
+	// Neighbouring entries are written by other threads
+	if (!res.alleinspieler_wins)
+	  __atomic_fetch_or(&job->values[i >> 3u], 0b1u << (i & 0b111u),
+						__ATOMIC_RELAXED);
+  } else {
+	job->values[i] = res.alleinspieler_points;
+  }
+  job->solved++;
+}
+
+// Every state of the lanes from lane on that spreads exactly v cards
+static void
+tablebase_walk_lanes(tablebase_walk *w, uint8_t lane, uint32_t v,
+					 uint32_t min) {
+  const tablebase_index *ix = w->job->ix;
+  const tablebase_lane *l = &ix->layout->lane[lane];
+  const tablebase_states *st = tablebase_lane_states(ix, lane);
+  const uint64_t *below = ix->below[lane];
+  card_collection saved[3];
+
+  if (lane == ix->layout->lanes) {
+	tablebase_solve(w);
+	return;
+  }
+  memcpy(saved, w->pos.hands, sizeof(saved));
+
+  // The last lane takes everything that is left
+  for (uint32_t b = lane + 1 == ix->layout->lanes ? v : 0;
+	   b < ix->vectors && !w->job->error; b++) {
+	for (uint32_t j = st->bucket_start[b]; j < st->bucket_start[b + 1]; j++) {
+	  uint32_t c = st->bucket[j];
+	  if (c < min || !tablebase_vector_covers(ix, v, st->owners[c])
+		  || below[(c + 1) * ix->vectors + v] == below[c * ix->vectors + v])
+		continue;
+	  for (uint8_t slot = 0; slot < l->type->slots; slot++) {
+		uint8_t digit = (st->key[c] >> (2 * slot)) & 0b11u;
+		if (digit)
+		  w->pos.hands[digit - 1] |= 0b1u << l->cards[slot];
+	  }
+	  tablebase_walk_lanes(w, lane + 1, v - st->offset[c],
+						   lane >= ix->layout->fixed ? c : 0);
+	  memcpy(w->pos.hands, saved, sizeof(saved));
+	}
+  }
+}
+
+// Jobs are a leader and a state of the first lane
+static void *
+tablebase_generate_jobs(void *args) {
+  tablebase_job *job = args;
+  tablebase_walk w = {.job = job};
+  uint32_t next;
+
+  if (solver_init(&w.sv, TABLEBASE_TT_BITS)) {
+	job->error = 1;
+	return NULL;
+  }
+  w.pos.gr.type = job->type;
+  w.pos.gr.trumpf = job->type == GAME_TYPE_COLOR ? COLOR_KREUZ : COLOR_INVALID;
+  w.pos.alleinspieler = 0;
+
+  while (!job->error
+		 && (next = __atomic_fetch_add(job->next_job, 1, __ATOMIC_RELAXED))
+					< 3 * job->first_codes) {
+	const tablebase_index *ix = job->ix;
+	const tablebase_states *st = tablebase_lane_states(ix, 0);
+	uint32_t c = next % job->first_codes, v = ix->vectors - 1;
+
+	if (ix->below[0][(c + 1) * ix->vectors + v]
+		== ix->below[0][c * ix->vectors + v])
+	  continue;
+	memset(w.pos.hands, '\0', sizeof(w.pos.hands));
+	w.pos.curr_stich =
+			(stich){.played_cards = 0, .vorhand = next / job->first_codes,
+					.winner = -1};
+	for (uint8_t slot = 0; slot < ix->layout->lane[0].type->slots; slot++) {
+	  uint8_t digit = (st->key[c] >> (2 * slot)) & 0b11u;
+	  if (digit)
+		w.pos.hands[digit - 1] |= 0b1u << ix->layout->lane[0].cards[slot];
+	}
+	tablebase_walk_lanes(&w, 1, v - st->offset[c], ix->layout->fixed ? 0 : c);
+  }
+
+  solver_free(&w.sv);
+  return NULL;
+}
+
+int
+tablebase_generate(const char *path, game_type type, uint8_t stiche,
+				   int threads) {
+  tablebase_index *ix;
+  uint64_t entries, solved = 0;
+  size_t length;
+  int fd, error = 0, started = 0;
+  uint32_t next_job = 0;
+  uint8_t *map;
+  tablebase_job jobs[TABLEBASE_MAX_THREADS];
+
+  if (tablebase_index_build(type, stiche, &ix))
+	return 1;
+  entries = 3 * ix->per_leader;
+  if (threads < 1)
+	threads = 1;
+  if (threads > TABLEBASE_MAX_THREADS)
+	threads = TABLEBASE_MAX_THREADS;
+
+  length = TABLEBASE_HEADER_SIZE
+		   + (entries * tablebase_value_bits(type) + 7) / 8;
+
+  fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1 || ftruncate(fd, (off_t) length)) {
+	if (fd != -1)
+	  close(fd);
+	tablebase_index_free(ix);
+	return 2;
+  }
+  map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+	tablebase_index_free(ix);
+	return 2;
+  }
+
+  tablebase_header hdr = {.type = type, .stiche = stiche, .entries = entries};
+  memcpy(hdr.magic, TABLEBASE_MAGIC, sizeof(hdr.magic));
+  memcpy(map, &hdr, sizeof(hdr));
+
+  for (int t = 0; t < threads; t++) {
+	jobs[t] = (tablebase_job){
+			.ix = ix,
+			.type = type,
+			.values = map + TABLEBASE_HEADER_SIZE,
+			.next_job = &next_job,
+			.first_codes = tablebase_lane_states(ix, 0)->count};
+	if (pthread_create(&jobs[t].thread, NULL, tablebase_generate_jobs,
+					   &jobs[t])) {
+	  error = 3;
+	  break;
+	}
+	started++;
+  }
+
+  for (int t = 0; t < started; t++) {
+	pthread_join(jobs[t].thread, NULL);
+	solved += jobs[t].solved;
+	if (jobs[t].error)
+	  error = 3;
+  }
+  // Every entry is reached exactly once
+  if (!error && solved != entries) {
+	DERROR_PRINTF("Solved %llu of %llu tablebase entries",
+				  (unsigned long long) solved, (unsigned long long) entries);
+	error = 3;
+  }
+
+  if (msync(map, length, MS_SYNC))
+	error = 2;
+  munmap(map, length);
+  tablebase_index_free(ix);
+  return error;
+}
+
+int
+tablebase_open(tablebase *tb, const char *path) {
+  struct stat st;
+  tablebase_header hdr;
+  int fd;
+
+  memset(tb, '\0', sizeof(*tb));
+  fd = open(path, O_RDONLY);
+  if (fd == -1)
+	return 1;
+  if (fstat(fd, &st) || (size_t) st.st_size < TABLEBASE_HEADER_SIZE) {
+	close(fd);
+	return 2;
+  }
+
+  tb->map_length = st.st_size;
+  tb->map = mmap(NULL, tb->map_length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (tb->map == MAP_FAILED) {
+	tb->map = NULL;
+	return 1;
+  }
+
+  memcpy(&hdr, tb->map, sizeof(hdr));
+  if (memcmp(hdr.magic, TABLEBASE_MAGIC, sizeof(hdr.magic))
+	  || tablebase_index_build(hdr.type, hdr.stiche, &tb->index)
+	  || hdr.entries != 3 * tb->index->per_leader
+	  || tb->map_length < TABLEBASE_HEADER_SIZE
+								 + (hdr.entries * tablebase_value_bits(hdr.type)
+									+ 7) / 8) {
+	DERROR_PRINTF("'%s' is not a valid tablebase", path);
+	tablebase_close(tb);
+	return 2;
+  }
+
+  // Lookups jump around, read ahead would only waste page cache
+  madvise(tb->map, tb->map_length, MADV_RANDOM);
+
+  tb->type = hdr.type;
+  tb->stiche = hdr.stiche;
+  tb->entries = hdr.entries;
+  tb->values = (const uint8_t *) tb->map + TABLEBASE_HEADER_SIZE;
+  return 0;
+}
+
+void
+tablebase_close(tablebase *tb) {
+  if (tb->map)
+	munmap(tb->map, tb->map_length);
+  tablebase_index_free(tb->index);
+  tb->map = NULL;
+  tb->values = NULL;
+  tb->index = NULL;
+}
+
+// Non trumpf cards of lane a and b swap places, Buben stay
+static card_collection
+tablebase_swap_lanes(const card_collection col, const int a, const int b) {
+  if (a == b)
+	return col;
+  card_collection mask_a = 0x7fu << (8 * a), mask_b = 0x7fu << (8 * b);
+  card_collection lane_a = (col & mask_a) >> (8 * a);
+  card_collection lane_b = (col & mask_b) >> (8 * b);
+  return (col & ~(mask_a | mask_b)) | (lane_a << (8 * b)) | (lane_b << (8 * a));
+}
+
+int
+tablebase_lookup(const tablebase *tb, const game_rules *gr,
+				 const card_collection hands[3], int alleinspieler, int leader,
+				 int *value) {
+  card_collection rel[3];
+  uint64_t index;
+
+  if (gr->type != tb->type || alleinspieler < 0 || alleinspieler > 2
+	  || leader < 0 || leader > 2)
+	return 1;
+
+  for (int i = 0; i < 3; i++) {
+	rel[i] = hands[(alleinspieler + i) % 3];
+	if (__builtin_popcount(rel[i]) != tb->stiche)
+	  return 1;
+	if (gr->type == GAME_TYPE_COLOR)
+	  rel[i] = tablebase_swap_lanes(rel[i], gr->trumpf - COLOR_KARO,
+									COLOR_KREUZ - COLOR_KARO);
+  }
+
+  if (tablebase_rank(tb->index, rel, (leader - alleinspieler + 3) % 3, &index))
+	return 1;
+  if (tb->type == GAME_TYPE_NULL)
+	*value = (tb->values[index >> 3u] >> (index & 0b111u)) & 0b1u;
+  else
+	*value = tb->values[index];
+  return 0;
+}
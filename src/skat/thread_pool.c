@@ -0,0 +1,71 @@
+#include "skat/thread_pool.h"
+#include "skat/util.h"
+#include <string.h>
+
+static void *
+thread_pool_worker(void *args) {
+  thread_pool *tp = args;
+  async_callback acb;
+
+  for (;;) {
+	dequeue_async_callback_blocking(&tp->q, &acb);
+	// A callback without function asks one worker to exit
+	if (!acb.do_stuff)
+	  return NULL;
+	acb.do_stuff(acb.data);
+
+	pthread_mutex_lock(&tp->lock);
+	if (!--tp->pending)
+	  pthread_cond_broadcast(&tp->idle);
+	pthread_mutex_unlock(&tp->lock);
+  }
+}
+
+int
+thread_pool_init(thread_pool *tp, int threads, const char *name) {
+  if (threads < 1 || threads > THREAD_POOL_MAX_THREADS)
+	return 1;
+
+  memset(tp, '\0', sizeof(*tp));
+  init_async_callback_queue(&tp->q);
+  pthread_mutex_init(&tp->lock, NULL);
+  pthread_cond_init(&tp->idle, NULL);
+
+  for (int t = 0; t < threads; t++) {
+	if (pthread_create(&tp->threads[t], NULL, thread_pool_worker, tp)) {
+	  DERROR_PRINTF("Could not start worker %d of thread pool '%s'", t, name);
+	  thread_pool_free(tp);
+	  return 2;
+	}
+	thread_set_name(tp->threads[t], "%s_%d", name, t);
+	tp->thread_count++;
+  }
+  return 0;
+}
+
+void
+thread_pool_free(thread_pool *tp) {
+  async_callback stop = {.do_stuff = NULL, .data = NULL};
+  for (int t = 0; t < tp->thread_count; t++)
+	enqueue_async_callback(&tp->q, &stop);
+  for (int t = 0; t < tp->thread_count; t++)
+	pthread_join(tp->threads[t], NULL);
+  tp->thread_count = 0;
+  clear_async_callback_queue(&tp->q);
+}
+
+void
+thread_pool_submit(thread_pool *tp, async_callback *cb) {
+  pthread_mutex_lock(&tp->lock);
+  tp->pending++;
+  pthread_mutex_unlock(&tp->lock);
+  enqueue_async_callback(&tp->q, cb);
+}
+
+void
+thread_pool_wait(thread_pool *tp) {
+  pthread_mutex_lock(&tp->lock);
+  while (tp->pending)
+	pthread_cond_wait(&tp->idle, &tp->lock);
+  pthread_mutex_unlock(&tp->lock);
+}
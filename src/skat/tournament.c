@@ -0,0 +1,298 @@
+#include "skat/tournament.h"
+#include "skat/rng.h"
+#include "skat/server.h"
+#include "skat/thread_pool.h"
+#include "skat/util.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Seats of the headless servers, the names only live at the table
+static const char *const tournament_seat_names[3] = {"Seat 1", "Seat 2",
+													 "Seat 3"};
+
+typedef struct tournament_result {
+  int player;
+  int points;
+} tournament_result;
+
+typedef struct tournament_series {
+  tournament *t;
+  uint32_t series;
+  int *draw;// player indices, three per table
+  int tables;
+  int jobs;// tables, three rotations of each in duplicate mode
+  int next_job;
+  // Duplicate mode only
+  tournament_result *results;// by job, game and active player
+  int64_t *hand_points;      // sums by game and active player
+} tournament_series;
+
+// A worker plays one table at a time with one bot per seat and engine, as a
+// bot keeps the plans of its seat between decisions
+typedef struct tournament_worker {
+  tournament_series *ts;
+  bot *bots[3][TOURNAMENT_MAX_ENGINES];
+  int error;
+} tournament_worker;
+
+void
+tournament_score(const round_result *rr, int alleinspieler, int points[3]) {
+  memset(points, '\0', 3 * sizeof(*points));
+  if (alleinspieler < 0 || alleinspieler > 2)
+	return;
+
+  if (rr->round_winner == alleinspieler) {
+	points[alleinspieler] =
+			rr->round_score[alleinspieler] + TOURNAMENT_GAME_POINTS;
+	return;
+  }
+  points[alleinspieler] =
+		  rr->round_score[alleinspieler] - TOURNAMENT_GAME_POINTS;
+  for (int ap = 0; ap < 3; ap++)
+	if (ap != alleinspieler)
+	  points[ap] = TOURNAMENT_LOSS_POINTS;
+}
+
+static int
+tournament_worker_bot(tournament_worker *const w, const int seat,
+					  const int engine, bot **const b) {
+  const tournament_config *conf = w->ts->t->conf;
+  bot_config bc;
+
+  if (seat < 0 || seat > 2 || engine < 0 || engine >= conf->engine_count)
+	return 1;
+  if (!w->bots[seat][engine]) {
+	bot *nb = malloc(sizeof(*nb));
+	bc = conf->engines[engine];
+	// Seeded bots must not all draw the same deals
+	if (bc.seed)
+	  bc.seed += seat;
+	if (!nb || bot_init(nb, &bc)) {
+	  free(nb);
+	  return 1;
+	}
+	w->bots[seat][engine] = nb;
+  }
+  *b = w->bots[seat][engine];
+  return 0;
+}
+
+static void
+tournament_record(tournament_series *const ts, const int job,
+				  const int *const seats, const skat_server_state *const ss) {
+  tournament *t = ts->t;
+  const int as = ss->sgs.alleinspieler;
+  const uint32_t game = ss->rounds_finished - 1;
+  int points[3], player;
+
+  tournament_score(&ss->result, as, points);
+  for (int ap = 0; ap < 3; ap++) {
+	player = seats[ss->sgs.active_players[ap]];
+	tournament_player *pl = &t->players[player];
+	// Every copy of a deal hands it out by active player
+	if (ts->results) {
+	  ts->results[((size_t) job * t->conf->games + game) * 3 + ap] =
+			  (tournament_result){.player = player, .points = points[ap]};
+	  __atomic_add_fetch(&ts->hand_points[game * 3 + ap], points[ap],
+						 __ATOMIC_RELAXED);
+	}
+	__atomic_add_fetch(&pl->points, points[ap], __ATOMIC_RELAXED);
+	__atomic_add_fetch(&pl->games, 1, __ATOMIC_RELAXED);
+	if (ap != as)
+	  continue;
+	if (ss->result.round_winner == as)
+	  __atomic_add_fetch(&pl->won, 1, __ATOMIC_RELAXED);
+	else
+	  __atomic_add_fetch(&pl->lost, 1, __ATOMIC_RELAXED);
+  }
+}
+
+static int
+tournament_play_table(tournament_worker *const w, const int job) {
+  tournament *t = w->ts->t;
+  const int duplicate = t->conf->duplicate;
+  const int table = duplicate ? job / 3 : job;
+  int seats[3];// by gupid
+  bot *bots[4] = {NULL};
+  uint64_t deal_seed = t->conf->seed ^ ((w->ts->series + 1ull) << 32u);
+  uint32_t done;
+  server *s;
+  int error = 0;
+
+  for (int i = 0; i < 3; i++)
+	seats[i] = w->ts->draw[3 * table + (i + (duplicate ? job % 3 : 0)) % 3];
+  // Duplicate tables share the deals of the series
+  if (!duplicate)
+	deal_seed ^= (table + 1ull) * 0x9e3779b97f4a7c15ull;
+
+  if (!(s = malloc(sizeof(*s))))
+	return 1;
+  server_init_headless(s);
+  server_skat_state_seed_deals(&s->ss, deal_seed);
+
+  for (int i = 0; i < 3 && !error; i++)
+	error = tournament_worker_bot(w, i, t->players[seats[i]].engine,
+								  &bots[i])
+			|| server_bots_add(s, tournament_seat_names[i]);
+
+  while (!error && s->ss.rounds_finished < t->conf->games) {
+	done = s->ss.rounds_finished;
+	error = server_bots_step(s, bots);
+	if (!error && s->ss.rounds_finished != done)
+	  tournament_record(w->ts, job, seats, &s->ss);
+  }
+
+  server_free_headless(s);
+  free(s);
+  return error;
+}
+
+static void
+tournament_worker_run(void *args) {
+  tournament_worker *w = args;
+  int job;
+
+  while ((job = __atomic_fetch_add(&w->ts->next_job, 1, __ATOMIC_RELAXED))
+		 < w->ts->jobs) {
+	if (tournament_play_table(w, job)) {
+	  DERROR_PRINTF("Table %d of series %u failed", job, w->ts->series + 1);
+	  w->error = 1;
+	}
+  }
+}
+
+// One pass over the results once every table of the series is done, each
+// play of a hand against the mean of all its plays
+static void
+tournament_compare_hands(tournament_series *const ts) {
+  const tournament_config *conf = ts->t->conf;
+  const size_t plays = (size_t) ts->jobs * conf->games * 3;
+  const size_t per_deal = (size_t) conf->games * 3;
+  const tournament_result *r;
+
+  for (size_t i = 0; i < plays; i++) {
+	r = &ts->results[i];
+	ts->t->players[r->player].duplicate +=
+			r->points - (double) ts->hand_points[i % per_deal] / ts->jobs;
+  }
+}
+
+static int
+tournament_compare(const void *a, const void *b) {
+  const tournament_player *pa = *(tournament_player *const *) a;
+  const tournament_player *pb = *(tournament_player *const *) b;
+  if (pa->points != pb->points)
+	return pa->points > pb->points ? -1 : 1;
+  return strcmp(pa->name, pb->name);
+}
+
+static int
+tournament_compare_duplicate(const void *a, const void *b) {
+  const tournament_player *pa = *(tournament_player *const *) a;
+  const tournament_player *pb = *(tournament_player *const *) b;
+  if (pa->duplicate != pb->duplicate)
+	return pa->duplicate > pb->duplicate ? -1 : 1;
+  return tournament_compare(a, b);
+}
+
+void
+tournament_print_standings(const tournament *t, FILE *out) {
+  const tournament_player **sorted;
+
+  if (!(sorted = malloc(t->player_count * sizeof(*sorted))))
+	return;
+  for (int i = 0; i < t->player_count; i++)
+	sorted[i] = &t->players[i];
+  qsort(sorted, t->player_count, sizeof(*sorted),
+		t->conf->duplicate ? tournament_compare_duplicate
+						   : tournament_compare);
+
+  fprintf(out, "#  rank name                 points games  won lost%s\n",
+		  t->conf->duplicate ? " duplicate" : "");
+  for (int i = 0; i < t->player_count; i++) {
+	fprintf(out, "%6d %-20s %7" PRId64 " %5u %4u %4u", i + 1, sorted[i]->name,
+			sorted[i]->points, sorted[i]->games, sorted[i]->won,
+			sorted[i]->lost);
+	if (t->conf->duplicate)
+	  fprintf(out, " %9.1f", sorted[i]->duplicate);
+	fprintf(out, "\n");
+  }
+  fflush(out);
+  free(sorted);
+}
+
+int
+tournament_run(tournament *t, FILE *out) {
+  const tournament_config *conf = t->conf;
+  tournament_worker workers[THREAD_POOL_MAX_THREADS];
+  tournament_series ts = {.t = t};
+  thread_pool tp;
+  rng r;
+  int error = 0;
+
+  if (t->player_count < 3 || t->player_count % 3
+	  || t->player_count > TOURNAMENT_MAX_PLAYERS || conf->threads < 1
+	  || conf->threads > THREAD_POOL_MAX_THREADS || !conf->games)
+	return 1;
+  ts.tables = t->player_count / 3;
+  ts.jobs = conf->duplicate ? 3 * ts.tables : ts.tables;
+  ts.draw = malloc(t->player_count * sizeof(*ts.draw));
+  if (conf->duplicate) {
+	ts.results = malloc((size_t) ts.jobs * conf->games * 3
+						* sizeof(*ts.results));
+	ts.hand_points = malloc((size_t) conf->games * 3 * sizeof(*ts.hand_points));
+  }
+  if (!ts.draw || (conf->duplicate && (!ts.results || !ts.hand_points))
+	  || thread_pool_init(&tp, conf->threads, "tournament")) {
+	free(ts.draw);
+	free(ts.results);
+	free(ts.hand_points);
+	return 2;
+  }
+
+  memset(workers, '\0', sizeof(workers));
+  for (ts.series = 0; ts.series < conf->series && !error; ts.series++) {
+	// A new draw of the tables every series
+	rng_seed(&r, conf->seed ^ ((ts.series + 1ull) * 0x9e3779b97f4a7c15ull));
+	for (int i = 0; i < t->player_count; i++)
+	  ts.draw[i] = i;
+	for (int i = t->player_count - 1; i > 0; i--) {
+	  int j = (int) rng_bounded_u32(&r, i + 1), tmp = ts.draw[i];
+	  ts.draw[i] = ts.draw[j];
+	  ts.draw[j] = tmp;
+	}
+	ts.next_job = 0;
+	if (ts.hand_points)
+	  memset(ts.hand_points, '\0', conf->games * 3 * sizeof(*ts.hand_points));
+
+	for (int i = 0; i < conf->threads; i++) {
+	  workers[i].ts = &ts;
+	  thread_pool_submit(&tp, &(async_callback){
+											 .do_stuff = tournament_worker_run,
+											 .data = &workers[i]});
+	}
+	thread_pool_wait(&tp);
+	for (int i = 0; i < conf->threads; i++)
+	  error |= workers[i].error;
+	if (conf->duplicate && !error)
+	  tournament_compare_hands(&ts);
+
+	fprintf(out, "# standings after series %u of %u\n", ts.series + 1,
+			conf->series);
+	tournament_print_standings(t, out);
+  }
+  thread_pool_free(&tp);
+
+  for (int i = 0; i < conf->threads; i++)
+	for (int seat = 0; seat < 3; seat++)
+	  for (int e = 0; e < TOURNAMENT_MAX_ENGINES; e++)
+		if (workers[i].bots[seat][e]) {
+		  bot_free(workers[i].bots[seat][e]);
+		  free(workers[i].bots[seat][e]);
+		}
+  free(ts.draw);
+  free(ts.results);
+  free(ts.hand_points);
+  return error ? 3 : 0;
+}
@@ -1,12 +1,13 @@
 #include "skat/util.h"
+#include "skat/rng.h"
 #include <errno.h>
-#include <fcntl.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifdef HAS_DEBUG_PRINTF
@@ -23,28 +24,9 @@ ceil_div(int n, int z) {
   return (n + z - 1) / z;
 }
 
-static int
-get_random_fd() {
-  static int random_fd = -1;
-
-  if (random_fd == -1) {
-	DEBUG_PRINTF("Opening '/dev/urandom'");
-	random_fd = open("/dev/urandom", O_RDONLY);
-	if (random_fd == -1) {
-	  perror("Error while accessing '/dev/urandom'");
-	  exit(EXIT_FAILURE);
-	}
-  }
-
-  return random_fd;
-}
-
 size_t
 util_rand_int(const size_t min, const size_t max) {
-  size_t random;
-  read(get_random_fd(), &random, sizeof(size_t));
-
-  return (random % (max - min)) + min;
+  return rng_bounded_u64(rng_thread(), max - min) + min;
 }
 
 size_t
@@ -69,6 +51,25 @@ perm(int *a, int size, int mask) {
   memcpy(a, r, size * sizeof(int));
 }
 
+void
+deadline_after_millis(struct timespec *const deadline, const uint64_t millis) {
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+  deadline->tv_sec += millis / 1000;
+  deadline->tv_nsec += (millis % 1000) * 1000000L;
+  if (deadline->tv_nsec >= 1000000000L) {
+	deadline->tv_sec++;
+	deadline->tv_nsec -= 1000000000L;
+  }
+}
+
+int64_t
+deadline_millis_left(const struct timespec *const deadline) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (deadline->tv_sec - now.tv_sec) * 1000
+		 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+}
+
 int
 thread_get_name(pthread_t t, char *name_buffer) {
   return pthread_getname_np(t, name_buffer, THREAD_NAME_SIZE);
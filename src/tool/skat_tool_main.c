@@ -0,0 +1,554 @@
+#include "conf.h"
+#include "skat/analysis.h"
+#include "skat/eval.h"
+#include "skat/matchmaking.h"
+#include "skat/rating.h"
+#include "skat/rng.h"
+#include "skat/tablebase.h"
+#include "skat/thread_pool.h"
+#include "skat/tournament.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void
+print_usage(const char *const name) {
+  printf("Usage: %s command [options]\n"
+		 "Commands:\n"
+		 "  tablebase [-g color|grand|null] [-n stiche] [-j threads] -o file\n"
+		 "  analyze [-j threads] [-n samples] [-s seed] [archive]\n"
+		 "  eval-train [-j threads] [-n games] [-s seed] -o file\n"
+		 "  tournament [-j threads] [-r series] [-g games] [-s seed] "
+		 "[-t millis] [-d] [-T file]... name[:stiche[:samples]]...\n"
+		 "  matchmaking [-n players] [-a arrivals per second] [-s seed]\n"
+		 "  ratings [-j threads] [-k top] [-i file] [-o file] [archive]\n",
+		 name);
+}
+
+static int
+parse_long(const char *str, long min, long max, long *result) {
+  char *remaining;
+  errno = 0;
+  *result = strtol(str, &remaining, 0);
+  return errno != 0 || *remaining != '\0' || *result < min || *result > max;
+}
+
+static int
+parse_game_type(const char *str, game_type *type) {
+  if (!strcmp(str, "color"))
+	*type = GAME_TYPE_COLOR;
+  else if (!strcmp(str, "grand"))
+	*type = GAME_TYPE_GRAND;
+  else if (!strcmp(str, "null"))
+	*type = GAME_TYPE_NULL;
+  else
+	return 1;
+  return 0;
+}
+
+static int
+command_tablebase(int argc, char **argv) {
+  int opt;
+  long stiche = TABLEBASE_MAX_STICHE, threads = 1;
+  game_type type = GAME_TYPE_GRAND;
+  char *out = NULL;
+  uint64_t entries;
+
+  while ((opt = getopt(argc, argv, "g:n:j:o:")) != -1) {
+	switch (opt) {
+	  case 'g':
+		if (!parse_game_type(optarg, &type))
+		  break;
+		printf("Invalid game type: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'n':
+		if (!parse_long(optarg, 1, TABLEBASE_MAX_STICHE, &stiche))
+		  break;
+		printf("Invalid number of stiche: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'j':
+		if (!parse_long(optarg, 1, TABLEBASE_MAX_THREADS, &threads))
+		  break;
+		printf("Invalid number of threads: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'o':
+		out = optarg;
+		break;
+	  default:
+		return EXIT_FAILURE;
+	}
+  }
+
+  if (!out) {
+	printf("Missing output file\n");
+	return EXIT_FAILURE;
+  }
+
+  tablebase_entries(type, stiche, &entries);
+  printf("Generating %llu entries for the last %ld stiche into '%s'\n",
+		 (unsigned long long) entries, stiche, out);
+  if (tablebase_generate(out, type, stiche, threads)) {
+	printf("Generating the tablebase failed\n");
+	return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+static int
+command_analyze(int argc, char **argv) {
+  int opt;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN), samples, val;
+  analysis_config conf = {.seed = 0};
+  analysis_totals totals;
+  FILE *in = stdin;
+  char *remaining;
+  int error;
+
+  // All cores by default, a day of games is a batch job
+  if (threads < 1)
+	threads = 1;
+  else if (threads > ANALYSIS_MAX_THREADS)
+	threads = ANALYSIS_MAX_THREADS;
+  samples = ANALYSIS_DEFAULT_SAMPLES;
+
+  while ((opt = getopt(argc, argv, "j:n:s:")) != -1) {
+	switch (opt) {
+	  case 'j':
+		if (!parse_long(optarg, 1, ANALYSIS_MAX_THREADS, &threads))
+		  break;
+		printf("Invalid number of threads: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'n':
+		if (!parse_long(optarg, 0, 100000, &samples))
+		  break;
+		printf("Invalid number of samples: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 's':
+		errno = 0;
+		conf.seed = strtoull(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0')
+		  break;
+		printf("Invalid seed: %s\n", optarg);
+		return EXIT_FAILURE;
+	  default:
+		return EXIT_FAILURE;
+	}
+  }
+
+  // Reads from stdin without an archive, so archives can be piped in
+  if (optind < argc && !(in = fopen(argv[optind], "r"))) {
+	printf("Could not open archive '%s'\n", argv[optind]);
+	return EXIT_FAILURE;
+  }
+
+  conf.threads = (int) threads;
+  conf.samples = (uint32_t) samples;
+  error = analysis_run(in, stdout, &conf, &totals);
+  if (in != stdin)
+	fclose(in);
+  if (error) {
+	printf("Analyzing the archive failed\n");
+	return EXIT_FAILURE;
+  }
+
+  val = totals.moves ? (long) totals.moves : 1;
+  printf("# %llu rounds (%llu skipped), %llu moves, mean loss %.2f",
+		 (unsigned long long) totals.rounds,
+		 (unsigned long long) totals.skipped,
+		 (unsigned long long) totals.moves, (double) totals.loss / val);
+  if (conf.samples)
+	printf(", sampled %.2f", totals.loss_sampled / val);
+  printf("\n");
+  return EXIT_SUCCESS;
+}
+
+static int
+command_eval_train(int argc, char **argv) {
+  int opt;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN), games = EVAL_TRAIN_GAMES;
+  eval_train_config conf = {.seed = 1, .tt_bits = EVAL_TRAIN_TT_BITS};
+  eval_train_stats stats;
+  eval_weights ew;
+  char *out = NULL, *remaining;
+
+  if (threads < 1)
+	threads = 1;
+  else if (threads > THREAD_POOL_MAX_THREADS)
+	threads = THREAD_POOL_MAX_THREADS;
+
+  while ((opt = getopt(argc, argv, "j:n:s:o:")) != -1) {
+	switch (opt) {
+	  case 'j':
+		if (!parse_long(optarg, 1, THREAD_POOL_MAX_THREADS, &threads))
+		  break;
+		printf("Invalid number of threads: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'n':
+		if (!parse_long(optarg, 1, 100000000, &games))
+		  break;
+		printf("Invalid number of games: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 's':
+		errno = 0;
+		conf.seed = strtoull(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0')
+		  break;
+		printf("Invalid seed: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'o':
+		out = optarg;
+		break;
+	  default:
+		return EXIT_FAILURE;
+	}
+  }
+
+  if (!out) {
+	printf("Missing output file\n");
+	return EXIT_FAILURE;
+  }
+
+  conf.threads = (int) threads;
+  conf.games = (uint32_t) games;
+  printf("Fitting the evaluation to %ld self play games\n", games);
+  if (eval_train(&conf, &ew, &stats) || eval_write_file(out, &ew)) {
+	printf("Training the evaluation failed\n");
+	return EXIT_FAILURE;
+  }
+  printf("# color: %llu positions, rms error %.2f points\n"
+		 "# grand: %llu positions, rms error %.2f points\n",
+		 (unsigned long long) stats.positions[0], stats.rms_error[0],
+		 (unsigned long long) stats.positions[1], stats.rms_error[1]);
+  return EXIT_SUCCESS;
+}
+
+// name[:eval_stiche[:max_samples]], players with equal settings share an
+// engine
+static int
+parse_tournament_player(char *spec, const bot_config *base,
+						tournament_config *conf, tournament_player *pl) {
+  char *stiche = strchr(spec, ':'), *samples = NULL;
+  bot_config bc = *base;
+  long val;
+
+  if (stiche) {
+	*stiche++ = '\0';
+	if ((samples = strchr(stiche, ':')))
+	  *samples++ = '\0';
+	if (parse_long(stiche, 0, 10, &val))
+	  return 1;
+	bc.eval_stiche = (uint8_t) val;
+  }
+  if (samples) {
+	if (parse_long(samples, 0, 100000, &val))
+	  return 1;
+	bc.max_samples = (uint32_t) val;
+  }
+  if (!*spec || strlen(spec) >= sizeof(pl->name))
+	return 1;
+  strcpy(pl->name, spec);
+
+  for (pl->engine = 0; pl->engine < conf->engine_count; pl->engine++)
+	if (conf->engines[pl->engine].eval_stiche == bc.eval_stiche
+		&& conf->engines[pl->engine].max_samples == bc.max_samples)
+	  return 0;
+  if (conf->engine_count == TOURNAMENT_MAX_ENGINES)
+	return 1;
+  conf->engines[conf->engine_count++] = bc;
+  return 0;
+}
+
+static int
+command_tournament(int argc, char **argv) {
+  int opt;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN), val;
+  tournament_config conf = {.series = 1,
+							.games = TOURNAMENT_SERIES_GAMES,
+							.seed = 1};
+  tournament t = {.conf = &conf};
+  bot_config bc = {.threads = 1,
+				   .move_millis = TOURNAMENT_MOVE_MILLIS,
+				   .eval_stiche = BOT_DEFAULT_EVAL_STICHE};
+  tablebase tablebases[3];
+  char *remaining;
+  int error;
+
+  if (threads < 1)
+	threads = 1;
+  else if (threads > THREAD_POOL_MAX_THREADS)
+	threads = THREAD_POOL_MAX_THREADS;
+
+  while ((opt = getopt(argc, argv, "j:r:g:s:t:dT:")) != -1) {
+	switch (opt) {
+	  case 'j':
+		if (!parse_long(optarg, 1, THREAD_POOL_MAX_THREADS, &threads))
+		  break;
+		printf("Invalid number of threads: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'r':
+		if (!parse_long(optarg, 1, 1000, &val)) {
+		  conf.series = (uint32_t) val;
+		  break;
+		}
+		printf("Invalid number of series: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'g':
+		if (!parse_long(optarg, 1, 10000, &val)) {
+		  conf.games = (uint32_t) val;
+		  break;
+		}
+		printf("Invalid number of games: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 's':
+		errno = 0;
+		conf.seed = strtoull(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0')
+		  break;
+		printf("Invalid seed: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 't':
+		if (!parse_long(optarg, 1, 600000, &val)) {
+		  bc.move_millis = (uint64_t) val;
+		  break;
+		}
+		printf("Invalid time per move: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'd':
+		conf.duplicate = 1;
+		break;
+	  case 'T':
+		if (bc.tablebases_length < 3
+			&& !tablebase_open(&tablebases[bc.tablebases_length], optarg)) {
+		  bc.tablebases = tablebases;
+		  bc.tablebases_length++;
+		  break;
+		}
+		printf("Could not open tablebase '%s'\n", optarg);
+		return EXIT_FAILURE;
+	  default:
+		return EXIT_FAILURE;
+	}
+  }
+
+  t.player_count = argc - optind;
+  if (t.player_count < 3 || t.player_count % 3
+	  || t.player_count > TOURNAMENT_MAX_PLAYERS) {
+	printf("Need a multiple of three players, at most %d\n",
+		   TOURNAMENT_MAX_PLAYERS);
+	return EXIT_FAILURE;
+  }
+  if (!(t.players = calloc(t.player_count, sizeof(*t.players))))
+	return EXIT_FAILURE;
+
+  for (int i = 0; i < t.player_count; i++) {
+	if (parse_tournament_player(argv[optind + i], &bc, &conf,
+								&t.players[i])) {
+	  printf("Invalid player: %s\n", argv[optind + i]);
+	  free(t.players);
+	  return EXIT_FAILURE;
+	}
+	for (int j = 0; j < i; j++)
+	  if (!strcmp(t.players[j].name, t.players[i].name)) {
+		printf("Duplicate player: %s\n", t.players[i].name);
+		free(t.players);
+		return EXIT_FAILURE;
+	  }
+  }
+
+  conf.threads = (int) threads;
+  printf("Playing %u series of %u games at %d tables with %d engines%s\n",
+		 conf.series, conf.games, t.player_count / 3, conf.engine_count,
+		 conf.duplicate ? ", every deal three times" : "");
+  error = tournament_run(&t, stdout);
+  free(t.players);
+  if (error) {
+	printf("Running the tournament failed\n");
+	return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// Feeds the queue with simulated arrivals, ratings around 1500 and ticks
+// every 100 ms of simulated time
+static int
+command_matchmaking(int argc, char **argv) {
+  int opt;
+  long players = 100000, val;
+  double rate = 200;
+  uint64_t seed = 1, now = 0, next_tick = 0, next_arrival = 0;
+  matchmaking mm;
+  matchmaking_match m[64];
+  uint32_t ticket;
+  struct timespec start, end;
+  char *remaining;
+  rng r;
+
+  while ((opt = getopt(argc, argv, "n:a:s:")) != -1) {
+	switch (opt) {
+	  case 'n':
+		if (!parse_long(optarg, 3, 100000000, &players))
+		  break;
+		printf("Invalid number of players: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'a':
+		if (!parse_long(optarg, 1, 10000000, &val)) {
+		  rate = (double) val;
+		  break;
+		}
+		printf("Invalid arrival rate: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 's':
+		errno = 0;
+		seed = strtoull(optarg, &remaining, 0);
+		if (errno == 0 && *remaining == '\0')
+		  break;
+		printf("Invalid seed: %s\n", optarg);
+		return EXIT_FAILURE;
+	  default:
+		return EXIT_FAILURE;
+	}
+  }
+
+  if (matchmaking_init(&mm, (uint32_t) players)) {
+	printf("Could not allocate the queue\n");
+	return EXIT_FAILURE;
+  }
+  rng_seed(&r, seed);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (long p = 0; p < players;) {
+	if (next_tick <= next_arrival) {
+	  now = next_tick;
+	  next_tick += 100;
+	  while (matchmaking_tick(&mm, now, m, 64) == 64)
+		;
+	  continue;
+	}
+	now = next_arrival;
+	val = 900 + (long) rng_bounded_u32(&r, 400) + rng_bounded_u32(&r, 400)
+		  + rng_bounded_u32(&r, 400);
+	matchmaking_join(&mm, (uint32_t) p++, (int) val, now, &ticket, m);
+	// Exponential gaps, a Poisson process of arrivals
+	next_arrival += (uint64_t) (-log((rng_next_u32(&r) + 1.0) / 4294967296.0)
+								* 1000.0 / rate);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  printf("# %ld players in %.1f simulated minutes, %llu tables, %u waiting, "
+		 "%.0f ns per player\n",
+		 players, now / 60000.0, (unsigned long long) mm.matches, mm.waiting,
+		 ((end.tv_sec - start.tv_sec) * 1e9 + end.tv_nsec - start.tv_nsec)
+				 / players);
+  matchmaking_histogram_print(&mm.queue_length, "queue length", stdout);
+  matchmaking_histogram_print(&mm.match_millis, "millis to match", stdout);
+  matchmaking_free(&mm);
+  return EXIT_SUCCESS;
+}
+
+// Recomputes the ratings from an archive, or reads them with -i, and prints
+// the leaderboard
+static int
+command_ratings(int argc, char **argv) {
+  int opt;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN), top = 20;
+  char *in_file = NULL, *out_file = NULL;
+  rating_table t;
+  uint32_t *indices, n;
+  uint64_t skipped = 0;
+  FILE *in = stdin;
+  int error;
+
+  if (threads < 1)
+	threads = 1;
+  else if (threads > THREAD_POOL_MAX_THREADS)
+	threads = THREAD_POOL_MAX_THREADS;
+
+  while ((opt = getopt(argc, argv, "j:k:i:o:")) != -1) {
+	switch (opt) {
+	  case 'j':
+		if (!parse_long(optarg, 1, THREAD_POOL_MAX_THREADS, &threads))
+		  break;
+		printf("Invalid number of threads: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'k':
+		if (!parse_long(optarg, 1, 1000000, &top))
+		  break;
+		printf("Invalid number of players: %s\n", optarg);
+		return EXIT_FAILURE;
+	  case 'i':
+		in_file = optarg;
+		break;
+	  case 'o':
+		out_file = optarg;
+		break;
+	  default:
+		return EXIT_FAILURE;
+	}
+  }
+
+  if (rating_init(&t))
+	return EXIT_FAILURE;
+  if (in_file) {
+	error = rating_read_file(&t, in_file);
+  } else {
+	if (optind < argc && !(in = fopen(argv[optind], "r"))) {
+	  printf("Could not open archive '%s'\n", argv[optind]);
+	  rating_free(&t);
+	  return EXIT_FAILURE;
+	}
+	error = rating_recompute(&t, in, (int) threads, &skipped);
+	if (in != stdin)
+	  fclose(in);
+  }
+  if (error || (out_file && rating_write_file(&t, out_file))) {
+	printf("Rating the players failed\n");
+	rating_free(&t);
+	return EXIT_FAILURE;
+  }
+
+  if (!(indices = malloc(top * sizeof(*indices)))) {
+	rating_free(&t);
+	return EXIT_FAILURE;
+  }
+  n = rating_top(&t, (uint32_t) top, indices);
+  printf("# %u players, %llu rounds skipped\n"
+		 "#  rank name                 rating games  won lost\n",
+		 t.count, (unsigned long long) skipped);
+  for (uint32_t i = 0; i < n; i++) {
+	rating_player *p = &t.players[indices[i]];
+	printf("%6u %-20s %6.0f %5u %4u %4u\n", i + 1, p->name, p->rating,
+		   p->games, p->won, p->lost);
+  }
+  free(indices);
+  rating_free(&t);
+  return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char **argv) {
+  if (argc < 2) {
+	print_usage(argv[0]);
+	exit(EXIT_FAILURE);
+  }
+
+  // Subcommands parse their own options
+  if (!strcmp(argv[1], "tablebase"))
+	return command_tablebase(argc - 1, argv + 1);
+  if (!strcmp(argv[1], "analyze"))
+	return command_analyze(argc - 1, argv + 1);
+  if (!strcmp(argv[1], "eval-train"))
+	return command_eval_train(argc - 1, argv + 1);
+  if (!strcmp(argv[1], "tournament"))
+	return command_tournament(argc - 1, argv + 1);
+  if (!strcmp(argv[1], "matchmaking"))
+	return command_matchmaking(argc - 1, argv + 1);
+  if (!strcmp(argv[1], "ratings"))
+	return command_ratings(argc - 1, argv + 1);
+
+  print_usage(argv[0]);
+  exit(EXIT_FAILURE);
+}
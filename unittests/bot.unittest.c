@@ -0,0 +1,58 @@
+#include "skat/bot.h"
+#include "unittest.h"
+#include <string.h>
+
+// The bot won the bidding at 18 as Vorhand and is asked about the skat
+static int
+test_skat_action(bot *b, const card_collection hand, action *a) {
+  skat_client_state cs;
+
+  memset(&cs, '\0', sizeof(cs));
+  client_skat_state_init(&cs);
+  cs.sgs.cgphase = GAME_PHASE_SKAT_AUFNEHMEN;
+  cs.sgs.rs.reizwert = 18;
+  cs.sgs.alleinspieler = 0;
+  cs.my_active_player_index = 0;
+  cs.ist_alleinspieler = 1;
+  cs.my_hand = hand;
+  return bot_decide(b, &cs, a);
+}
+
+// A hand that wins Grand without the skat is worth the Hand multiplier, a
+// hand that just reaches 18 needs the skat
+static void
+test_hand_game(void) {
+  const bot_config conf = {.threads = 1, .move_millis = 1000, .seed = 7};
+  const card_collection buben =
+		  CARD(0, TYPE_BIT_BUBE) | CARD(1, TYPE_BIT_BUBE)
+		  | CARD(2, TYPE_BIT_BUBE) | CARD(3, TYPE_BIT_BUBE);
+  bot b;
+  action a;
+
+  CHECK(!bot_init(&b, &conf));
+  CHECK(!test_skat_action(&b,
+						  buben | CARD(0, TYPE_BIT_ASS)
+								  | CARD(1, TYPE_BIT_ASS)
+								  | CARD(2, TYPE_BIT_ASS)
+								  | CARD(3, TYPE_BIT_ASS)
+								  | CARD(3, TYPE_BIT_ZEHN)
+								  | CARD(2, TYPE_BIT_ZEHN),
+						  &a));
+  CHECK(a.type == ACTION_SKAT_LEAVE);
+
+  CHECK(!test_skat_action(&b,
+						  CARD(3, TYPE_BIT_BUBE) | CARD(3, TYPE_BIT_ASS)
+								  | CARD(3, TYPE_BIT_DAME) | CARD(3, TYPE_BIT_9)
+								  | CARD(3, TYPE_BIT_8) | CARD(2, TYPE_BIT_ASS)
+								  | CARD(1, TYPE_BIT_7) | CARD(1, TYPE_BIT_8)
+								  | CARD(0, TYPE_BIT_7) | CARD(0, TYPE_BIT_9),
+						  &a));
+  CHECK(a.type == ACTION_SKAT_TAKE);
+  bot_free(&b);
+}
+
+int
+main(void) {
+  test_hand_game();
+  return unittest_failures != 0;
+}
@@ -0,0 +1,65 @@
+#include "skat/server.h"
+#include "unittest.h"
+#include <string.h>
+
+#define TEST_ROUNDS (8)
+
+static int
+test_trackers_equal(const card_tracker *a, const card_tracker *b) {
+  return a->me == b->me
+		 && !memcmp(a->possible, b->possible, sizeof(a->possible))
+		 && !memcmp(a->played, b->played, sizeof(a->played))
+		 && !memcmp(a->voids, b->voids, sizeof(a->voids)) && a->skat == b->skat
+		 && a->alleinspieler_points == b->alleinspieler_points
+		 && a->alleinspieler_stiche == b->alleinspieler_stiche;
+}
+
+// After every action of a round, a seat that resyncs has to know as much
+// about the cards as the seat that saw every event
+static void
+test_resync_tracker(void) {
+  static server s;
+  const bot_config conf = {.threads = 1,
+						   .move_millis = 100,
+						   .max_samples = 4,
+						   .eval_stiche = 2,
+						   .seed = 11};
+  static const char *const names[3] = {"a", "b", "c"};
+  static bot bots[3];
+  bot *seats[4] = {&bots[0], &bots[1], &bots[2], NULL};
+  skat_client_state cs;
+  int checked = 0;
+
+  server_init_headless(&s);
+  server_skat_state_seed_deals(&s.ss, 21);
+  for (int i = 0; i < 3; i++) {
+	CHECK(!bot_init(&bots[i], &conf));
+	CHECK(!server_bots_add(&s, names[i]));
+  }
+
+  while (s.ss.rounds_finished < TEST_ROUNDS) {
+	if (server_bots_step(&s, seats)) {
+	  CHECK(0);
+	  break;
+	}
+	if (s.ss.sgs.cgphase == GAME_PHASE_SETUP
+		|| s.ss.sgs.cgphase == GAME_PHASE_BETWEEN_ROUNDS)
+	  continue;
+	for (int i = 0; i < 3; i++) {
+	  skat_resync_player(&s.ss, &cs, s.pls[i]);
+	  CHECK(test_trackers_equal(&cs.tracker, &s.bots.seats[i].cs.tracker));
+	  checked++;
+	}
+  }
+  CHECK(checked > 0);
+
+  server_free_headless(&s);
+  for (int i = 0; i < 3; i++)
+	bot_free(&bots[i]);
+}
+
+int
+main(void) {
+  test_resync_tracker();
+  return unittest_failures != 0;
+}
@@ -0,0 +1,131 @@
+#include "skat/deal.h"
+#include "skat/rng.h"
+#include "unittest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_DEALS (2000)
+
+static int
+test_same_deal(const deal *a, const deal *b) {
+  return a->hands[0] == b->hands[0] && a->hands[1] == b->hands[1]
+		 && a->hands[2] == b->hands[2] && a->skat == b->skat;
+}
+
+// Every deal comes back from its rank and its text, the ranks stay in range
+static void
+test_round_trip(void) {
+  char text[DEAL_TEXT_LENGTH + 1];
+  uint64_t rank, back;
+  deal d, e;
+  rng r;
+
+  rng_seed(&r, 3);
+  for (int i = 0; i < TEST_DEALS; i++) {
+	deal_random(&d, &r);
+	CHECK(!deal_to_rank(&d, &rank));
+	CHECK(rank < DEAL_RANK_COUNT);
+	CHECK(!deal_from_rank(rank, &e));
+	CHECK(test_same_deal(&d, &e));
+
+	CHECK(!deal_to_text(&d, text));
+	CHECK(strlen(text) == DEAL_TEXT_LENGTH);
+	CHECK(!deal_from_text(text, &e));
+	CHECK(test_same_deal(&d, &e));
+  }
+
+  // The first and the last rank
+  for (int i = 0; i < 2; i++) {
+	rank = i ? DEAL_RANK_COUNT - 1 : 0;
+	CHECK(!deal_from_rank(rank, &d));
+	CHECK(deal_is_valid(&d));
+	CHECK(!deal_to_rank(&d, &back));
+	CHECK(back == rank);
+  }
+
+  // Subsets of the cards that are left, as the ranks of the hands use them
+  for (int i = 0; i < TEST_DEALS; i++) {
+	deal_random(&d, &r);
+	card_collection from = ~d.hands[0];
+	uint64_t sub = deal_subset_rank(d.hands[1], from);
+	CHECK(sub < deal_binomial(22, 10));
+	CHECK(deal_subset_unrank(sub, 10, from) == d.hands[1]);
+  }
+}
+
+// Crockford's aliases and lower case read the same as the digits
+static void
+test_text_aliases(void) {
+  deal d, e;
+
+  CHECK(!deal_from_text("0113456789A", &d));
+  CHECK(!deal_from_text("oiL3456789a", &e));
+  CHECK(test_same_deal(&d, &e));
+}
+
+static void
+test_invalid(void) {
+  char text[DEAL_TEXT_LENGTH + 1];
+  deal d, e;
+  rng r;
+
+  rng_seed(&r, 5);
+  deal_random(&d, &r);
+  e = d;
+  e.skat = 0;
+  CHECK(deal_to_rank(&e, &(uint64_t){0}));
+  CHECK(deal_to_text(&e, text));
+  e = d;
+  e.hands[0] ^= e.skat & -e.skat;// a card twice
+  CHECK(deal_to_rank(&e, &(uint64_t){0}));
+  CHECK(deal_from_rank(DEAL_RANK_COUNT, &e));
+
+  CHECK(deal_from_text("0123456789U", &e) == 1);// no digit
+  CHECK(deal_from_text("01234", &e) == 1);      // too short
+  CHECK(deal_from_text("0123456789AB", &e) == 2);
+  CHECK(deal_from_text("ZZZZZZZZZZZ", &e) == 3);// rank out of range
+  CHECK(deal_text_digit_value('U') == -1);
+}
+
+// Replay files skip blank lines and comments and reject the whole file for
+// one bad deal
+static void
+test_read_file(void) {
+  char path[] = "/tmp/skat_deal_unittestXXXXXX", text[DEAL_TEXT_LENGTH + 1];
+  deal d, *deals = NULL;
+  size_t length = 0;
+  FILE *f;
+  int fd;
+  rng r;
+
+  rng_seed(&r, 9);
+  deal_random(&d, &r);
+  deal_to_text(&d, text);
+  CHECK((fd = mkstemp(path)) >= 0);
+  CHECK((f = fdopen(fd, "w")));
+  fprintf(f, "# replay\n\n%s\n%s \r\n", text, text);
+  fclose(f);
+  CHECK(!deal_read_file(path, &deals, &length));
+  CHECK(length == 2);
+  CHECK(deals && test_same_deal(&deals[0], &d)
+		&& test_same_deal(&deals[1], &d));
+  free(deals);
+
+  CHECK((f = fopen(path, "a")));
+  fprintf(f, "0123456789U\n");
+  fclose(f);
+  CHECK(deal_read_file(path, &deals, &length) == 2);
+  unlink(path);
+  CHECK(deal_read_file(path, &deals, &length) == 1);
+}
+
+int
+main(void) {
+  test_round_trip();
+  test_text_aliases();
+  test_invalid();
+  test_read_file();
+  return unittest_failures != 0;
+}
@@ -0,0 +1,33 @@
+#include "skat/deal.h"
+#include "skat/hand_eval.h"
+#include "unittest.h"
+
+#define TEST_HANDS (1000)
+
+// The batch has to agree with one hand at a time, for every game and for
+// lengths that do not fill the last vector
+static void
+test_margins_match(void) {
+  static card_collection hands[TEST_HANDS];
+  static int margins[TEST_HANDS];
+  deal d;
+  rng r;
+
+  rng_seed(&r, 9);
+  for (int i = 0; i < TEST_HANDS; i++) {
+	deal_random(&d, &r);
+	hands[i] = d.hands[i % 3];
+  }
+  for (int g = 0; g < HAND_EVAL_GAMES; g++) {
+	const game_rules *gr = &hand_eval_games[g];
+	CHECK(!hand_eval_margins(gr, hands, TEST_HANDS - g, margins));
+	for (int i = 0; i < TEST_HANDS - g; i++)
+	  CHECK(margins[i] == hand_eval_margin(hands[i], gr));
+  }
+}
+
+int
+main(void) {
+  test_margins_match();
+  return unittest_failures != 0;
+}
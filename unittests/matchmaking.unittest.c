@@ -0,0 +1,76 @@
+#include "skat/matchmaking.h"
+#include "unittest.h"
+
+#define TEST_RATING(bucket) ((bucket) * MATCHMAKING_BUCKET_WIDTH + 50)
+
+// Three players of one bucket make a table in join order, one who left
+// does not
+static void
+test_join_leave(void) {
+  matchmaking_match m;
+  matchmaking mm;
+  uint32_t ticket[3];
+
+  CHECK(!matchmaking_init(&mm, 8));
+  CHECK(!matchmaking_join(&mm, 1, TEST_RATING(10), 0, &ticket[0], &m));
+  CHECK(!matchmaking_join(&mm, 2, TEST_RATING(10), 10, &ticket[1], &m));
+  CHECK(!matchmaking_leave(&mm, ticket[0]));
+  CHECK(matchmaking_leave(&mm, ticket[0]));
+  CHECK(!matchmaking_join(&mm, 3, TEST_RATING(10), 20, &ticket[2], &m));
+  CHECK(mm.waiting == 2);
+
+  CHECK(matchmaking_join(&mm, 4, TEST_RATING(10), 30, &ticket[0], &m) == 1);
+  CHECK(ticket[0] == MATCHMAKING_NONE);
+  CHECK(m.players[0] == 2 && m.players[1] == 3 && m.players[2] == 4);
+  CHECK(!mm.waiting && mm.matches == 1);
+  CHECK(matchmaking_leave(&mm, ticket[1]));
+  matchmaking_free(&mm);
+}
+
+// Neighbouring buckets meet once their windows reach each other
+static void
+test_widening(void) {
+  matchmaking_match m[4];
+  matchmaking mm;
+  uint32_t ticket;
+
+  CHECK(!matchmaking_init(&mm, 8));
+  CHECK(!matchmaking_join(&mm, 1, TEST_RATING(10), 0, &ticket, m));
+  CHECK(!matchmaking_join(&mm, 2, TEST_RATING(12), 0, &ticket, m));
+  CHECK(!matchmaking_join(&mm, 3, TEST_RATING(11), 0, &ticket, m));
+  CHECK(!matchmaking_tick(&mm, MATCHMAKING_WIDEN_MILLIS, m, 4));
+  CHECK(matchmaking_tick(&mm, 2 * MATCHMAKING_WIDEN_MILLIS, m, 4) == 1);
+  CHECK(!mm.waiting);
+  matchmaking_free(&mm);
+}
+
+// A newcomer joins a player who waited long enough for its bucket, but two
+// newcomers of different buckets never share a table
+static void
+test_newcomers(void) {
+  const uint64_t late = MATCHMAKING_BUCKETS * MATCHMAKING_WIDEN_MILLIS;
+  matchmaking_match m[4];
+  matchmaking mm;
+  uint32_t ticket;
+
+  CHECK(!matchmaking_init(&mm, 8));
+  CHECK(!matchmaking_join(&mm, 1, TEST_RATING(0), 0, &ticket, m));
+  CHECK(!matchmaking_tick(&mm, late, m, 4));
+  CHECK(!matchmaking_join(&mm, 2, TEST_RATING(30), late, &ticket, m));
+  CHECK(!matchmaking_join(&mm, 3, TEST_RATING(35), late, &ticket, m));
+  CHECK(mm.waiting == 3);
+
+  CHECK(matchmaking_join(&mm, 4, TEST_RATING(30), late + 1, &ticket, m) == 1);
+  CHECK(m[0].players[0] == 1 && m[0].players[1] == 2
+		&& m[0].players[2] == 4);
+  CHECK(mm.waiting == 1);
+  matchmaking_free(&mm);
+}
+
+int
+main(void) {
+  test_join_leave();
+  test_widening();
+  test_newcomers();
+  return unittest_failures != 0;
+}
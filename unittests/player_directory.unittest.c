@@ -0,0 +1,153 @@
+#include "skat/player_directory.h"
+#include "skat/rng.h"
+#include "unittest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_CAPACITY (64)
+#define TEST_LIMIT    (TEST_CAPACITY / 4 * 3)
+#define TEST_NAMES    (2000)
+
+static player_directory_entry *
+test_intern(player_directory *d, int n, int64_t last_seen) {
+  player_directory_entry *e;
+  char name[16];
+
+  snprintf(name, sizeof(name), "p%d", n);
+  if (player_directory_intern(d, name, strlen(name), &e))
+	return NULL;
+  e->last_seen = last_seen;
+  return e;
+}
+
+static player_directory_entry *
+test_find(player_directory *d, int n) {
+  char name[16];
+
+  snprintf(name, sizeof(name), "p%d", n);
+  return player_directory_find(d, name, strlen(name));
+}
+
+// A full directory makes room by evicting the player seen least recently
+// that has no seat, everybody else keeps its id and stays where find and get
+// reach them
+static void
+test_evict_stale(void) {
+  int64_t seen[TEST_NAMES];
+  uint32_t ids[TEST_NAMES];
+  player_directory_entry *e;
+  player_directory d;
+  int victim, known;
+  rng r;
+
+  CHECK(!player_directory_open(&d, NULL, TEST_CAPACITY));
+  rng_seed(&r, 11);
+  for (int n = 0; n < TEST_NAMES; n++) {
+	seen[n] = -1;
+	victim = -1;
+	known = 0;
+	for (int i = 0; i < n; i++)
+	  if (seen[i] >= 0 && ++known && i >= 4
+		  && (victim < 0 || seen[i] < seen[victim]))
+		victim = i;
+
+	CHECK((e = test_intern(&d, n, rng_bounded_u32(&r, 1u << 30))));
+	if (!e)
+	  break;
+	seen[n] = e->last_seen;
+	ids[n] = e->id;
+	// The first names are seated, however stale they are
+	if (n < 4)
+	  e->gupid = n;
+	if (known == TEST_LIMIT) {
+	  CHECK(!test_find(&d, victim));
+	  seen[victim] = -1;
+	}
+	CHECK(d.header->count == (uint32_t) (known < TEST_LIMIT ? known + 1
+															  : TEST_LIMIT));
+
+	for (int i = 0; i <= n; i++) {
+	  if (seen[i] < 0)
+		continue;
+	  CHECK((e = test_find(&d, i)));
+	  if (!e)
+		continue;
+	  CHECK(e->last_seen == seen[i]);
+	  CHECK(e->gupid == (i < 4 ? i : -1));
+	  CHECK(e->id == ids[i]);
+	  CHECK(player_directory_get(&d, e->id) == e);
+	}
+  }
+  player_directory_close(&d);
+}
+
+// With every player seated nobody can be evicted and interning fails
+static void
+test_full_of_seats(void) {
+  player_directory_entry *e;
+  player_directory d;
+  uint32_t id;
+
+  CHECK(!player_directory_open(&d, NULL, 4));
+  for (int n = 0; n < 3; n++) {
+	CHECK((e = test_intern(&d, n, n)));
+	if (e)
+	  e->gupid = n;
+  }
+  CHECK(!test_intern(&d, 3, 3));
+  CHECK(d.header->count == 3);
+
+  // A seat that is given up makes room again, its id goes to the newcomer
+  e = test_find(&d, 1);
+  id = e->id;
+  e->gupid = -1;
+  CHECK((e = test_intern(&d, 3, 3)));
+  CHECK(e && e->id == id);
+  CHECK(!test_find(&d, 1));
+  CHECK(test_find(&d, 0) && test_find(&d, 2) && test_find(&d, 3));
+  player_directory_close(&d);
+}
+
+// Ids survive mapping the file again, seats do not
+static void
+test_reopen(void) {
+  char path[] = "/tmp/skat_player_directory_unittestXXXXXX";
+  player_directory_entry *e;
+  uint32_t ids[TEST_LIMIT];
+  player_directory d;
+  int fd;
+
+  CHECK((fd = mkstemp(path)) >= 0);
+  close(fd);
+  unlink(path);
+  CHECK(!player_directory_open(&d, path, TEST_CAPACITY));
+  for (int n = 0; n < TEST_LIMIT; n++) {
+	CHECK((e = test_intern(&d, n, n)));
+	ids[n] = e ? e->id : 0;
+	if (e)
+	  e->gupid = n % 4;
+  }
+  player_directory_close(&d);
+
+  CHECK(!player_directory_open(&d, path, 2));
+  CHECK(d.header->capacity == TEST_CAPACITY);
+  for (int n = 0; n < TEST_LIMIT; n++) {
+	CHECK((e = player_directory_get(&d, ids[n])));
+	if (!e)
+	  continue;
+	CHECK(e == test_find(&d, n));
+	CHECK(e->last_seen == n && e->gupid == -1);
+  }
+  player_directory_close(&d);
+  unlink(path);
+}
+
+int
+main(void) {
+  test_evict_stale();
+  test_full_of_seats();
+  test_reopen();
+  return unittest_failures != 0;
+}
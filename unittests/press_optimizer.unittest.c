@@ -0,0 +1,112 @@
+#include "skat/hand_eval.h"
+#include "skat/press_optimizer.h"
+#include "skat/sampler.h"
+#include "unittest.h"
+
+#define TEST_DEALS (16)
+
+// How many of the deals the option wins, solved to the end
+static int
+test_wins(solver *sv, const card_collection cards, const press_option *o,
+		  const deal deals[TEST_DEALS]) {
+  solver_position pos = {.gr = o->gr,
+						 .alleinspieler = 0,
+						 .curr_stich = {.vorhand = 0, .winner = -1}};
+  unsigned int points;
+  int wins = 0, won;
+
+  card_collection_get_score(&o->press, &points);
+  pos.alleinspieler_points = o->gr.type == GAME_TYPE_NULL ? 0 : points;
+  pos.hands[0] = cards & ~o->press;
+  for (int d = 0; d < TEST_DEALS; d++) {
+	pos.hands[1] = deals[d].hands[1];
+	pos.hands[2] = deals[d].hands[2];
+	if (solver_reaches(sv, &pos, 61, &won))
+	  return -1;
+	wins += won;
+  }
+  return wins;
+}
+
+// On hands where the game and the press are obvious, the ranking must not
+// end up below the choice of hand evaluation
+static void
+test_not_worse_than_hand_eval(const card_collection cards) {
+  press_option options[PRESS_OPTIMIZER_OPTIONS], fallback = {0};
+  press_query q = {.cards = cards,
+				   .alleinspieler = 0,
+				   .reizwert = 18,
+				   .millis = 60000,
+				   .max_samples = PRESS_OPTIMIZER_MIN_RANKED,
+				   .eval_stiche = 2};
+  deal deals[TEST_DEALS];
+  card_collection skat;
+  thread_pool tp;
+  solver sv;
+  sampler s;
+  size_t length;
+  int found = 0;
+  rng r;
+
+  CHECK(!thread_pool_init(&tp, 1, "test"));
+  CHECK(!solver_init(&sv, 16));
+  rng_seed(&r, 3);
+  CHECK(!press_optimize(&tp, &sv, &r, &q, options, &length));
+  CHECK(length > 0 && length <= PRESS_OPTIMIZER_OPTIONS);
+
+  hand_eval_choose_game(cards, 1, 0, q.reizwert, &fallback.gr,
+						&fallback.press);
+  for (size_t i = 0; i < length; i++)
+	found += options[i].fallback && options[i].press == fallback.press
+			 && options[i].gr.type == fallback.gr.type
+			 && options[i].gr.trumpf == fallback.gr.trumpf;
+  CHECK(found == 1);
+  CHECK(options[0].fallback
+		|| options[0].samples >= PRESS_OPTIMIZER_MIN_RANKED);
+
+  skat = cards & -cards;
+  skat |= (cards & ~skat) & -(cards & ~skat);
+  sampler_init(&s);
+  CHECK(!sampler_set_known(&s, 0, cards & ~skat));
+  CHECK(!sampler_set_known(&s, SAMPLER_SKAT, skat));
+  CHECK(!sampler_prepare(&s));
+  rng_seed(&r, 4);
+  for (int d = 0; d < TEST_DEALS; d++)
+	CHECK(!sampler_draw(&s, &r, &deals[d]));
+  sampler_free(&s);
+
+  CHECK(test_wins(&sv, cards, &options[0], deals)
+		>= test_wins(&sv, cards, &fallback, deals));
+
+  solver_free(&sv);
+  thread_pool_free(&tp);
+}
+
+int
+main(void) {
+  const card_collection buben =
+		  CARD(0, TYPE_BIT_BUBE) | CARD(1, TYPE_BIT_BUBE)
+		  | CARD(2, TYPE_BIT_BUBE) | CARD(3, TYPE_BIT_BUBE);
+
+  // Grand with every Bube and Asse, two Karo to press
+  test_not_worse_than_hand_eval(
+		  buben | CARD(3, TYPE_BIT_ASS) | CARD(3, TYPE_BIT_ZEHN)
+		  | CARD(3, TYPE_BIT_KOENIG) | CARD(2, TYPE_BIT_ASS)
+		  | CARD(2, TYPE_BIT_ZEHN) | CARD(1, TYPE_BIT_ASS) | CARD(0, TYPE_BIT_7)
+		  | CARD(0, TYPE_BIT_8));
+  // Kreuz with eight trumpf
+  test_not_worse_than_hand_eval(
+		  CARD(3, TYPE_BIT_BUBE) | CARD(2, TYPE_BIT_BUBE)
+		  | CARD(3, TYPE_BIT_ASS) | CARD(3, TYPE_BIT_ZEHN)
+		  | CARD(3, TYPE_BIT_KOENIG) | CARD(3, TYPE_BIT_DAME)
+		  | CARD(3, TYPE_BIT_9) | CARD(3, TYPE_BIT_8) | CARD(1, TYPE_BIT_ASS)
+		  | CARD(2, TYPE_BIT_7) | CARD(0, TYPE_BIT_7) | CARD(0, TYPE_BIT_8));
+  // Null with the two Asse to press
+  test_not_worse_than_hand_eval(
+		  CARD(0, TYPE_BIT_7) | CARD(0, TYPE_BIT_8) | CARD(0, TYPE_BIT_9)
+		  | CARD(1, TYPE_BIT_7) | CARD(1, TYPE_BIT_8) | CARD(1, TYPE_BIT_9)
+		  | CARD(2, TYPE_BIT_7)
+		  | CARD(2, TYPE_BIT_8) | CARD(2, TYPE_BIT_9) | CARD(3, TYPE_BIT_7)
+		  | CARD(3, TYPE_BIT_ASS) | CARD(1, TYPE_BIT_ASS));
+  return unittest_failures != 0;
+}
@@ -0,0 +1,59 @@
+#include "skat/rating.h"
+#include "skat/rng.h"
+#include "unittest.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_PLAYERS (300)
+#define TEST_GAMES   (5000)
+#define TEST_TOP     (25)
+
+// Ranks and the top players have to agree with counting everyone
+static void
+test_leaderboard(void) {
+  uint32_t top[TEST_TOP], n, rank;
+  const char *names[3];
+  char buf[3][16];
+  rating_table t;
+  int as, won;
+  rng r;
+
+  CHECK(!rating_init(&t));
+  rng_seed(&r, 7);
+  for (int g = 0; g < TEST_GAMES; g++) {
+	for (int p = 0; p < 3; p++) {
+	  snprintf(buf[p], sizeof(buf[p]), "p%u",
+			   rng_bounded_u32(&r, TEST_PLAYERS));
+	  names[p] = buf[p];
+	}
+	if (!strcmp(names[0], names[1]) || !strcmp(names[0], names[2])
+		|| !strcmp(names[1], names[2]))
+	  continue;
+	as = (int) rng_bounded_u32(&r, 3);
+	// Some players are much stronger, so the bins fill unevenly
+	won = (int) rng_bounded_u32(&r, 100) < 50 + 4 * (names[as][1] - '0');
+	CHECK(!rating_update(&t, names, as, won));
+  }
+
+  for (uint32_t i = 0; i < t.count; i++) {
+	rank = 1;
+	for (uint32_t j = 0; j < t.count; j++)
+	  rank += t.players[j].rating > t.players[i].rating;
+	CHECK(rating_rank(&t, i) == rank);
+  }
+
+  n = rating_top(&t, TEST_TOP, top);
+  CHECK(n == TEST_TOP);
+  for (uint32_t i = 0; i < n; i++) {
+	CHECK(rating_rank(&t, top[i]) <= i + 1);
+	if (i)
+	  CHECK(t.players[top[i - 1]].rating >= t.players[top[i]].rating);
+  }
+  rating_free(&t);
+}
+
+int
+main(void) {
+  test_leaderboard();
+  return unittest_failures != 0;
+}
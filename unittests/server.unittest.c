@@ -0,0 +1,50 @@
+#include "skat/server.h"
+#include "unittest.h"
+#include <string.h>
+
+// The snapshot must be readable while no tick runs, otherwise the
+// prefilter lets everything through on an idle server
+static void
+test_prefilter_idle(void) {
+  static server s;
+  action play = {.type = ACTION_PLAY_CARD};
+
+  server_init_headless(&s);
+  CHECK(!(s.snap.generation & 1));
+  CHECK(server_prefilter_action(&s, 0, &play));
+
+  server_tick(&s);
+  CHECK(!(s.snap.generation & 1));
+  CHECK(server_prefilter_action(&s, 0, &play));
+  server_free_headless(&s);
+}
+
+// Joining a server whose directory is full of seated players fails instead
+// of seating somebody without an entry
+static void
+test_join_directory_full(void) {
+  static server s;
+
+  server_init_headless(&s);
+  player_directory_close(&s.dir);
+  CHECK(!player_directory_open(&s.dir, NULL, 4));
+  CHECK(!server_add_player_for_connection(&s, "a", 0));
+  CHECK(!server_add_player_for_connection(&s, "b", 1));
+  CHECK(!server_add_player_for_connection(&s, "c", 2));
+  CHECK(server_add_player_for_connection(&s, "d", 3));
+  CHECK(!server_is_player_active(&s, 3));
+
+  // Taking over the seat of b frees b's entry for d
+  CHECK(!server_add_player_for_connection(&s, "d", 1));
+  CHECK(!server_has_player_name(&s, "b"));
+  CHECK(server_has_player_name(&s, "d"));
+  CHECK(!strcmp(s.pls[1]->name, "d"));
+  server_free_headless(&s);
+}
+
+int
+main(void) {
+  test_prefilter_idle();
+  test_join_directory_full();
+  return unittest_failures != 0;
+}
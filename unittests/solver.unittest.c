@@ -0,0 +1,156 @@
+#include "skat/deal.h"
+#include "skat/solver.h"
+#include "unittest.h"
+#include <string.h>
+
+#define TEST_POSITIONS (60)
+
+// Values of the rest of the game from brute force: the minimax value and the
+// best and the worst line for the alleinspieler. Card points at the end of
+// the game, 1 for a won Null game. The minimax value after every legal card
+// goes to moves by card index if given.
+typedef struct {
+  int minimax, best, worst;
+} test_values;
+
+static int
+test_is_null(const solver_position *pos) {
+  return pos->gr.type == GAME_TYPE_NULL;
+}
+
+static test_values
+test_brute_force(const solver_position *pos, int *moves_value) {
+  card_collection moves;
+  solver_position next;
+  test_values v, child;
+  int ap, maximize;
+
+  if (!pos->curr_stich.played_cards
+	  && !(pos->hands[0] | pos->hands[1] | pos->hands[2])) {
+	int value = test_is_null(pos) ? !pos->alleinspieler_stiche
+								  : pos->alleinspieler_points;
+	return (test_values){value, value, value};
+  }
+
+  CHECK(!solver_position_player(pos, &ap));
+  CHECK(!solver_position_legal_moves(pos, &moves));
+  maximize = ap == pos->alleinspieler;
+  v = (test_values){maximize ? -1 : 1000, -1, 1000};
+  for (; moves; moves &= moves - 1) {
+	next = *pos;
+	CHECK(!solver_position_play(
+		  &next, card_collection_id_from_index(__builtin_ctz(moves))));
+	child = test_brute_force(&next, NULL);
+	if (moves_value)
+	  moves_value[__builtin_ctz(moves)] = child.minimax;
+	if (maximize ? child.minimax > v.minimax : child.minimax < v.minimax)
+	  v.minimax = child.minimax;
+	if (child.best > v.best)
+	  v.best = child.best;
+	if (child.worst < v.worst)
+	  v.worst = child.worst;
+  }
+  return v;
+}
+
+// n cards of every hand of a random deal, of which up to two random legal
+// ones went into the current stich
+static void
+test_position(solver_position *pos, rng *r, game_type type, int n) {
+  int played = (int) rng_bounded_u32(r, 3);
+  card_collection moves;
+  deal d;
+
+  deal_random(&d, r);
+  memset(pos, '\0', sizeof(*pos));
+  pos->gr.type = type;
+  pos->gr.trumpf =
+	type == GAME_TYPE_COLOR ? 1 + rng_bounded_u32(r, 4) : COLOR_INVALID;
+  pos->alleinspieler = (int) rng_bounded_u32(r, 3);
+  pos->curr_stich =
+	(stich){.vorhand = (int) rng_bounded_u32(r, 3), .winner = -1};
+  pos->alleinspieler_points = card_collection_points(d.skat);
+  for (int p = 0; p < 3; p++) {
+	card_collection h = d.hands[p];
+	for (int i = 0; i < n; i++) {
+	  card_collection c = h;
+	  for (uint32_t j = rng_bounded_u32(r, __builtin_popcount(h)); j; j--)
+		c &= c - 1;
+	  c &= -c;
+	  pos->hands[p] |= c;
+	  h &= ~c;
+	}
+  }
+
+  for (int i = 0; i < played; i++) {
+	int ap;
+	CHECK(!solver_position_player(pos, &ap));
+	CHECK(!solver_position_legal_moves(pos, &moves));
+	for (uint32_t j = rng_bounded_u32(r, __builtin_popcount(moves)); j; j--)
+	  moves &= moves - 1;
+	CHECK(!solver_position_play(
+		  pos, card_collection_id_from_index(__builtin_ctz(moves))));
+  }
+}
+
+// Solves, reaches and line reaches agree with brute force on small
+// positions, and the best card keeps the minimax value
+static void
+test_against_brute_force(game_type type) {
+  solver_position pos;
+  card_collection moves;
+  solver_result res;
+  test_values v;
+  int moves_value[32], result, complete, legal;
+  uint8_t best;
+  solver sv;
+  rng r;
+
+  CHECK(!solver_init(&sv, 14));
+  rng_seed(&r, 11 + type);
+  for (int i = 0; i < TEST_POSITIONS; i++) {
+	test_position(&pos, &r, type, 2 + i % 4);
+	v = test_brute_force(&pos, moves_value);
+
+	CHECK(!solver_solve(&sv, &pos, &res));
+	CHECK(res.complete);
+	if (test_is_null(&pos)) {
+	  CHECK(res.alleinspieler_wins == v.minimax);
+	} else {
+	  CHECK(res.alleinspieler_points == v.minimax);
+	  CHECK(res.alleinspieler_wins == (v.minimax > 60));
+	}
+
+	CHECK(!solver_position_legal_moves(&pos, &moves));
+	CHECK(!card_collection_contains(&moves, &res.best_card, &legal));
+	CHECK(legal);
+	CHECK(!card_collection_index_from_id(&res.best_card, &best));
+	CHECK(legal && moves_value[best] == v.minimax);
+
+	// Null targets are ignored, the question is whether the game is won
+	for (int points = v.minimax; points <= v.minimax + 1; points++) {
+	  int expect = test_is_null(&pos) ? v.minimax : v.minimax >= points;
+	  CHECK(!solver_reaches(&sv, &pos, points, &result));
+	  CHECK(result == expect);
+	}
+
+	for (int every = 0; every < 2; every++) {
+	  int line = every ? v.worst : v.best;
+	  for (int points = line; points <= line + 1; points++) {
+		int expect = test_is_null(&pos) ? line : line >= points;
+		CHECK(!solver_lines_reach_limited(&sv, &pos, points, every, NULL,
+										  &result, &complete));
+		CHECK(complete && result == expect);
+	  }
+	}
+  }
+  solver_free(&sv);
+}
+
+int
+main(void) {
+  test_against_brute_force(GAME_TYPE_COLOR);
+  test_against_brute_force(GAME_TYPE_GRAND);
+  test_against_brute_force(GAME_TYPE_NULL);
+  return unittest_failures != 0;
+}
@@ -0,0 +1,83 @@
+#include "skat/deal.h"
+#include "skat/solver.h"
+#include "skat/tablebase.h"
+#include "unittest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// n random cards of every hand of a random deal
+static void
+test_position(solver_position *pos, rng *r, game_type type, int n) {
+  deal d;
+
+  deal_random(&d, r);
+  memset(pos, '\0', sizeof(*pos));
+  pos->gr.type = type;
+  pos->gr.trumpf =
+	type == GAME_TYPE_COLOR ? 1 + rng_bounded_u32(r, 4) : COLOR_INVALID;
+  for (int p = 0; p < 3; p++) {
+	card_collection h = d.hands[p];
+	for (int i = 0; i < n; i++) {
+	  card_collection c = h;
+	  for (uint32_t j = rng_bounded_u32(r, __builtin_popcount(h)); j; j--)
+		c &= c - 1;
+	  c &= -c;
+	  pos->hands[p] |= c;
+	  h &= ~c;
+	}
+  }
+  pos->alleinspieler = (int) rng_bounded_u32(r, 3);
+  pos->curr_stich =
+	(stich){.vorhand = (int) rng_bounded_u32(r, 3), .winner = -1};
+}
+
+// A solve that probes the table has to agree with one that searches to the
+// end, both on the stiche the table holds and on longer games
+static void
+test_solve_matches(game_type type, uint8_t stiche) {
+  char path[] = "/tmp/skat_tablebase_XXXXXX";
+  solver plain, probing;
+  solver_position pos;
+  solver_result a, b;
+  tablebase tb;
+  rng r;
+  int fd;
+
+  fd = mkstemp(path);
+  CHECK(fd >= 0);
+  if (fd < 0)
+	return;
+  close(fd);
+  CHECK(!tablebase_generate(path, type, stiche, 2));
+  CHECK(!tablebase_open(&tb, path));
+  unlink(path);
+  CHECK(tb.type == type && tb.stiche == stiche);
+  CHECK(!solver_init(&plain, 14));
+  CHECK(!solver_init(&probing, 14));
+  CHECK(!solver_use_tablebase(&probing, &tb));
+
+  rng_seed(&r, 5);
+  for (int i = 0; i < 200; i++) {
+	test_position(&pos, &r, type, stiche + i % 3);
+	solver_clear(&plain);
+	solver_clear(&probing);
+	CHECK(!solver_solve(&plain, &pos, &a));
+	CHECK(!solver_solve(&probing, &pos, &b));
+	CHECK(a.alleinspieler_points == b.alleinspieler_points);
+	CHECK(a.alleinspieler_wins == b.alleinspieler_wins);
+  }
+
+  solver_free(&plain);
+  solver_free(&probing);
+  tablebase_close(&tb);
+}
+
+int
+main(void) {
+  test_solve_matches(GAME_TYPE_GRAND, 1);
+  test_solve_matches(GAME_TYPE_COLOR, 1);
+  test_solve_matches(GAME_TYPE_NULL, 2);
+  return unittest_failures != 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdio.h>
+
+// Reports a failed check and keeps going, main returns unittest_failures
+#define CHECK(cond) \
+  do { \
+	if (!(cond)) { \
+	  fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+			  #cond); \
+	  unittest_failures++; \
+	} \
+  } while (0)
+
+// One card as a card_collection bit: color 0 (Karo) to 3 (Kreuz) and one of
+// the TYPE_BIT_* card types
+#define CARD(color, type) (0b1u << (8 * (color) + (type)))
+#define TYPE_BIT_7        (0)
+#define TYPE_BIT_8        (1)
+#define TYPE_BIT_9        (2)
+#define TYPE_BIT_DAME     (3)
+#define TYPE_BIT_KOENIG   (4)
+#define TYPE_BIT_ZEHN     (5)
+#define TYPE_BIT_ASS      (6)
+#define TYPE_BIT_BUBE     (7)
+
+static int unittest_failures;